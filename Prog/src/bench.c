@@ -0,0 +1,616 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <Quadtree.h>
+#include <codage.h>
+#include <decodage.h>
+#include <filtrage.h>
+#include <image.h>
+#include <segmentation.h>
+#include <tiled.h>
+
+
+/**
+ * Version du format de sortie (à changer si les clés des lignes changent).
+ */
+#define BENCH_FORMAT 1
+
+/**
+ * Durée minimale de mesure d'un noyau, en secondes (au moins MIN_KERNEL_RUNS passages).
+ */
+#define KERNEL_BUDGET 0.2
+#define MIN_KERNEL_RUNS 3
+#define MAX_KERNEL_RUNS 1000
+
+/**
+ * Nombre maximal de valeurs d'alpha (-a).
+ */
+#define MAX_ALPHAS 16
+
+
+/**
+ * @brief Temps des étapes d'un encodage ou d'un décodage, en secondes.
+ */
+typedef struct {
+    double read;        // projection et lecture de l'en-tête
+    double fill;        // construction de l'arbre (encodage) ou décodage du flux
+    double filter;      // variances et filtrage (codage avec perte)
+    double prune;       // élagage de l'arbre
+    double encode;      // codage du flux
+    double reconstruct; // peinture de l'image (décodage)
+    double write;       // fermeture de la sortie
+    double total;
+} StageTimes;
+
+
+/**
+ * @brief Renvoie le temps écoulé sur l'horloge monotone, en secondes.
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ * @brief Remet à zéro le pic de mémoire résidente du processus (Linux, sans effet ailleurs).
+ */
+static void resetPeakRSS(void) {
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (!f) return;
+    fputs("5", f);
+    fclose(f);
+}
+
+
+/**
+ * @brief Renvoie le pic de mémoire résidente depuis la dernière remise à zéro, en Kio.
+ */
+static long peakRSS(void) {
+    FILE* f = fopen("/proc/self/status", "r");
+    char line[256];
+    long kb = -1;
+    while (f && fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmHWM: %ld", &kb) == 1) break;
+    }
+    if (f) fclose(f);
+    if (kb < 0) { // pas de /proc : pic depuis le démarrage du processus
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        kb = usage.ru_maxrss;
+    }
+    return kb;
+}
+
+
+/**
+ * @brief Garde le minimum de chaque étape (mesure la plus stable d'une série de passages).
+ */
+static void keepBest(StageTimes* best, const StageTimes* t, int first) {
+    if (first) {
+        *best = *t;
+        return;
+    }
+    double* b = (double*)best;
+    const double* v = (const double*)t;
+    for (size_t i = 0; i < sizeof(StageTimes) / sizeof(double); i++) {
+        if (v[i] < b[i]) b[i] = v[i];
+    }
+}
+
+
+/**
+ * @brief Renvoie le nom de base d'un chemin.
+ */
+static const char* baseName(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+
+/**
+ * @brief Construit le nom d'un fichier dans les résultats : répertoire et nom de base.
+ */
+static void fileLabel(char* label, size_t capacity, const char* directory, const char* path) {
+    snprintf(label, capacity, "%s/%s", baseName(directory), baseName(path));
+}
+
+
+/**
+ * @brief Compare deux noms de fichiers (tri par qsort).
+ */
+static int compareNames(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+
+/**
+ * @brief Liste les fichiers d'un répertoire ayant l'extension donnée, triés par nom.
+ *
+ * @return Le nombre de fichiers (tableau à libérer par freeNames), -1 en cas d'erreur.
+ */
+static int listFiles(const char* directory, const char* extension, char*** names) {
+    DIR* dir = opendir(directory);
+    if (!dir) return -1;
+
+    int count = 0, capacity = 0;
+    size_t extLength = strlen(extension);
+    *names = NULL;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (length <= extLength || strcmp(entry->d_name + length - extLength, extension) != 0) continue;
+        if (count == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            char** bigger = (char**)realloc(*names, capacity * sizeof(char*));
+            if (!bigger) break;
+            *names = bigger;
+        }
+        size_t size = strlen(directory) + length + 2;
+        char* path = (char*)malloc(size);
+        if (!path) break;
+        snprintf(path, size, "%s/%s", directory, entry->d_name);
+        (*names)[count++] = path;
+    }
+    closedir(dir);
+
+    if (count) qsort(*names, count, sizeof(char*), compareNames);
+    return count;
+}
+
+
+/**
+ * @brief Libère un tableau de noms renvoyé par listFiles.
+ */
+static void freeNames(char** names, int count) {
+    for (int i = 0; i < count; i++) free(names[i]);
+    free(names);
+}
+
+
+/**
+ * @brief Encode un fichier PGM au format Q1 en mesurant chaque étape (comme le codec, sans threads).
+ *
+ * @param inputFile Fichier PGM.
+ * @param outputFile Fichier QTC temporaire.
+ * @param alpha Facteur de filtrage (<= 0 : sans perte).
+ * @param t Pointeur où stocker les temps des étapes.
+ * @param pixels Pointeur où stocker le nombre de pixels.
+ * @param bytesOut Pointeur où stocker la taille du flux en octets (octet de profondeur compris).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchEncode(const char* inputFile, const char* outputFile, double alpha, StageTimes* t,
+                       size_t* pixels, size_t* bytesOut) {
+    memset(t, 0, sizeof(*t));
+    double start = now(), mark = start;
+
+    int width, height, maxval;
+    size_t dataSizePGM;
+    MappedFile input;
+    uint8_t* data = mapPGMFile(inputFile, &input, &width, &height, &maxval, &dataSizePGM);
+    if (!data) return -1;
+    t->read = now() - mark;
+    mark = now();
+
+    int depth = calculateDepth(width > height ? width : height);
+    QuadTree* tree = createQuadTreeOverImage(depth, data, width);
+    if (!tree || setImageSize(tree, width, height) != 0 || (alpha > 0 && allocVariance(tree, 0) != 0)) {
+        if (tree) freeQuadTree(tree);
+        closeMappedFile(&input);
+        return -1;
+    }
+    fillQuadTree(tree, data, width, height, depth, 0, 0, 0, 1 << depth);
+    t->fill = now() - mark;
+    mark = now();
+
+    if (alpha > 0) {
+        double medvar, maxvar;
+        avgAndMaxVars(tree, &medvar, &maxvar);
+        filtrageParallel(tree, medvar / maxvar, alpha, NULL);
+        t->filter = now() - mark;
+        mark = now();
+    }
+
+    int pruned = pruneQuadTree(tree);
+    closeMappedFile(&input);
+    if (pruned != 0) {
+        freeQuadTree(tree);
+        return -1;
+    }
+    t->prune = now() - mark;
+    mark = now();
+
+    FILE* output = fopen(outputFile, "wb");
+    if (!output) {
+        freeQuadTree(tree);
+        return -1;
+    }
+    uint8_t taille = (uint8_t)depth;
+    fwrite(&taille, sizeof(uint8_t), 1, output);
+    size_t bits = 0;
+    encoderQuadTree(output, tree, &bits);
+    freeQuadTree(tree);
+    t->encode = now() - mark;
+    mark = now();
+
+    int status = fclose(output);
+    t->write = now() - mark;
+    t->total = now() - start;
+
+    *pixels = (size_t)width * height;
+    *bytesOut = 1 + (bits + 7) / 8;
+    return status == 0 ? 0 : -1;
+}
+
+
+/**
+ * @brief Décode un fichier QTC (Q1 à Q4) en mesurant chaque étape (sans threads).
+ *
+ * @param inputFile Fichier QTC.
+ * @param outputFile Fichier PGM temporaire.
+ * @param t Pointeur où stocker les temps des étapes.
+ * @param pixels Pointeur où stocker le nombre de pixels.
+ * @param bytesIn Pointeur où stocker la taille des données binaires en octets.
+ * @param format Pointeur où stocker la version du format.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchDecode(const char* inputFile, const char* outputFile, StageTimes* t,
+                       size_t* pixels, size_t* bytesIn, int* format) {
+    memset(t, 0, sizeof(*t));
+    double start = now(), mark = start;
+
+    int taille, width, height;
+    size_t dataSize;
+    MappedFile input;
+    const uint8_t* data = mapQTCFile(inputFile, &input, &taille, &width, &height, &dataSize, format);
+    if (!data) return -1;
+    t->read = now() - mark;
+    mark = now();
+
+    MappedFile output;
+    int status = 0;
+    if (*format == 3) { // décodage et peinture tuile par tuile : une seule étape
+        uint8_t* image = createPGMFile(outputFile, &output, width, height, 255);
+        TiledStats stats;
+        status = image ? decoderQuadTreeTiled(data, dataSize, width, height, taille, image, NULL, NULL, &stats) : -1;
+        closeMappedFile(&input);
+        t->fill = now() - mark;
+        if (!image) return -1;
+    } else if (*format != 2) { // flux unique : décodage et peinture niveau par niveau
+        uint8_t* image = createPGMFile(outputFile, &output, width, height, 255);
+        DecodeStats stats;
+        status = image ? decodeQTCImage(data, dataSize, *format, width, height, taille, taille, image, NULL, &stats) : -1;
+        closeMappedFile(&input);
+        t->fill = now() - mark;
+        if (!image) return -1;
+    } else {
+        QuadTree* tree = createSparseQuadTree(taille);
+        if (!tree || setImageSize(tree, width, height) != 0) {
+            if (tree) freeQuadTree(tree);
+            closeMappedFile(&input);
+            return -1;
+        }
+        size_t indexBytes;
+        status = fillQuadTreeFromQTCIndexed(data, dataSize, tree, NULL, &indexBytes);
+        closeMappedFile(&input);
+        t->fill = now() - mark;
+        mark = now();
+
+        uint8_t* image = status == 0 ? createPGMFile(outputFile, &output, width, height, 255) : NULL;
+        if (!image) {
+            freeQuadTree(tree);
+            return -1;
+        }
+        createDataFromTreeParallel(tree, image, NULL, width, height, NULL);
+        freeQuadTree(tree);
+        t->reconstruct = now() - mark;
+    }
+    mark = now();
+
+    if (closeMappedFile(&output) != 0) status = -1;
+    t->write = now() - mark;
+    t->total = now() - start;
+
+    *pixels = (size_t)width * height;
+    *bytesIn = dataSize;
+    return status;
+}
+
+
+/**
+ * @brief Affiche les temps des étapes (en millisecondes) d'une ligne de résultat.
+ */
+static void printStages(const StageTimes* t) {
+    printf("\"read_ms\":%.3f,\"fill_ms\":%.3f,\"filter_ms\":%.3f,\"prune_ms\":%.3f,\"encode_ms\":%.3f,"
+           "\"reconstruct_ms\":%.3f,\"write_ms\":%.3f,\"total_ms\":%.3f",
+           t->read * 1e3, t->fill * 1e3, t->filter * 1e3, t->prune * 1e3, t->encode * 1e3,
+           t->reconstruct * 1e3, t->write * 1e3, t->total * 1e3);
+}
+
+
+/**
+ * @brief Compare deux durées (tri par qsort).
+ */
+static int compareTimes(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief Affiche la ligne de résultat d'un noyau mesuré sur plusieurs passages.
+ *
+ * @param kernel Nom du noyau.
+ * @param file Fichier d'origine de l'image.
+ * @param times Durées des passages (triées par cette fonction).
+ * @param runs Nombre de passages.
+ * @param bytes Octets traités par passage (pixels de l'image).
+ */
+static void printKernel(const char* kernel, const char* file, double* times, int runs, size_t bytes) {
+    qsort(times, runs, sizeof(double), compareTimes);
+    printf("{\"bench\":\"kernel\",\"kernel\":\"%s\",\"file\":\"%s\",\"runs\":%d,\"best_ms\":%.4f,\"median_ms\":%.4f,"
+           "\"mbps\":%.2f}\n", kernel, file, runs, times[0] * 1e3, times[runs / 2] * 1e3, bytes / times[0] / 1e6);
+}
+
+
+/**
+ * Répète une instruction jusqu'à KERNEL_BUDGET secondes (entre MIN_KERNEL_RUNS et
+ * MAX_KERNEL_RUNS passages) en notant la durée de chaque passage dans `times`.
+ */
+#define TIME_KERNEL(times, runs, setup, body)                                   \
+    do {                                                                        \
+        double begin = now();                                                   \
+        for (runs = 0; runs < MAX_KERNEL_RUNS &&                                \
+             (runs < MIN_KERNEL_RUNS || now() - begin < KERNEL_BUDGET); runs++) { \
+            setup;                                                              \
+            double t0 = now();                                                  \
+            body;                                                               \
+            times[runs] = now() - t0;                                           \
+        }                                                                       \
+    } while (0)
+
+
+/**
+ * @brief Mesure les noyaux de la bibliothèque sur une image PGM (codage sans perte).
+ *
+ * fillQuadTree, encoderQuadTree, fillQuadTreeFromQTC, createDataFromTree (en ordre Z et par bandes),
+ * decodeQTCImage et generateSegmentationGrid sont mesurés seuls, hors lecture et écriture des fichiers.
+ *
+ * @param inputFile Fichier PGM.
+ * @param name Nom du fichier dans les résultats.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchKernels(const char* inputFile, const char* name) {
+    int width, height, maxval;
+    size_t dataSizePGM;
+    MappedFile input;
+    uint8_t* data = mapPGMFile(inputFile, &input, &width, &height, &maxval, &dataSizePGM);
+    if (!data) return -1;
+
+    size_t pixels = (size_t)width * height;
+    int depth = calculateDepth(width > height ? width : height);
+    int side = 1 << depth;
+    double* times = (double*)malloc(MAX_KERNEL_RUNS * sizeof(double));
+    QuadTree* tree = createQuadTreeOverImage(depth, data, width);
+    uint8_t* image = (uint8_t*)malloc(pixels);
+    char* stream = NULL;
+    size_t streamSize = 0;
+    FILE* sink = fopen("/dev/null", "wb");
+    FILE* memory = open_memstream(&stream, &streamSize);
+    int status = -1, runs;
+
+    if (!times || !tree || !image || !sink || !memory || setImageSize(tree, width, height) != 0) goto cleanup;
+
+    TIME_KERNEL(times, runs, , fillQuadTree(tree, data, width, height, depth, 0, 0, 0, side));
+    printKernel("fillQuadTree", name, times, runs, pixels);
+
+    if (pruneQuadTree(tree) != 0) goto cleanup;
+    size_t bits;
+    TIME_KERNEL(times, runs, , encoderQuadTree(sink, tree, &bits));
+    printKernel("encoderQuadTree", name, times, runs, pixels);
+
+    encoderQuadTree(memory, tree, &bits);
+    fclose(memory);
+    memory = NULL;
+    freeQuadTree(tree);
+    tree = NULL;
+
+    int decoded = 0;
+    TIME_KERNEL(times, runs, if (tree) freeQuadTree(tree); tree = createSparseQuadTree(depth); setImageSize(tree, width, height),
+                decoded |= fillQuadTreeFromQTC((const uint8_t*)stream, streamSize, tree));
+    if (decoded != 0) goto cleanup;
+    printKernel("fillQuadTreeFromQTC", name, times, runs, pixels);
+
+    TIME_KERNEL(times, runs, , createDataFromTree(tree, image, NULL, width, height, 0, 0, 0, side));
+    printKernel("createDataFromTree", name, times, runs, pixels);
+    if (memcmp(image, data, pixels) != 0) {
+        fprintf(stderr, "Erreur : %s mal reconstruite par le décodeur\n", name);
+        goto cleanup;
+    }
+
+    memset(image, 0, pixels);
+    TIME_KERNEL(times, runs, , createDataFromTreeParallel(tree, image, NULL, width, height, NULL));
+    printKernel("createDataFromTreeParallel", name, times, runs, pixels);
+    if (memcmp(image, data, pixels) != 0) {
+        fprintf(stderr, "Erreur : %s mal reconstruite par bandes\n", name);
+        goto cleanup;
+    }
+
+    DecodeStats stats;
+    memset(image, 0, pixels);
+    TIME_KERNEL(times, runs, , decoded |= decodeQTCImage((const uint8_t*)stream, streamSize, 1, width, height, depth, depth, image, NULL, &stats));
+    printKernel("decodeQTCImage", name, times, runs, pixels);
+    if (decoded != 0 || memcmp(image, data, pixels) != 0) {
+        fprintf(stderr, "Erreur : %s mal reconstruite par le décodage direct\n", name);
+        goto cleanup;
+    }
+
+    TIME_KERNEL(times, runs, memset(image, 255, pixels), generateSegmentationGrid(tree, image, width, height, 0, 0, 0, side));
+    printKernel("generateSegmentationGrid", name, times, runs, pixels);
+    status = 0;
+
+cleanup:
+    if (memory) fclose(memory);
+    if (sink) fclose(sink);
+    if (tree) freeQuadTree(tree);
+    free(stream);
+    free(image);
+    free(times);
+    closeMappedFile(&input);
+    return status;
+}
+
+
+/**
+ * @brief Affiche l'utilisation du programme de mesure.
+ */
+static void printBenchUsage(const char* executable) {
+    printf("Usage: %s [-r <passages>] [-a <alpha,alpha,...>] [-k] <répertoire>...\n", executable);
+    printf("  -r <passages>  Nombre de passages par mesure de bout en bout (par defaut: 3)\n");
+    printf("  -a <liste>     Valeurs d'alpha des encodages avec perte (par defaut: 0.8,1.5,2.5)\n");
+    printf("  -k             Noyaux seulement (sans les mesures de bout en bout)\n");
+    printf("Les fichiers .pgm des répertoires sont encodés, les fichiers .qtc décodés.\n");
+    printf("Une ligne JSON est écrite par mesure sur la sortie standard.\n");
+}
+
+
+/**
+ * @brief Programme de mesure des performances du codec QTC.
+ *
+ * Pour chaque répertoire donné, les images PGM sont encodées sans perte puis avec
+ * chaque valeur d'alpha, et les fichiers QTC sont décodés ; les noyaux de la
+ * bibliothèque sont ensuite mesurés seuls sur chaque image PGM. Chaque mesure est une
+ * ligne JSON (clé "bench" : "encode", "decode" ou "kernel") dont les clés ne changent
+ * pas d'une version à l'autre, pour comparer les résultats entre deux commits. Les
+ * temps sont les minimums sur les passages ; le pic de mémoire résidente est celui du
+ * dernier passage.
+ *
+ * @param argc Nombre d'arguments passés en ligne de commande.
+ * @param argv Tableau des arguments sous forme de chaînes.
+ * @return 0 en cas de succès, une valeur non nulle si une mesure a échoué.
+ */
+int main(int argc, char* argv[]) {
+    int reps = 3, kernelsOnly = 0;
+    double alphas[MAX_ALPHAS + 1] = { 0, 0.8, 1.5, 2.5 };
+    int nbAlphas = 4; // alphas[0] = 0 : sans perte
+    int firstDir = argc;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-k") == 0) kernelsOnly = 1;
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            nbAlphas = 1;
+            for (char* p = argv[++i]; *p && nbAlphas <= MAX_ALPHAS; ) {
+                char* end;
+                double a = strtod(p, &end);
+                if (end == p) break;
+                alphas[nbAlphas++] = a;
+                p = *end == ',' ? end + 1 : end;
+            }
+        } else if (strcmp(argv[i], "-h") == 0) {
+            printBenchUsage(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Option inconnue : %s\n", argv[i]);
+            printBenchUsage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            firstDir = i;
+            break;
+        }
+    }
+    if (firstDir == argc || reps < 1) {
+        printBenchUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char tmpQTC[64], tmpPGM[64];
+    snprintf(tmpQTC, sizeof(tmpQTC), "/tmp/qtcbench.%d.qtc", (int)getpid());
+    snprintf(tmpPGM, sizeof(tmpPGM), "/tmp/qtcbench.%d.pgm", (int)getpid());
+
+    printf("{\"bench\":\"meta\",\"format\":%d,\"reps\":%d,\"alphas\":[", BENCH_FORMAT, reps);
+    for (int a = 0; a < nbAlphas; a++) printf("%s%.2f", a ? "," : "", alphas[a]);
+    printf("]}\n");
+
+    int failures = 0;
+    for (int d = firstDir; d < argc; d++) {
+        char** files;
+        int count = listFiles(argv[d], ".pgm", &files);
+        if (count < 0) {
+            fprintf(stderr, "Erreur : Répertoire %s illisible\n", argv[d]);
+            failures++;
+            continue;
+        }
+        char label[512];
+        for (int f = 0; f < count && !kernelsOnly; f++) {
+            fileLabel(label, sizeof(label), argv[d], files[f]);
+            for (int a = 0; a < nbAlphas; a++) {
+                StageTimes best, t;
+                size_t pixels = 0, bytesOut = 0;
+                int status = 0;
+                for (int r = 0; r < reps && status == 0; r++) {
+                    if (r == reps - 1) resetPeakRSS();
+                    status = benchEncode(files[f], tmpQTC, alphas[a], &t, &pixels, &bytesOut);
+                    keepBest(&best, &t, r == 0);
+                }
+                if (status != 0) {
+                    fprintf(stderr, "Erreur : Encodage de %s échoué\n", files[f]);
+                    failures++;
+                    continue;
+                }
+                printf("{\"bench\":\"encode\",\"file\":\"%s\",\"alpha\":%.2f,\"pixels\":%zu,\"bytes_out\":%zu,"
+                       "\"ratio\":%.4f,\"bpp\":%.4f,\"mbps\":%.2f,\"peak_rss_kb\":%ld,",
+                       label, alphas[a], pixels, bytesOut, (double)pixels / bytesOut,
+                       bytesOut * 8.0 / pixels, pixels / best.total / 1e6, peakRSS());
+                printStages(&best);
+                printf("}\n");
+                fflush(stdout);
+            }
+        }
+        for (int f = 0; f < count; f++) {
+            fileLabel(label, sizeof(label), argv[d], files[f]);
+            if (benchKernels(files[f], label) != 0) {
+                fprintf(stderr, "Erreur : Mesure des noyaux sur %s échouée\n", files[f]);
+                failures++;
+            }
+            fflush(stdout);
+        }
+        freeNames(files, count);
+
+        count = kernelsOnly ? 0 : listFiles(argv[d], ".qtc", &files);
+        for (int f = 0; f < count; f++) {
+            fileLabel(label, sizeof(label), argv[d], files[f]);
+            StageTimes best, t;
+            size_t pixels = 0, bytesIn = 0;
+            int format = 0, status = 0;
+            for (int r = 0; r < reps && status == 0; r++) {
+                if (r == reps - 1) resetPeakRSS();
+                status = benchDecode(files[f], tmpPGM, &t, &pixels, &bytesIn, &format);
+                keepBest(&best, &t, r == 0);
+            }
+            if (status != 0) {
+                fprintf(stderr, "Erreur : Décodage de %s échoué\n", files[f]);
+                failures++;
+                continue;
+            }
+            printf("{\"bench\":\"decode\",\"file\":\"%s\",\"format\":%d,\"pixels\":%zu,\"bytes_in\":%zu,"
+                   "\"ratio\":%.4f,\"bpp\":%.4f,\"mbps\":%.2f,\"peak_rss_kb\":%ld,",
+                   label, format, pixels, bytesIn, (double)pixels / bytesIn,
+                   bytesIn * 8.0 / pixels, pixels / best.total / 1e6, peakRSS());
+            printStages(&best);
+            printf("}\n");
+            fflush(stdout);
+        }
+        if (count > 0) freeNames(files, count);
+    }
+
+    remove(tmpQTC);
+    remove(tmpPGM);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
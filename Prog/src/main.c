@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <qtc.h>
+#include <batch.h>
 
 
 
@@ -19,8 +20,20 @@
  * - `-c` : Encode un fichier au format QTC.
  * - `-u` : Décode un fichier QTC.
  * - `-i <fichier>` : Spécifie le fichier d'entrée.
- * - `-o <fichier>` : Spécifie le fichier de sortie (optionnel).
+ * - `-o <fichier>` : Spécifie le fichier de sortie (optionnel), ou le répertoire des sorties avec -B.
+ * - `-B <source>` : Traite un lot de fichiers (répertoire ou liste de fichiers) à la place de -i.
  * - `-a <valeur>` : Spécifie la valeur d'alpha (optionnel pour l'encodage).
+ * - `-s <octets>` : Encode avec perte en choisissant alpha pour que le fichier tienne dans
+ *   la taille donnée (optionnel, à la place de -a).
+ * - `-b <bpp>` : Comme -s, avec une taille exprimée en bits par pixel (optionnel).
+ * - `-j <threads>` : Nombre de threads pour l'encodage et le décodage (optionnel) ; avec -B,
+ *   nombre de fichiers traités en même temps.
+ * - `-p <niveau>` : Encode au format Q2 indexé par sous-arbres (optionnel).
+ * - `-t <taille>` : Encode au format Q3, par tuiles de la taille donnée (optionnel).
+ * - `-e` : Encode au format Q4, à codage entropique (optionnel).
+ * - `-l <niveau>` : Décode un aperçu réduit, un pixel par bloc du niveau donné (optionnel).
+ * - `-m <fichier>` : Écrit une ligne JSON de mesures par fichier traité (temps par étape,
+ *   compteurs), à la fin du fichier donné ou sur la sortie standard avec `-`.
  * - `-g` : Génère une grille de segmentation.
  * - `-v` : Active le mode bavard.
  * - `-h` : Affiche l'aide.
@@ -32,9 +45,10 @@
 
 
 int main(int argc, char* argv[]) {
-    int isEncode = 0, isDecode = 0, generateGrid = 0, bavard = 0;
-    const char *inputFile = NULL, *outputFile = NULL;
-    double alpha = -1; // Alpha par défaut désactivé
+    int isEncode = 0, isDecode = 0;
+    const char *inputFile = NULL, *outputFile = NULL, *batchSource = NULL, *metricsFile = NULL;
+    QTCOptions options;
+    initQTCOptions(&options); // Alpha par défaut désactivé
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-c") == 0)  isEncode = 1;
@@ -45,11 +59,31 @@ int main(int argc, char* argv[]) {
         
         else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) outputFile = argv[++i];
         
-        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) alpha = atof(argv[++i]);
+        else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) batchSource = argv[++i];
         
-        else if (strcmp(argv[i], "-g") == 0) generateGrid = 1;
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) options.alpha = atof(argv[++i]);
         
-        else if (strcmp(argv[i], "-v") == 0)  bavard = 1;
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) options.targetSize = (size_t)strtoull(argv[++i], NULL, 10);
+        
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) options.targetBpp = atof(argv[++i]);
+        
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) options.nbThreads = atoi(argv[++i]);
+        
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) options.splitLevel = atoi(argv[++i]);
+        
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) options.tileSize = atoi(argv[++i]);
+        
+        else if (strcmp(argv[i], "-e") == 0) options.entropy = 1;
+        
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) options.level = atoi(argv[++i]);
+        
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) metricsFile = argv[++i];
+        
+        else if (strcmp(argv[i], "-g") == 0) options.generateGrid = 1;
+        
+        else if (strcmp(argv[i], "-G") == 0) options.generateSegments = 1;
+        
+        else if (strcmp(argv[i], "-v") == 0)  options.bavard = 1;
         
         else if (strcmp(argv[i], "-h") == 0) {
             printUsage(argv[0]);
@@ -65,18 +99,65 @@ int main(int argc, char* argv[]) {
         printUsage(argv[0]);
         return EXIT_FAILURE;
     }
-    if (!inputFile) {
-        fprintf(stderr, "Erreur : Vous devez specifier un fichier d'entree avec -i.\n");
+    if (inputFile && batchSource) {
+        fprintf(stderr, "Erreur : Les options -i et -B sont incompatibles.\n");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!inputFile && !batchSource) {
+        fprintf(stderr, "Erreur : Vous devez specifier un fichier d'entree avec -i (ou un lot avec -B).\n");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (options.splitLevel >= 0 && options.tileSize > 0) {
+        fprintf(stderr, "Erreur : Les options -p et -t sont incompatibles.\n");
         printUsage(argv[0]);
         return EXIT_FAILURE;
     }
+    if (options.entropy && (options.splitLevel >= 0 || options.tileSize > 0)) {
+        fprintf(stderr, "Erreur : L'option -e est incompatible avec -p et -t.\n");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if ((options.targetSize > 0 || options.targetBpp > 0) && (options.alpha > 0 || (options.targetSize > 0 && options.targetBpp > 0))) {
+        fprintf(stderr, "Erreur : Les options -a, -s et -b sont incompatibles.\n");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if ((options.targetSize > 0 || options.targetBpp > 0) && (options.entropy || options.tileSize > 0)) {
+        fprintf(stderr, "Erreur : Les options -s et -b sont incompatibles avec -e et -t.\n");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (options.level != -1 && (isEncode || options.level < 0)) {
+        fprintf(stderr, "Erreur : L'option -l attend un niveau positif ou nul, au decodage seulement.\n");
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (metricsFile) {
+        options.metrics = strcmp(metricsFile, "-") == 0 ? stdout : fopen(metricsFile, "a");
+        if (!options.metrics) {
+            perror("Erreur lors de l'ouverture du fichier de mesures");
+            return EXIT_FAILURE;
+        }
+    }
+    if (batchSource) {
+        Batch batch;
+        if (createBatch(batchSource, outputFile, isEncode, &batch) != 0) return EXIT_FAILURE;
+        int failed = runBatch(&batch, isEncode, &options);
+        printf("\nLot terminé : %d fichiers traités, %d en échec\n", batch.count - failed, failed);
+        freeBatch(&batch);
+        if (options.metrics && options.metrics != stdout) fclose(options.metrics);
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
     if (!outputFile) {
         outputFile = isEncode ? "out.qtc" : "out.pgm";
     }
     if (isEncode) 
-        handleEncoding(inputFile, outputFile, alpha, generateGrid, bavard);
+        handleEncoding(inputFile, outputFile, &options);
     else if (isDecode) 
-        handleDecoding(inputFile, outputFile, generateGrid, bavard);
+        handleDecoding(inputFile, outputFile, &options);
+    if (options.metrics && options.metrics != stdout) fclose(options.metrics);
     
     return EXIT_SUCCESS;
 }
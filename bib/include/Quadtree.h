@@ -5,35 +5,276 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "threadpool.h"
 
 
 /**
- * @brief Représente un nœud dans un QuadTree.
- * 
- * Cette structure contient les informations nécessaires pour un nœud d'un QuadTree,
- * incluant la moyenne d'intensité, l'uniformité, une erreur de compression et la variance.
+ * Décalage des bits d'uniformité : avec 3 bits de décalage, chaque niveau à partir
+ * du niveau 2 commence sur un octet, et tout groupe de PARALLEL_GROUP nœuds consécutifs
+ * d'un tel niveau (ainsi que leurs descendants) occupe des octets qui lui sont propres.
+ */
+#define UNIFORM_BIT_OFFSET 3
+
+/**
+ * Nombre de sous-arbres consécutifs traités par une même tâche parallèle.
+ */
+#define PARALLEL_GROUP 8
+
+/**
+ * Côté des blocs testés d'un coup à la construction (2^FLAT_BLOCK_DEPTH pixels) : un bloc
+ * dont tous les pixels sont égaux est déclaré uniforme sans construire son sous-arbre.
+ */
+#define FLAT_BLOCK_DEPTH 4
+
+/**
+ * Profondeur maximale d'un QuadTree complet : au-delà, les index de ses nœuds ne
+ * tiennent plus dans un int (voir le codage tuilé pour les images plus grandes).
+ */
+#define MAX_TREE_DEPTH 15
+
+/**
+ * Indicateurs de bord d'un nœud (tableau `border`) : bloc entièrement hors de l'image,
+ * bloc contenant la dernière colonne de l'image, bloc contenant sa dernière ligne.
+ */
+#define BORDER_OUTSIDE 1
+#define BORDER_RIGHT 2
+#define BORDER_BOTTOM 4
+
+
+/**
+ * @brief Sommes des pixels d'un bloc, sur 64 bits : la variance en est déduite sans
+ * erreur d'arrondi (voir getNodeVar).
  */
 typedef struct {
-    uint8_t m;           
-    uint8_t uniform;     // Indique si le bloc est uniforme (1 : oui, 0 : non)
-    uint8_t epsilon;     // Erreur (ou seuil de compression)
-    double var; // variance d'un noeud 
-} QuadTreeNode;
+    uint64_t sum;        // Somme des pixels du bloc dans l'image
+    uint64_t sumSq;      // Somme de leurs carrés
+    uint64_t count;      // Nombre de pixels du bloc dans l'image
+} BlockMoments;
+
 
 /**
  * @brief Représente un QuadTree.
  * 
- * Cette structure contient un tableau de nœuds, la profondeur de l'arbre et 
- * le nombre total de nœuds.
+ * Les nœuds sont stockés en tableaux séparés (structure de tableaux), dans l'ordre
+ * du parcours en largeur : les nœuds d'un même niveau sont contigus et les enfants
+ * du nœud i sont les nœuds 4i+1 à 4i+4 (haut-gauche, haut-droit, bas-droit, bas-gauche).
+ * 
+ * - `m` : moyenne d'intensité, un octet par nœud.
+ * - `epsilon` : erreur (reste de la division de la somme des enfants par 4), un octet par nœud.
+ * - `uniform` : uniformité du bloc, un bit par nœud (décalé de UNIFORM_BIT_OFFSET).
+ * - `moments` : sommes exactes des pixels de chaque bloc et de leurs carrés, uniquement
+ *   allouées pour le codage avec perte (NULL sinon). Seuls les `momentNodes` premiers
+ *   nœuds (les nœuds internes) les stockent : celles d'une feuille se déduisent de `m`.
+ * 
+ * L'arbre couvre un carré de côté 2^depth dont l'image (`width` x `height`) occupe le
+ * coin haut-gauche. Quand elle ne le remplit pas, `border` donne la position de chaque
+ * nœud par rapport au bord de l'image : les blocs hors de l'image sont uniformes et ne
+ * sont ni codés ni visités, et un bloc qui déborde ne tient compte que de ses k enfants
+ * dans l'image (m = somme / k, epsilon = somme % k).
+ * 
+ * Un arbre complet construit sur une image (voir createQuadTreeOverImage) ne stocke pas
+ * ses feuilles : seuls les niveaux 0 à depth-1 sont alloués (`capacity` nœuds), et la
+ * valeur d'une feuille est lue dans `pixels`. L'élagage recopie les feuilles gardées.
+ * 
+ * Un arbre creux (`sparse`) ne stocke que les nœuds codés : la racine, puis les quatre
+ * enfants de chaque nœud interne non uniforme, toujours dans l'ordre du parcours en
+ * largeur (l'ordre du flux QTC). Les enfants du k-ième nœud non uniforme sont alors les
+ * nœuds 4k+1 à 4k+4 ; `rank` donne k à partir des bits d'uniformité.
+ * 
+ * Les champs doivent être lus et écrits à travers les accesseurs ci-dessous.
  */
 typedef struct {
-    QuadTreeNode* nodes; 
+    uint8_t* m;          // Moyennes des blocs
+    uint8_t* epsilon;    // Erreurs (ou seuil de compression)
+    uint8_t* uniform;    // Uniformité des blocs, compactée sur un bit par nœud
+    BlockMoments* moments; // Sommes des blocs (NULL si non allouées)
+    int momentNodes;     // Nombre de nœuds dont les sommes sont stockées
+    uint8_t* border;     // Indicateurs de bord (NULL si l'image remplit le carré)
+    uint32_t* rank;      // Arbre creux : nœuds non uniformes avant chaque mot de 64 bits d'uniformité
+    int* levelFirst;     // Index du premier nœud de chaque niveau (depth + 2 entrées)
     int totalNodes;      
+    int capacity;        // Nombre de nœuds alloués
     int depth;           
+    int width;           // Dimensions de l'image couverte (2^depth par défaut)
+    int height;
+    int sparse;          // 1 si seuls les nœuds codés sont stockés
+    const uint8_t* pixels; // Feuilles implicites : pixels de l'image (NULL si les feuilles sont stockées)
+    int stride;          // Largeur d'une ligne de `pixels`
 
 } QuadTree;
 
 
+/**
+ * Renvoie l'index du premier nœud d'un niveau.
+ * 
+ * @param level Niveau (0 pour la racine).
+ * @return L'index du premier nœud du niveau.
+ */
+static inline int levelStart(int level) {
+    return (int)((((int64_t)1 << (2 * level)) - 1) / 3);
+}
+
+/**
+ * Renvoie la moyenne d'un nœud.
+ */
+static inline uint8_t getNodeM(const QuadTree* tree, int nodeIndex) {
+    return tree->m[nodeIndex];
+}
+
+/**
+ * Modifie la moyenne d'un nœud.
+ */
+static inline void setNodeM(QuadTree* tree, int nodeIndex, uint8_t m) {
+    tree->m[nodeIndex] = m;
+}
+
+/**
+ * Renvoie l'epsilon d'un nœud.
+ */
+static inline uint8_t getNodeEpsilon(const QuadTree* tree, int nodeIndex) {
+    return tree->epsilon[nodeIndex];
+}
+
+/**
+ * Modifie l'epsilon d'un nœud.
+ */
+static inline void setNodeEpsilon(QuadTree* tree, int nodeIndex, uint8_t epsilon) {
+    tree->epsilon[nodeIndex] = epsilon;
+}
+
+/**
+ * Vérifie si un nœud est uniforme.
+ * 
+ * @return 1 si le bloc est uniforme, 0 sinon.
+ */
+static inline uint8_t isUniform(const QuadTree* tree, int nodeIndex) {
+    int bit = nodeIndex + UNIFORM_BIT_OFFSET;
+    return (tree->uniform[bit >> 3] >> (bit & 7)) & 1;
+}
+
+/**
+ * Modifie l'indicateur d'uniformité d'un nœud.
+ */
+static inline void setUniform(QuadTree* tree, int nodeIndex, uint8_t uniform) {
+    int bit = nodeIndex + UNIFORM_BIT_OFFSET;
+    if (uniform) tree->uniform[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+    else tree->uniform[bit >> 3] &= (uint8_t)~(1 << (bit & 7));
+}
+
+/**
+ * Modifie d'un coup l'uniformité des quatre enfants d'un nœud.
+ * 
+ * Grâce à UNIFORM_BIT_OFFSET, les bits des enfants 4p+1 à 4p+4 forment un quartet aligné.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param parentIndex Index du parent.
+ * @param mask Uniformité des enfants (bit k pour l'enfant k).
+ */
+static inline void setChildrenUniform(QuadTree* tree, int parentIndex, uint8_t mask) {
+    int bit = 4 * parentIndex + 1 + UNIFORM_BIT_OFFSET;
+    uint8_t* byte = &tree->uniform[bit >> 3];
+    int shift = bit & 7;
+    *byte = (uint8_t)((*byte & ~(0xF << shift)) | ((mask & 0xF) << shift));
+}
+
+/**
+ * @brief Lit 64 bits d'uniformité (bit k du mot = bit k%8 de l'octet 8w + k/8).
+ */
+static inline uint64_t uniformWord(const QuadTree* tree, int word) {
+    uint64_t w;
+    memcpy(&w, tree->uniform + 8 * (size_t)word, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+}
+
+/**
+ * @brief Nombre de bits à 1 d'un mot (instruction dédiée si elle est disponible).
+ */
+static inline int popcount64(uint64_t x) {
+#ifdef __POPCNT__
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * Renvoie l'index du premier enfant d'un nœud.
+ * 
+ * Arbre complet : 4i+1. Arbre creux : 4k+1, k étant le nombre de nœuds non uniformes
+ * qui précèdent le nœud (l'index des rangs doit être à jour, voir buildRankIndex).
+ * Pour un nœud uniforme, renvoie l'index du premier enfant du nœud non uniforme suivant,
+ * ce qui permet de descendre une plage de nœuds [first, last) d'un niveau.
+ */
+static inline int getChildIndex(const QuadTree* tree, int nodeIndex) {
+    if (!tree->sparse) return 4 * nodeIndex + 1;
+
+    int bit = nodeIndex + UNIFORM_BIT_OFFSET;
+    uint64_t below = (bit & 63) ? ~uniformWord(tree, bit >> 6) << (64 - (bit & 63)) : 0;
+    return 4 * (int)(tree->rank[bit >> 6] + popcount64(below)) + 1;
+}
+
+/**
+ * Renvoie l'uniformité des quatre enfants d'un nœud (bit k pour l'enfant k).
+ */
+static inline uint8_t getChildrenUniform(const QuadTree* tree, int parentIndex) {
+    int bit = 4 * parentIndex + 1 + UNIFORM_BIT_OFFSET;
+    return (tree->uniform[bit >> 3] >> (bit & 7)) & 0xF;
+}
+
+/**
+ * Renvoie les sommes d'un nœud (déduites de sa moyenne pour une feuille sans sommes stockées).
+ */
+static inline BlockMoments getNodeMoments(const QuadTree* tree, int nodeIndex) {
+    if (nodeIndex < tree->momentNodes) return tree->moments[nodeIndex];
+    uint64_t v = tree->m[nodeIndex];
+    BlockMoments leaf = { v, v * v, 1 };
+    return leaf;
+}
+
+/**
+ * Modifie les sommes d'un nœud (sans effet s'il ne les stocke pas).
+ */
+static inline void setNodeMoments(QuadTree* tree, int nodeIndex, BlockMoments moments) {
+    if (nodeIndex < tree->momentNodes) tree->moments[nodeIndex] = moments;
+}
+
+/**
+ * Vérifie si un nœud est hors de l'image.
+ */
+static inline int isOutside(const QuadTree* tree, int nodeIndex) {
+    return tree->border && (tree->border[nodeIndex] & BORDER_OUTSIDE);
+}
+
+/**
+ * Vérifie si un bloc d'un niveau est hors de l'image.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param level Niveau du bloc.
+ * @param bx Colonne du bloc.
+ * @param by Ligne du bloc.
+ * @return 1 si le bloc ne contient aucun pixel de l'image, 0 sinon.
+ */
+static inline int isBlockOutside(const QuadTree* tree, int level, int bx, int by) {
+    int shift = tree->depth - level;
+    return ((int64_t)bx << shift) >= tree->width || ((int64_t)by << shift) >= tree->height;
+}
+
+/**
+ * Nombre de blocs de côté 2^shift nécessaires pour couvrir une longueur (0 si elle est négative).
+ */
+static inline int coveringBlocks(int64_t length, int shift) {
+    return length > 0 ? (int)((length + ((int64_t)1 << shift) - 1) >> shift) : 0;
+}
+
+
 /**
  * Vérifie si un noeud est le quatrième enfant de son parent.
  * 
@@ -53,34 +294,139 @@ int isFourthChild(int index);
 int isLeaf(QuadTree* tree, int nodeIndex);
 
 
+/**
+ * Vérifie si un nœud est l'enfant dont la moyenne se déduit de celle de son parent :
+ * le dernier de ses frères dans l'image (le quatrième si l'image remplit le bloc).
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index du nœud.
+ * @return 1 si la moyenne du nœud n'est pas codée, 0 sinon (toujours pour la racine).
+ */
+int isDerivedChild(const QuadTree* tree, int nodeIndex);
+
+
+/**
+ * Calcule les indicateurs de bord des quatre enfants d'un nœud à partir des siens.
+ * 
+ * @param tree Pointeur vers le QuadTree (dimensions de l'image).
+ * @param level Niveau du nœud.
+ * @param border Indicateurs de bord du nœud (hors de l'image exclu).
+ * @param children Tableau recevant les indicateurs des quatre enfants.
+ * @return Masque des enfants hors de l'image (bit k pour l'enfant k).
+ */
+uint8_t childBorders(const QuadTree* tree, int level, uint8_t border, uint8_t children[4]);
+
+
 /**
  * Calcule la profondeur du QuadTree à partir de la taille de l'image.
  * 
- * @param size Taille de l'image.
- * @return La profondeur calculée.
+ * @param size Taille de l'image (plus grande de ses deux dimensions).
+ * @return La plus petite profondeur dont le carré contient l'image.
  */
 int calculateDepth(int size);
 
 
 /**
- * Récupère le parent d'un noeud donné.
+ * Récupère l'index du parent d'un noeud donné.
  * 
- * @param tree Pointeur vers le QuadTree.
  * @param nodeIndex Index du noeud dont le parent est recherché.
- * @return Pointeur vers le nœud parent, ou NULL sinon.
+ * @return L'index du nœud parent, ou -1 pour la racine.
  */
-QuadTreeNode* getParentNode(QuadTree* tree, int nodeIndex);
+int getParentIndex(int nodeIndex);
 
 
 /**
  * Crée un QuadTree vide avec une profondeur.
  * 
- * @param depth Profondeur du QuadTree.
- * @return Pointeur vers le QuadTree nouvellement créé.
+ * @param depth Profondeur du QuadTree (au plus MAX_TREE_DEPTH).
+ * @return Pointeur vers le QuadTree nouvellement créé, ou NULL en cas d'erreur.
  */
 QuadTree* createQuadTree(int depth);
 
 
+/**
+ * Crée un QuadTree complet dont les feuilles sont les pixels d'une image, sans les stocker.
+ * 
+ * Seuls les niveaux 0 à depth-1 sont alloués (un quart des nœuds) : fillQuadTree n'écrit
+ * pas les feuilles, et pruneQuadTree recopie celles qui sont codées depuis `pixels`, qui
+ * doit rester valide jusque-là. Les feuilles ne doivent pas être lues avant l'élagage.
+ * 
+ * @param depth Profondeur du QuadTree (au plus MAX_TREE_DEPTH).
+ * @param pixels Pixels de l'image (coin haut-gauche du carré de l'arbre).
+ * @param stride Largeur d'une ligne de `pixels`.
+ * @return Pointeur vers le QuadTree nouvellement créé, ou NULL en cas d'erreur.
+ */
+QuadTree* createQuadTreeOverImage(int depth, const uint8_t* pixels, int stride);
+
+
+/**
+ * Crée un QuadTree creux ne contenant que la racine (voir reserveNodes pour l'agrandir).
+ * 
+ * @param depth Profondeur du QuadTree.
+ * @return Pointeur vers le QuadTree nouvellement créé, ou NULL en cas d'erreur.
+ */
+QuadTree* createSparseQuadTree(int depth);
+
+
+/**
+ * Restreint un QuadTree à une image qui ne remplit pas forcément son carré.
+ * 
+ * À appeler juste après la création de l'arbre, avant de le remplir ou de le décoder.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param width Largeur de l'image (entre 1 et 2^depth).
+ * @param height Hauteur de l'image (entre 1 et 2^depth).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int setImageSize(QuadTree* tree, int width, int height);
+
+
+/**
+ * Agrandit un QuadTree creux pour qu'il puisse contenir un nombre de nœuds donné.
+ * 
+ * @param tree Pointeur vers le QuadTree creux.
+ * @param count Nombre de nœuds à pouvoir stocker.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int reserveNodes(QuadTree* tree, int count);
+
+
+/**
+ * Construit l'index des rangs d'un QuadTree creux, après que ses nœuds ont été remplis.
+ * 
+ * @param tree Pointeur vers le QuadTree creux.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int buildRankIndex(QuadTree* tree);
+
+
+/**
+ * Élague un QuadTree complet pour n'en garder que les nœuds codés.
+ * 
+ * Les enfants des nœuds uniformes sont retirés, sur place, et les nœuds restants sont
+ * compactés dans l'ordre du parcours en largeur. Les variances sont libérées (elles ne
+ * servent qu'au filtrage, qui doit donc être fait avant). Les feuilles gardées d'un arbre
+ * créé par createQuadTreeOverImage sont lues dans ses pixels.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int pruneQuadTree(QuadTree* tree);
+
+
+/**
+ * Trouve le nœud qui couvre un bloc d'un niveau : le nœud lui-même, ou, s'il n'est pas
+ * stocké, son ancêtre uniforme le plus proche.
+ * 
+ * @param tree Pointeur vers le QuadTree (index des rangs à jour s'il est creux).
+ * @param level Niveau du bloc.
+ * @param offset Position du bloc dans son niveau (index complet - levelStart(niveau)).
+ * @param nodeLevel Pointeur où stocker le niveau du nœud trouvé.
+ * @return L'index du nœud trouvé.
+ */
+int findNode(const QuadTree* tree, int level, int offset, int* nodeLevel);
+
+
 /**
  * Libère la mémoire associée à un QuadTree.
  * 
@@ -89,12 +435,59 @@ QuadTree* createQuadTree(int depth);
 void freeQuadTree(QuadTree* tree);
 
 
+/**
+ * Renvoie la mémoire allouée pour un QuadTree, en octets.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @return La taille des tableaux du QuadTree et de sa structure.
+ */
+size_t quadTreeBytes(const QuadTree* tree);
+
+
+/**
+ * Compte les nœuds calculés par le remplissage d'un QuadTree complet (voir fillQuadTree) :
+ * les nœuds stockés qui touchent l'image, sauf ceux des blocs uniformes non construits.
+ * 
+ * @param tree Pointeur vers le QuadTree complet, rempli.
+ * @return Le nombre de nœuds calculés.
+ */
+uint64_t filledNodes(const QuadTree* tree);
+
+
+/**
+ * Alloue les sommes des blocs d'un QuadTree (nécessaires uniquement pour le filtrage).
+ * 
+ * Seuls les nœuds internes les stockent, sauf si les feuilles ne sont pas des pixels
+ * (racines des tuiles dans l'arbre des niveaux supérieurs).
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param leaves 1 pour stocker aussi les sommes des feuilles.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int allocVariance(QuadTree* tree, int leaves);
+
+
+/**
+ * Renvoie l'écart type des pixels d'un bloc, calculé à partir de ses sommes.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index du nœud.
+ * @return L'écart type, 0 pour une feuille ou si les sommes ne sont pas allouées.
+ */
+double getNodeVar(const QuadTree* tree, int nodeIndex);
+
+
 /**
  * Remplit le QuadTree avec les données d'une image.
  * 
+ * Seuls les pixels de l'image du QuadTree (voir setImageSize) sont lus. Les nœuds situés
+ * sous un bloc uniforme ne sont pas calculés : seul le bit d'uniformité des nœuds internes
+ * y est mis à 1 (ils ne sont lus ni par le filtrage, ni par l'élagage). Les feuilles d'un
+ * arbre créé par createQuadTreeOverImage ne sont pas écrites.
+ * 
  * @param tree Pointeur vers le QuadTree.
  * @param data Tableau contenant les données de l'image.
- * @param width Largeur de l'image.
+ * @param width Largeur d'une ligne de pixels de `data`.
  * @param height Hauteur de l'image.
  * @param depth Profondeur maximale du QuadTree.
  * @param nodeIndex Index du noeud actuel.
@@ -105,6 +498,67 @@ void freeQuadTree(QuadTree* tree);
 void fillQuadTree(QuadTree* tree, uint8_t* data, int width, int height, int depth, int nodeIndex, int startX, int startY, int size);
 
 
+/**
+ * Choisit le niveau de découpage en sous-arbres pour un traitement parallèle.
+ * 
+ * Le niveau est au moins 2 (voir UNIFORM_BIT_OFFSET) et fournit assez de groupes de
+ * PARALLEL_GROUP sous-arbres pour équilibrer la charge entre les threads.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nbThreads Nombre de threads disponibles.
+ * @return Le niveau de découpage, ou -1 si l'arbre est trop petit pour être découpé.
+ */
+int parallelSplitLevel(const QuadTree* tree, int nbThreads);
+
+
+/**
+ * Calcule les coordonnées du bloc associé à un nœud d'un niveau.
+ * 
+ * @param offset Position du nœud dans son niveau (index - levelStart(niveau)).
+ * @param bx Pointeur où stocker la colonne du bloc.
+ * @param by Pointeur où stocker la ligne du bloc.
+ */
+void blockPosition(int offset, int* bx, int* by);
+
+
+/**
+ * Calcule la position dans son niveau du nœud associé à un bloc (inverse de blockPosition).
+ * 
+ * @param bx Colonne du bloc.
+ * @param by Ligne du bloc.
+ * @return La position du nœud dans son niveau (index - levelStart(niveau)).
+ */
+int blockOffset(int bx, int by);
+
+
+/**
+ * Calcule les niveaux situés au-dessus d'un niveau déjà rempli, à partir des enfants.
+ * 
+ * Les nœuds du niveau donné doivent être remplis (m, epsilon, uniformité et, si elles
+ * sont allouées, variances), comme le fait fillQuadTree.
+ * 
+ * @param tree Pointeur vers le QuadTree complet.
+ * @param level Niveau déjà rempli (ses nœuds sont les enfants du niveau level - 1).
+ */
+void fillUpperLevels(QuadTree* tree, int level);
+
+
+/**
+ * Remplit tout le QuadTree avec les données d'une image, en parallèle.
+ * 
+ * Les sous-arbres du niveau de découpage sont construits par les threads du pool,
+ * puis les niveaux supérieurs sont calculés par le thread appelant. Le résultat est
+ * identique à celui de fillQuadTree.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param data Tableau contenant les données de l'image (dimensions du QuadTree).
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param pool Pool de threads (NULL pour une construction séquentielle).
+ */
+void fillQuadTreeParallel(QuadTree* tree, uint8_t* data, int width, int height, ThreadPool* pool);
+
+
 /**
  * Affiche les informations du QuadTree.
  * 
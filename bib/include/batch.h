@@ -0,0 +1,61 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "qtc.h"
+
+
+/**
+ * @brief Lot de fichiers à encoder ou à décoder.
+ */
+typedef struct {
+    char** inputs;      // Fichiers d'entrée, dans l'ordre de traitement
+    char** outputs;     // Fichiers de sortie correspondants
+    int count;          // Nombre de fichiers
+} Batch;
+
+
+/**
+ * Construit un lot à partir d'un répertoire ou d'une liste de fichiers.
+ *
+ * Un répertoire fournit ses fichiers d'extension ".pgm" (encodage) ou ".qtc"
+ * (décodage), triés par nom. Tout autre fichier est lu comme une liste : un nom de
+ * fichier par ligne, les lignes vides et celles qui commencent par '#' étant ignorées.
+ *
+ * Chaque sortie porte le nom de son entrée, avec l'extension ".qtc" ou ".pgm" ; elle
+ * est placée dans `outputDir` s'il est donné (créé au besoin), à côté de l'entrée sinon.
+ *
+ * @param source Répertoire ou liste de fichiers.
+ * @param outputDir Répertoire des sorties (NULL : celui de chaque entrée).
+ * @param isEncode 1 pour un lot à encoder, 0 pour un lot à décoder.
+ * @param batch Pointeur vers le lot à remplir (à libérer par freeBatch).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int createBatch(const char* source, const char* outputDir, int isEncode, Batch* batch);
+
+
+/**
+ * Libère les noms de fichiers d'un lot.
+ *
+ * @param batch Pointeur vers le lot.
+ */
+void freeBatch(Batch* batch);
+
+
+/**
+ * Encode ou décode tous les fichiers d'un lot.
+ *
+ * Les fichiers sont répartis entre -j threads, chacun traitant un fichier entier à la
+ * fois, séquentiellement et dans l'ordre du lot. Quand un thread prend un fichier,
+ * la lecture de celui qu'il prendra au tour suivant est lancée en arrière-plan ; les
+ * sorties projetées sont écrites sur le disque par le noyau pendant que les fichiers
+ * suivants sont traités. L'échec d'un fichier est signalé sans arrêter le lot.
+ *
+ * @param batch Pointeur vers le lot.
+ * @param isEncode 1 pour encoder, 0 pour décoder.
+ * @param options Options d'encodage ou de décodage, communes à tout le lot.
+ * @return Le nombre de fichiers en échec.
+ */
+int runBatch(const Batch* batch, int isEncode, const QTCOptions* options);
+
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef BITSTREAM_H
+#define BITSTREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+
+/**
+ * @brief Écrivain de flux binaire en mémoire.
+ * 
+ * Les bits sont accumulés dans un registre de 64 bits et vidés par mots de 32 bits
+ * dans un tampon extensible. Les bits sont rangés du poids fort au poids faible,
+ * comme dans le format QTC.
+ */
+typedef struct {
+    uint8_t* data;      // Octets complets déjà écrits
+    size_t size;        // Nombre d'octets écrits dans `data`
+    size_t capacity;    // Capacité de `data` en octets
+    uint64_t acc;       // Accumulateur (les `accBits` bits de poids faible sont valides)
+    int accBits;        // Nombre de bits dans l'accumulateur (toujours < 32 entre deux appels)
+    int error;          // 1 si une allocation a échoué
+} BitWriter;
+
+
+/**
+ * Initialise un écrivain vide.
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ */
+void initBitWriter(BitWriter* writer);
+
+
+/**
+ * Libère le tampon d'un écrivain.
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ */
+void freeBitWriter(BitWriter* writer);
+
+
+/**
+ * Vide 32 bits de l'accumulateur dans le tampon (agrandi si nécessaire).
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ */
+void spillBitWriter(BitWriter* writer);
+
+
+/**
+ * Écrit les `n` bits de poids faible de `value` (n <= 32).
+ * 
+ * Un champ de plusieurs bits (ou un enregistrement complet m/epsilon/uniform) est écrit
+ * en une seule opération.
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ * @param value Valeur à écrire.
+ * @param n Nombre de bits.
+ */
+static inline void writeBits(BitWriter* writer, uint32_t value, int n) {
+    writer->acc = (writer->acc << n) | (value & (uint32_t)((1ULL << n) - 1));
+    writer->accBits += n;
+    if (writer->accBits >= 32) spillBitWriter(writer);
+}
+
+
+/**
+ * Renvoie le nombre de bits écrits.
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ * @return Le nombre total de bits écrits.
+ */
+static inline size_t bitWriterBits(const BitWriter* writer) {
+    return writer->size * 8 + writer->accBits;
+}
+
+
+/**
+ * Complète le dernier octet avec des zéros et vide l'accumulateur.
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ * @return Le nombre d'octets du flux, ou 0 en cas d'erreur (voir `error`).
+ */
+size_t flushBitWriter(BitWriter* writer);
+
+
+/**
+ * Ajoute le flux d'un écrivain à la suite d'un autre, au bit près.
+ * 
+ * @param dst Écrivain de destination.
+ * @param src Écrivain source (non modifié).
+ */
+void appendBitWriter(BitWriter* dst, const BitWriter* src);
+
+
+/**
+ * Écrit un entier de 64 bits en gros-boutiste (positions des index QTC).
+ * 
+ * @param out Tampon recevant les 8 octets.
+ * @param value Valeur à écrire.
+ */
+static inline void putUint64(uint8_t* out, uint64_t value) {
+    for (int i = 7; i >= 0; i--) {
+        out[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+
+/**
+ * Lit un entier de 64 bits gros-boutiste.
+ * 
+ * @param in Tampon contenant les 8 octets.
+ * @return La valeur lue.
+ */
+static inline uint64_t getUint64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value = (value << 8) | in[i];
+    return value;
+}
+
+
+/**
+ * @brief Lecteur de flux binaire en mémoire.
+ * 
+ * Les bits sont chargés par blocs de 8 octets (lecture non alignée) dans un registre
+ * de 64 bits dont les bits valides sont alignés sur le poids fort ; les champs sont
+ * extraits par décalage. Au-delà de la fin du tampon, le lecteur fournit des zéros
+ * (voir bitReaderOverrun).
+ */
+typedef struct {
+    const uint8_t* data;
+    size_t size;        // Taille du tampon en octets
+    size_t pos;         // Prochain octet à charger dans le registre
+    uint64_t bits;      // Registre : les `count` bits de poids fort sont valides
+    int count;          // Nombre de bits valides dans le registre
+} BitReader;
+
+
+/**
+ * Initialise un lecteur sur un tampon.
+ * 
+ * @param reader Pointeur vers le lecteur.
+ * @param data Tampon à lire.
+ * @param size Taille du tampon en octets.
+ */
+void initBitReader(BitReader* reader, const uint8_t* data, size_t size);
+
+
+/**
+ * Positionne un lecteur sur un bit donné du tampon.
+ * 
+ * @param reader Pointeur vers le lecteur.
+ * @param bitOffset Position en bits depuis le début du tampon.
+ */
+void seekBitReader(BitReader* reader, size_t bitOffset);
+
+
+/**
+ * Recharge le registre octet par octet près de la fin du tampon.
+ * 
+ * @param reader Pointeur vers le lecteur.
+ */
+void refillBitReaderSlow(BitReader* reader);
+
+
+/**
+ * Recharge le registre pour qu'il contienne au moins 56 bits.
+ * 
+ * @param reader Pointeur vers le lecteur.
+ */
+static inline void refillBitReader(BitReader* reader) {
+    if (reader->pos + 8 <= reader->size) {
+        uint64_t word;
+        memcpy(&word, reader->data + reader->pos, sizeof(word));
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        reader->bits |= word >> reader->count;
+        reader->pos += (63 - reader->count) >> 3;
+        reader->count |= 56;
+    } else {
+        refillBitReaderSlow(reader);
+    }
+}
+
+
+/**
+ * Renvoie les `n` prochains bits sans les consommer (1 <= n <= count).
+ */
+static inline uint32_t peekBits(const BitReader* reader, int n) {
+    return (uint32_t)(reader->bits >> (64 - n));
+}
+
+
+/**
+ * Consomme `n` bits (n <= count).
+ */
+static inline void skipBits(BitReader* reader, int n) {
+    reader->bits <<= n;
+    reader->count -= n;
+}
+
+
+/**
+ * Lit un champ de `n` bits (1 <= n <= 32).
+ * 
+ * @param reader Pointeur vers le lecteur.
+ * @param n Nombre de bits.
+ * @return La valeur lue.
+ */
+static inline uint32_t readBitField(BitReader* reader, int n) {
+    if (reader->count < n) refillBitReader(reader);
+    uint32_t value = peekBits(reader, n);
+    skipBits(reader, n);
+    return value;
+}
+
+
+/**
+ * Renvoie le nombre de bits consommés depuis le début du tampon.
+ */
+static inline size_t bitReaderPosition(const BitReader* reader) {
+    return reader->pos * 8 - reader->count;
+}
+
+
+/**
+ * Indique si la lecture a dépassé la fin du tampon.
+ * 
+ * @return 1 si des bits au-delà de la fin ont été consommés, 0 sinon.
+ */
+static inline int bitReaderOverrun(const BitReader* reader) {
+    return bitReaderPosition(reader) > reader->size * 8;
+}
+
+
+#endif
@@ -7,6 +7,18 @@
 #include <stdlib.h>
 
 #include "Quadtree.h"
+#include "bitstream.h"
+
+
+/**
+ * @brief Nombre de nœuds et de bits codés par type de champ.
+ */
+typedef struct {
+    uint64_t nodes;         // Nœuds ayant au moins un champ dans le flux
+    uint64_t mBits;         // Bits des moyennes (8 par moyenne)
+    uint64_t epsilonBits;   // Bits des epsilons (2 par nœud interne)
+    uint64_t uniformBits;   // Bits d'uniformité (1 par nœud interne d'epsilon nul)
+} EncodedFields;
 
 
 /**
@@ -26,4 +38,96 @@
 void encoderQuadTree(FILE* file, QuadTree* tree , size_t * bits_de_qtc);
 
 
+/**
+ * @brief Encode un QuadTree dans un fichier, chaque niveau étant découpé en morceaux encodés en parallèle.
+ * 
+ * Les morceaux sont recollés au bit près : le flux écrit est identique à celui de encoderQuadTree.
+ * 
+ * @param file Pointeur vers le fichier où l'arbre sera écrit.
+ * @param tree Pointeur vers le QuadTree à encoder. 
+ * @param bits_de_qtc Pointeur vers une variable de type `size_t` où le nombre total 
+ * de bits utilisés pour l'encodage sera stocké.
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ */
+void encoderQuadTreeParallel(FILE* file, QuadTree* tree, size_t* bits_de_qtc, ThreadPool* pool);
+
+
+/**
+ * @brief Encode un QuadTree au format Q4 : flux unique à codage entropique.
+ * 
+ * Le format Q4 code les mêmes champs que Q1, dans le même ordre de nœuds, avec un codeur
+ * rANS adaptatif (voir entropy.h) : chaque moyenne est codée comme un écart à celle de
+ * son parent, dans un contexte donné par le niveau du nœud et l'écart de ses frères déjà
+ * codés ; epsilon et uniform forment un seul symbole, dans un contexte de niveau. Dans
+ * un groupe de quatre frères, les moyennes précèdent les fins de nœuds.
+ * 
+ * @param file Pointeur vers le fichier où l'arbre sera écrit.
+ * @param tree Pointeur vers le QuadTree élagué à encoder.
+ * @param bits_de_qtc Pointeur vers une variable de type `size_t` où le nombre total 
+ * de bits utilisés pour l'encodage sera stocké.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int encoderQuadTreeEntropy(FILE* file, QuadTree* tree, size_t* bits_de_qtc);
+
+
+/**
+ * @brief Encode une plage de nœuds d'un QuadTree dans un écrivain, avec les règles de Q1.
+ * 
+ * Les nœuds sont codés dans l'ordre de leurs index (parcours en largeur). Les enfants
+ * des nœuds uniformes d'un arbre complet sont sautés ; un arbre creux ne les contient pas.
+ * 
+ * @param tree Pointeur vers le QuadTree à encoder.
+ * @param first Index du premier nœud de la plage.
+ * @param last Index suivant le dernier nœud de la plage.
+ * @param firstLeaf Index du premier nœud codé comme une feuille (m seul) : le premier nœud
+ * du dernier niveau, ou INT_MAX si les nœuds du dernier niveau de l'arbre sont des nœuds
+ * internes de l'image (niveaux supérieurs d'un codage tuilé).
+ * @param out Écrivain recevant les bits.
+ */
+void encoderQuadTreeNodes(QuadTree* tree, int first, int last, int firstLeaf, BitWriter* out);
+
+
+/**
+ * @brief Compte les champs qu'écrirait encoderQuadTree, sans rien écrire.
+ * 
+ * La somme des bits est la taille du flux Q1 (hors alignement final) ; pour le
+ * format Q2, l'index s'y ajoute.
+ * 
+ * @param tree Pointeur vers le QuadTree (complet ou élagué).
+ * @param counts Pointeur vers les compteurs à remplir.
+ */
+void countEncodedFields(const QuadTree* tree, EncodedFields* counts);
+
+
+/**
+ * @brief Compte les bits du flux Q1 d'un QuadTree complet, sans rien écrire.
+ * 
+ * Donne la taille du flux pour une valeur d'alpha sans élaguer l'arbre (voir le
+ * codage à taille visée, options -s et -b).
+ * 
+ * @param tree Pointeur vers le QuadTree complet (non élagué), éventuellement filtré.
+ * @return Le nombre de bits du flux (hors alignement final).
+ */
+uint64_t countQuadTreeBits(const QuadTree* tree);
+
+
+/**
+ * @brief Encode un QuadTree au format Q2 : flux découpé en sous-arbres, précédé d'un index.
+ * 
+ * Après l'octet de profondeur, le fichier contient le niveau de découpage s (1 octet),
+ * puis les 4^s positions en bits (64 bits, gros-boutiste) des sous-flux des nœuds du
+ * niveau s, puis le flux : les niveaux 0 à s comme en Q1, suivis des descendants de
+ * chaque nœud du niveau s. Chaque sous-arbre peut ainsi être décodé indépendamment.
+ * 
+ * @param file Pointeur vers le fichier où l'arbre sera écrit.
+ * @param tree Pointeur vers le QuadTree à encoder.
+ * @param split Niveau de découpage (entre 2 et la profondeur de l'arbre).
+ * @param bits_de_qtc Pointeur où stocker le nombre de bits écrits (index compris).
+ * @param indexBytes Pointeur où stocker la taille de l'index en octets (niveau de découpage compris).
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int encoderQuadTreeIndexed(FILE* file, QuadTree* tree, int split, size_t* bits_de_qtc, size_t* indexBytes, ThreadPool* pool);
+
+
 #endif // __CODAGE__ß
\ No newline at end of file
@@ -6,16 +6,48 @@
 #include <stdint.h>
 
 #include "Quadtree.h"
+#include "bitstream.h"
+#include "mappedfile.h"
+#include "codage.h"
+
+
+/**
+ * @brief Bilan d'un décodage direct dans l'image (voir decodeQTCImage).
+ */
+typedef struct {
+    uint64_t nodes;         // Nœuds décodés, hors de l'image compris (comme un arbre creux)
+    EncodedFields fields;   // Champs lus (bits significatifs pour le format Q1 seulement)
+    uint64_t bytes;         // Pic de mémoire des niveaux conservés
+} DecodeStats;
 
 
 /**
  * Lit un fichier contenant un QuadTree compressé (format QTC) le copie pour le renvoyer
  * 
  * @param filename Pointeur vers le fichier à lire.
- * @param taille Pointeur pour stocker la taille des données lues.
+ * @param taille Pointeur pour stocker la profondeur de l'arbre lue dans l'en-tête.
+ * @param width Pointeur pour stocker la largeur de l'image.
+ * @param height Pointeur pour stocker la hauteur de l'image.
+ * @param dataSize Pointeur pour stocker la taille des données binaires en octets.
+ * @param format Pointeur pour stocker la version du format (1 à 4).
  * @return Un tableau d'octets contenant les données lues.
  */
-uint8_t* readQTCFile(FILE* filename, int* taille) ; 
+uint8_t* readQTCFile(FILE* filename, int* taille, int* width, int* height, size_t* dataSize, int* format) ; 
+
+
+/**
+ * Projette un fichier QTC : le flux binaire est lu en place, sans copie.
+ * 
+ * @param filename Nom du fichier QTC.
+ * @param file Pointeur vers le fichier projeté (à fermer par closeMappedFile).
+ * @param taille Pointeur pour stocker la profondeur de l'arbre lue dans l'en-tête.
+ * @param width Pointeur pour stocker la largeur de l'image.
+ * @param height Pointeur pour stocker la hauteur de l'image.
+ * @param dataSize Pointeur pour stocker la taille des données binaires en octets.
+ * @param format Pointeur pour stocker la version du format (1 à 4).
+ * @return Les données binaires dans la projection, ou NULL en cas d'erreur (fichier fermé).
+ */
+const uint8_t* mapQTCFile(const char* filename, MappedFile* file, int* taille, int* width, int* height, size_t* dataSize, int* format) ;
 
 
 /**
@@ -23,6 +55,7 @@ uint8_t* readQTCFile(FILE* filename, int* taille) ;
  * 
  * @param tree Pointeur vers le QuadTree à encoder.
  * @param data Tableau où les données compressées seront écrites.
+ * @param grid Grille de segmentation tracée pendant le même parcours (même taille que l'image), ou NULL.
  * @param width Largeur de l'image d'origine.
  * @param height Hauteur de l'image d'origine.
  * @param nodeIndex Index du nœud actuel dans le QuadTree.
@@ -30,16 +63,125 @@ uint8_t* readQTCFile(FILE* filename, int* taille) ;
  * @param startY Coordonnée Y de départ.
  * @param size Taille de la zone actuelle.
  */
-void createDataFromTree(QuadTree* tree, uint8_t* data, int width, int height, int nodeIndex, int startX, int startY, int size); 
+void createDataFromTree(QuadTree* tree, uint8_t* data, uint8_t* grid, int width, int height, int nodeIndex,
+                        int startX, int startY, int size);
 
 
 /**
  * Reconstruit un QuadTree à partir des données compressées.
  * 
  * @param data Tableau contenant les données compressées.
- * @param tree Pointeur vers le QuadTree à remplir.
+ * @param dataSize Taille des données compressées en octets.
+ * @param tree Pointeur vers le QuadTree creux à remplir (voir createSparseQuadTree).
+ * @return 0 en cas de succès, -1 si les données sont absentes ou tronquées.
+ */
+int fillQuadTreeFromQTC(const uint8_t* data, size_t dataSize, QuadTree* tree); 
+
+
+/**
+ * Reconstruit un QuadTree à partir de données au format Q4 (voir encoderQuadTreeEntropy).
+ * 
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param tree Pointeur vers le QuadTree creux à remplir (voir createSparseQuadTree).
+ * @return 0 en cas de succès, -1 si les données sont absentes ou tronquées.
+ */
+int fillQuadTreeFromQTCEntropy(const uint8_t* data, size_t dataSize, QuadTree* tree);
+
+
+/**
+ * Décode la racine et les premiers niveaux d'un QuadTree creux, puis construit son index des rangs.
+ * 
+ * Les niveaux suivants ne sont pas décodés : leurs entrées de `levelFirst` restent nulles.
+ * 
+ * @param reader Lecteur positionné sur la racine.
+ * @param tree Pointeur vers le QuadTree creux à remplir (voir createSparseQuadTree).
+ * @param lastLevel Dernier niveau à décoder (au plus la profondeur de l'arbre).
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int fillQuadTreeLevelsFromQTC(BitReader* reader, QuadTree* tree, int lastLevel);
+
+
+/**
+ * Décode les descendants de la racine d'un QuadTree creux, puis construit son index des rangs.
+ * 
+ * @param reader Lecteur positionné sur les enfants de la racine.
+ * @param tree Pointeur vers le QuadTree creux, dont la racine (non uniforme) est remplie.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int fillSubtreeFromQTC(BitReader* reader, QuadTree* tree);
+
+
+/**
+ * Reconstruit un QuadTree à partir de données au format Q2 (voir encoderQuadTreeIndexed).
+ * 
+ * Les niveaux situés au-dessus du découpage sont décodés d'abord, puis chaque sous-arbre
+ * est décodé indépendamment à partir de sa position dans l'index.
+ * 
+ * @param data Données qui suivent l'octet de profondeur (niveau de découpage, index, flux).
+ * @param dataSize Taille des données en octets.
+ * @param tree Pointeur vers le QuadTree creux à remplir (voir createSparseQuadTree).
+ * @param pool Pool de threads (NULL pour un décodage séquentiel).
+ * @param indexBytes Pointeur où stocker la taille de l'index en octets (peut être NULL).
+ * @return 0 en cas de succès, -1 si les données sont invalides ou tronquées.
+ */
+int fillQuadTreeFromQTCIndexed(const uint8_t* data, size_t dataSize, QuadTree* tree, ThreadPool* pool, size_t* indexBytes);
+
+
+/**
+ * Repère le flux des niveaux supérieurs d'un fichier Q2 : la racine et les niveaux jusqu'au
+ * niveau de découpage, codés comme en Q1 au début du flux, avant les sous-arbres.
+ * 
+ * @param data Données qui suivent l'octet de profondeur (niveau de découpage, index, flux).
+ * @param dataSize Taille des données en octets.
+ * @param depth Profondeur de l'image.
+ * @param streamSize Pointeur où stocker la taille du flux en octets.
+ * @param split Pointeur où stocker le niveau de découpage (dernier niveau du flux).
+ * @return Le début du flux, ou NULL si l'en-tête Q2 est invalide.
+ */
+const uint8_t* indexedTopStream(const uint8_t* data, size_t dataSize, int depth, size_t* streamSize, int* split);
+
+
+/**
+ * Génère les données d'image à partir d'un QuadTree, par bandes reconstruites en parallèle.
+ * 
+ * @param tree Pointeur vers le QuadTree contenant les données.
+ * @param data Tableau où l'image sera écrite (dimensions du QuadTree).
+ * @param grid Grille de segmentation tracée pendant la reconstruction (même taille que l'image), ou NULL.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param pool Pool de threads (NULL pour une reconstruction séquentielle).
+ */
+void createDataFromTreeParallel(QuadTree* tree, uint8_t* data, uint8_t* grid, int width, int height, ThreadPool* pool);
+
+
+/**
+ * Décode un flux unique (format Q1 ou Q4) directement dans l'image, sans construire l'arbre.
+ * 
+ * Seuls les nœuds non uniformes de deux niveaux voisins sont conservés (4 octets chacun) ;
+ * leur moyenne est rangée dans le premier pixel de leur bloc. Les blocs uniformes sont
+ * peints dès qu'ils sont lus. L'image obtenue est celle de fillQuadTreeFromQTC (ou
+ * fillQuadTreeFromQTCEntropy) suivi de createDataFromTree.
+ * 
+ * Avec level < depth, la lecture s'arrête après le niveau level, et l'image produite est
+ * celle des moyennes de ses blocs (un pixel par bloc) : un aperçu en 2^level x 2^level
+ * au plus, obtenu en un temps proportionnel à sa taille.
+ * 
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param format Version du format (1 ou 4).
+ * @param width Largeur de l'image codée.
+ * @param height Hauteur de l'image codée.
+ * @param depth Profondeur de l'image codée.
+ * @param level Dernier niveau à décoder (au plus depth).
+ * @param image Image à remplir, de coveringBlocks(width, depth - level) pixels sur
+ *              coveringBlocks(height, depth - level).
+ * @param grid Grille de segmentation à tracer (même taille que l'image), ou NULL.
+ * @param stats Pointeur où stocker le bilan du décodage.
+ * @return 0 en cas de succès, -1 si les données sont invalides ou tronquées.
  */
-void fillQuadTreeFromQTC(const uint8_t* data, QuadTree* tree); 
+int decodeQTCImage(const uint8_t* data, size_t dataSize, int format, int width, int height, int depth, int level,
+                   uint8_t* image, uint8_t* grid, DecodeStats* stats);
 
 
 #endif
@@ -0,0 +1,280 @@
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bitstream.h"
+#include "Quadtree.h"
+
+
+/**
+ * Précision des fréquences du codeur rANS : les fréquences d'un contexte somment à 2^12.
+ */
+#define RANS_SCALE_BITS 12
+#define RANS_SCALE (1 << RANS_SCALE_BITS)
+
+/**
+ * Borne basse de l'état rANS : l'état reste dans [2^16, 2^32) et se renormalise par mots
+ * de 16 bits, au plus un par symbole.
+ */
+#define RANS_LOW (1u << 16)
+
+/**
+ * Adaptation des contextes : chaque symbole codé ajoute RANS_INCREMENT à son compte ; les
+ * comptes sont divisés par deux quand leur somme dépasse RANS_MAX_TOTAL (vérifié à chaque
+ * reconstruction).
+ */
+#define RANS_INCREMENT 32
+#define RANS_MAX_TOTAL (1 << 16)
+
+/**
+ * Intervalle maximal (en symboles) entre deux reconstructions de la table d'un contexte.
+ * Les premiers intervalles sont plus courts (16, 32, 64...) pour apprendre vite.
+ */
+#define RANS_MAX_INTERVAL 4096
+
+/**
+ * Alphabets du format Q4 : écart d'une moyenne en zigzag (voir zigzagResidual), et fin
+ * d'un nœud interne (voir tailSymbol).
+ */
+#define M_SYMBOLS 256
+#define TAIL_SYMBOLS 5
+
+/**
+ * Contextes d'activité des moyennes : premier enfant d'un groupe, puis quatre classes
+ * de la somme des écarts des frères déjà codés (voir nextActivity).
+ */
+#define ENTROPY_ACTIVITY 5
+
+
+/**
+ * @brief Contexte adaptatif d'un alphabet d'au plus 256 symboles.
+ *
+ * Les comptes évoluent à chaque symbole ; les fréquences et la table de décodage qui en
+ * découlent ne sont reconstruites que périodiquement (voir rebuildRansModel), à l'identique
+ * au codage et au décodage.
+ */
+typedef struct {
+    uint32_t counts[M_SYMBOLS];     // Comptes des symboles
+    int symbols;                    // Taille de l'alphabet
+    int interval;                   // Intervalle courant entre deux reconstructions
+    int left;                       // Symboles restant avant la prochaine reconstruction
+    uint32_t ranges[M_SYMBOLS];     // Fréquence cumulée (16 bits faibles) et fréquence de chaque symbole
+    uint8_t lookup[RANS_SCALE];     // Symbole de chaque position de [0, RANS_SCALE)
+} RansModel;
+
+
+/**
+ * @brief Modèle de contexte du format Q4.
+ *
+ * - `m` : écart à la moyenne du parent, selon le niveau du nœud et l'activité de ses
+ *   frères déjà codés.
+ * - `tail` : epsilon et uniformité d'un nœud interne, selon son niveau.
+ */
+typedef struct {
+    RansModel m[MAX_TREE_DEPTH + 1][ENTROPY_ACTIVITY];
+    RansModel tail[MAX_TREE_DEPTH + 1];
+} EntropyModel;
+
+
+/**
+ * @brief Codeur rANS.
+ *
+ * rANS décode les symboles dans l'ordre inverse de leur codage : les symboles sont
+ * d'abord enregistrés dans l'ordre du flux (position et fréquence dans leur contexte,
+ * qui évolue comme au décodage), puis codés à rebours par flushRansEncoder. Deux états
+ * alternent d'un symbole à l'autre, ce qui permet au décodeur d'en traiter deux en même
+ * temps.
+ */
+typedef struct {
+    uint32_t* symbols;  // Symboles enregistrés : position (16 bits faibles) et fréquence
+    size_t count;       // Nombre de symboles enregistrés
+    size_t capacity;    // Capacité de `symbols`
+    int error;          // 1 si une allocation a échoué
+} RansEncoder;
+
+
+/**
+ * @brief Décodeur rANS, lu en place dans un tampon.
+ *
+ * Au-delà de la fin du tampon, le décodeur lit des zéros (voir ransDecoderOverrun).
+ */
+typedef struct {
+    const uint8_t* data;
+    size_t size;        // Taille du tampon en octets
+    size_t pos;         // Prochain octet à lire
+    uint32_t state[2];  // États rANS : celui du prochain symbole, puis celui du suivant
+} RansDecoder;
+
+
+/**
+ * Initialise les contextes d'un modèle utiles à un arbre de profondeur donnée.
+ *
+ * @param model Pointeur vers le modèle.
+ * @param depth Profondeur de l'arbre.
+ */
+void initEntropyModel(EntropyModel* model, int depth);
+
+
+/**
+ * Reconstruit les fréquences et la table de décodage d'un contexte à partir de ses comptes.
+ *
+ * @param model Pointeur vers le contexte.
+ */
+void rebuildRansModel(RansModel* model);
+
+
+/**
+ * Initialise un codeur vide.
+ *
+ * @param encoder Pointeur vers le codeur.
+ */
+void initRansEncoder(RansEncoder* encoder);
+
+
+/**
+ * Agrandit le tableau des symboles enregistrés d'un codeur.
+ *
+ * @param encoder Pointeur vers le codeur.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int growRansEncoder(RansEncoder* encoder);
+
+
+/**
+ * Code les symboles enregistrés et écrit le flux obtenu.
+ *
+ * @param encoder Pointeur vers le codeur (vidé, mais à libérer par freeRansEncoder).
+ * @param out Écrivain recevant les octets du flux.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int flushRansEncoder(RansEncoder* encoder, BitWriter* out);
+
+
+/**
+ * Libère un codeur.
+ *
+ * @param encoder Pointeur vers le codeur.
+ */
+void freeRansEncoder(RansEncoder* encoder);
+
+
+/**
+ * Initialise un décodeur sur un tampon.
+ *
+ * @param decoder Pointeur vers le décodeur.
+ * @param data Tampon à lire.
+ * @param size Taille du tampon en octets.
+ */
+void initRansDecoder(RansDecoder* decoder, const uint8_t* data, size_t size);
+
+
+/**
+ * Compte un symbole dans son contexte (après son codage ou son décodage).
+ *
+ * @param model Pointeur vers le contexte.
+ * @param symbol Symbole.
+ */
+static inline void updateRansModel(RansModel* model, int symbol) {
+    model->counts[symbol] += RANS_INCREMENT;
+    if (--model->left == 0) rebuildRansModel(model);
+}
+
+
+/**
+ * Enregistre un symbole à coder dans un contexte, puis adapte celui-ci.
+ *
+ * @param encoder Pointeur vers le codeur.
+ * @param model Pointeur vers le contexte.
+ * @param symbol Symbole à coder.
+ */
+static inline void encodeSymbol(RansEncoder* encoder, RansModel* model, int symbol) {
+    if (encoder->count == encoder->capacity && growRansEncoder(encoder) != 0) return;
+    encoder->symbols[encoder->count++] = model->ranges[symbol];
+    updateRansModel(model, symbol);
+}
+
+
+/**
+ * Décode un symbole dans un contexte, puis adapte celui-ci.
+ *
+ * @param decoder Pointeur vers le décodeur.
+ * @param model Pointeur vers le contexte.
+ * @return Le symbole décodé.
+ */
+static inline int decodeSymbol(RansDecoder* decoder, RansModel* model) {
+    uint32_t current = decoder->state[0];
+    uint32_t slot = current & (RANS_SCALE - 1);
+    int symbol = model->lookup[slot];
+    uint32_t range = model->ranges[symbol];
+    uint32_t state = (range >> 16) * (current >> RANS_SCALE_BITS) + slot - (range & 0xFFFF);
+
+    // Un mot suffit (état >= 2^4 après un symbole) : lu sans branchement imprévisible
+    uint32_t word = decoder->pos + 2 <= decoder->size ? (uint32_t)decoder->data[decoder->pos] << 8 | decoder->data[decoder->pos + 1] : 0;
+    int refill = state < RANS_LOW;
+    decoder->pos += 2 * refill;
+
+    // Les deux états alternent : celui-ci servira au symbole d'après
+    decoder->state[0] = decoder->state[1];
+    decoder->state[1] = refill ? (state << 16) | word : state;
+    updateRansModel(model, symbol);
+    return symbol;
+}
+
+
+/**
+ * Indique si le décodage a dépassé la fin du tampon.
+ *
+ * @return 1 si des octets au-delà de la fin ont été lus, 0 sinon.
+ */
+static inline int ransDecoderOverrun(const RansDecoder* decoder) {
+    return decoder->pos > decoder->size;
+}
+
+
+/**
+ * Écart entre une moyenne et sa prédiction, en zigzag : 0, -1, 1, -2, 2... donnent 0, 1, 2, 3, 4...
+ */
+static inline int zigzagResidual(uint8_t m, uint8_t predicted) {
+    uint8_t u = (uint8_t)(m - predicted); // écart modulo 256, signe dans le bit 7
+    return (uint8_t)((u << 1) ^ (uint8_t)-(u >> 7));
+}
+
+
+/**
+ * Moyenne correspondant à un écart en zigzag (inverse de zigzagResidual).
+ */
+static inline uint8_t unzigzagResidual(int z, uint8_t predicted) {
+    return (uint8_t)(predicted + ((z >> 1) ^ -(z & 1)));
+}
+
+
+/**
+ * Contexte d'activité du frère suivant, à partir de la somme des écarts en zigzag des
+ * frères déjà codés : 1 si elle est nulle, puis 2, 3 ou 4 selon qu'elle dépasse 2 ou 8.
+ */
+static inline int nextActivity(int total) {
+    static const uint8_t classes[10] = { 1, 2, 2, 3, 3, 3, 3, 3, 3, 4 };
+    return classes[total < 9 ? total : 9];
+}
+
+
+/**
+ * Symbole de fin d'un nœud interne : 0 ou 1 pour epsilon nul (non uniforme ou uniforme),
+ * 2 à 4 pour epsilon de 1 à 3.
+ */
+static inline int tailSymbol(uint8_t epsilon, uint8_t uniform) {
+    return epsilon ? epsilon + 1 : uniform;
+}
+
+
+/**
+ * Contexte de niveau d'un nœud (les niveaux au-delà de MAX_TREE_DEPTH partagent le dernier).
+ */
+static inline int levelContext(int level) {
+    return level < MAX_TREE_DEPTH ? level : MAX_TREE_DEPTH;
+}
+
+
+#endif
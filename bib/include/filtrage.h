@@ -4,6 +4,18 @@
 #include "Quadtree.h"
 
 
+/**
+ * Calcule la somme et le maximum des variances des nœuds internes d'un QuadTree
+ * (ceux qui touchent son image).
+ * 
+ * @param tree Pointeur vers un QuadTree complet (variances allouées).
+ * @param sumvar Pointeur où la somme des variances sera stockée.
+ * @param maxvar Pointeur où la variance maximale sera stockée.
+ * @return Le nombre de nœuds internes comptés.
+ */
+double sumAndMaxVars(const QuadTree* tree, double* sumvar, double* maxvar);
+
+
 /**
  * Calcule la variance moyenne et maximale des blocs dans un QuadTree.
  * 
@@ -26,4 +38,36 @@ void avgAndMaxVars(QuadTree* tree, double* medvar, double* maxvar);
 int filtrage (QuadTree * tree , int nodeIndex , double sigma , double alpha );
 
 
+/**
+ * Filtrage des niveaux situés au-dessus du découpage, à partir des résultats des sous-arbres.
+ * 
+ * Même règle que filtrage, mais la récursion s'arrête au niveau de découpage, dont
+ * les résultats sont donnés (les sous-arbres ont été filtrés à part).
+ * 
+ * @param tree Pointeur vers le QuadTree complet à filtrer.
+ * @param nodeIndex Index du nœud actuel.
+ * @param level Niveau du nœud actuel.
+ * @param split Niveau de découpage.
+ * @param sigma Seuil de variance au niveau du nœud actuel.
+ * @param alpha Facteur pour ajuster le filtrage.
+ * @param results Résultats du filtrage des nœuds du niveau de découpage (par position dans le niveau).
+ * @return Le résultat du filtrage du nœud.
+ */
+int filtrageTop(QuadTree* tree, int nodeIndex, int level, int split, double sigma, double alpha, const uint8_t* results);
+
+
+/**
+ * Applique le filtrage à tout un QuadTree, les sous-arbres étant filtrés en parallèle.
+ * 
+ * Le résultat est identique à filtrage(tree, 0, sigma, alpha).
+ * 
+ * @param tree Pointeur vers le QuadTree à filtrer.
+ * @param sigma Seuil de variance à la racine.
+ * @param alpha Facteur pour ajuster le filtrage.
+ * @param pool Pool de threads (NULL pour un filtrage séquentiel).
+ * @return Le résultat du filtrage de la racine.
+ */
+int filtrageParallel(QuadTree* tree, double sigma, double alpha, ThreadPool* pool);
+
+
 #endif 
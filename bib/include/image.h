@@ -5,18 +5,49 @@
 #include <stdint.h>
 #include <stdlib.h>  
 
+#include "mappedfile.h"
+
+
+/**
+ * Projette un fichier PGM et renvoie ses pixels, lus en place après l'en-tête.
+ * 
+ * @param filename Nom du fichier PGM à lire.
+ * @param file Pointeur vers le fichier projeté (à fermer par closeMappedFile).
+ * @param width Pointeur pour stocker la largeur de l'image.
+ * @param height Pointeur pour stocker la hauteur de l'image.
+ * @param maxval Pointeur pour stocker le niveau de gris de la PGM
+ * @param dataSizePGM Pointeur pour stocker la taille des données en octets.
+ * @return Les pixels de l'image dans la projection, ou NULL en cas d'erreur (fichier fermé).
+ */
+uint8_t* mapPGMFile(const char* filename, MappedFile* file, int* width, int* height, int* maxval, size_t* dataSizePGM);
+
+
+/**
+ * Crée un fichier PGM projeté, en-tête écrit, dont les pixels sont à remplir en place.
+ * 
+ * @param filename Nom du fichier PGM à écrire.
+ * @param file Pointeur vers le fichier projeté (à fermer par closeMappedFile).
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param maxval Valeur maximale des pixels.
+ * @return Les pixels de l'image dans la projection, ou NULL en cas d'erreur.
+ */
+uint8_t* createPGMFile(const char* filename, MappedFile* file, int width, int height, int maxval);
+
+
 
 /**
  * Lit un fichier image au format PGM.
  * 
  * @param filename Nom du fichier PGM à lire.
- * @param size Pointeur pour stocker la taille de l'image.
+ * @param width Pointeur pour stocker la largeur de l'image.
+ * @param height Pointeur pour stocker la hauteur de l'image.
  * @param maxval Pointeur pour stocker le niveau de gris de la PGM
  * @param dataSizePGM Pointeur pour stocker la taille des données en octets.
  * @return Un tableau d'octets contenant les données de l'image.
  */
 
-uint8_t* readPGMFile(const char* filename, int* size, int* maxval , size_t * dataSizePGM );
+uint8_t* readPGMFile(const char* filename, int* width, int* height, int* maxval , size_t * dataSizePGM );
 
 /**
  * Écrit une image au format PGM dans un fichier.pgm
@@ -0,0 +1,107 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+
+/**
+ * @brief Fichier projeté en mémoire.
+ *
+ * Les fichiers réguliers sont projetés par mmap : les données sont lues et écrites
+ * en place, sans copie. Quand la projection est impossible (tube, fichier spécial),
+ * le fichier est lu en entier par stdio, ou écrit par stdio à la fermeture.
+ */
+typedef struct {
+    uint8_t* data;      // Contenu du fichier
+    size_t size;        // Taille en octets
+    int mapped;         // 1 si `data` est une projection mmap, 0 si c'est un tampon alloué
+    FILE* output;       // Écriture par stdio : flux rempli à la fermeture (NULL sinon)
+} MappedFile;
+
+
+/**
+ * Ouvre un fichier en lecture.
+ *
+ * @param filename Nom du fichier.
+ * @param file Pointeur vers le fichier projeté à initialiser.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int openMappedFile(const char* filename, MappedFile* file);
+
+
+/**
+ * Crée (ou tronque) un fichier de taille donnée, à remplir en écrivant dans `data`.
+ *
+ * @param filename Nom du fichier.
+ * @param size Taille du fichier en octets.
+ * @param file Pointeur vers le fichier projeté à initialiser.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int createMappedFile(const char* filename, size_t size, MappedFile* file);
+
+
+/**
+ * Ferme un fichier projeté (écrit le tampon s'il a été créé par stdio).
+ *
+ * @param file Pointeur vers le fichier projeté.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int closeMappedFile(MappedFile* file);
+
+
+/**
+ * Annonce la lecture prochaine d'une plage d'un fichier projeté (sans effet sans projection).
+ * 
+ * @param file Pointeur vers le fichier projeté.
+ * @param offset Début de la plage (en octets depuis le début du fichier).
+ * @param length Longueur de la plage en octets.
+ */
+void prefetchMappedRange(const MappedFile* file, size_t offset, size_t length);
+
+
+/**
+ * Annonce la lecture prochaine d'un fichier entier, sans l'ouvrir pour le traitement :
+ * le noyau commence à le charger en arrière-plan (sans effet en cas d'erreur).
+ * 
+ * @param filename Nom du fichier.
+ */
+void prefetchFile(const char* filename);
+
+
+/**
+ * Libère les pages d'une plage d'un fichier projeté en lecture qui ne sert plus
+ * (sans effet sans projection). Les données restent lisibles : elles sont relues
+ * depuis le fichier en cas de nouvel accès.
+ * 
+ * @param file Pointeur vers le fichier projeté.
+ * @param offset Début de la plage (en octets depuis le début du fichier).
+ * @param length Longueur de la plage en octets.
+ */
+void releaseMappedRange(const MappedFile* file, size_t offset, size_t length);
+
+
+/**
+ * Lit un flux en entier dans un tampon alloué (sans connaître sa taille à l'avance).
+ *
+ * @param stream Flux ouvert en lecture.
+ * @param size Pointeur où stocker la taille lue.
+ * @return Le tampon (à libérer par free), ou NULL en cas d'erreur.
+ */
+uint8_t* readStream(FILE* stream, size_t* size);
+
+
+/**
+ * Copie une ligne de texte d'un tampon, comme fgets.
+ *
+ * @param p Position courante dans le tampon.
+ * @param end Fin du tampon.
+ * @param line Tableau recevant la ligne (terminée par '\0').
+ * @param capacity Taille de `line`.
+ * @return La position qui suit la ligne, ou NULL si le tampon est épuisé.
+ */
+const uint8_t* readLine(const uint8_t* p, const uint8_t* end, char* line, size_t capacity);
+
+
+#endif
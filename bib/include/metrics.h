@@ -0,0 +1,92 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Étapes chronométrées d'un encodage ou d'un décodage.
+ */
+typedef enum {
+    STAGE_READ,         // projection du fichier d'entrée et lecture de l'en-tête
+    STAGE_FILL,         // construction de l'arbre à partir des pixels
+    STAGE_FILTER,       // variances et filtrage (codage avec perte)
+    STAGE_ENCODE,       // élagage et codage du flux
+    STAGE_WRITE,        // écriture et fermeture des sorties
+    STAGE_DECODE,       // lecture du flux dans l'arbre
+    STAGE_RECONSTRUCT,  // peinture de l'image à partir de l'arbre
+    STAGE_COUNT
+} MetricsStage;
+
+
+/**
+ * @brief Mesures d'un encodage ou d'un décodage (option -m du codec).
+ *
+ * Les mesures ne sont faites que si un pointeur non NULL est passé : sans elles,
+ * chaque étape ne coûte qu'un test de pointeur. Les compteurs sont calculés à partir
+ * de l'arbre entre deux étapes, jamais dans les boucles de traitement.
+ */
+typedef struct {
+    double seconds[STAGE_COUNT];    // Durée de chaque étape (horloge monotone)
+    int format;                     // Version du format QTC
+    int width;                      // Dimensions de l'image
+    int height;
+    uint64_t inputBytes;            // Taille du fichier d'entrée
+    uint64_t outputBytes;           // Taille du fichier de sortie
+    uint64_t nodesVisited;          // Nœuds calculés (remplissage, feuilles gardées) ou décodés
+    uint64_t nodesCoded;            // Nœuds ayant au moins un champ dans le flux
+    uint64_t mBits;                 // Bits du flux par type de champ (formats Q1 et Q2 seulement)
+    uint64_t epsilonBits;
+    uint64_t uniformBits;
+    uint64_t bytesAllocated;        // Pic de mémoire allouée pour l'arbre
+} Metrics;
+
+
+/**
+ * Renvoie le temps écoulé sur l'horloge monotone, en secondes.
+ *
+ * @return Le temps en secondes (origine arbitraire).
+ */
+double metricsClock(void);
+
+
+/**
+ * Début d'une étape chronométrée.
+ *
+ * @param metrics Mesures en cours, ou NULL si elles sont désactivées.
+ * @return L'instant de début, à passer à endStage (0 sans mesures).
+ */
+static inline double startStage(const Metrics* metrics) {
+    return metrics ? metricsClock() : 0.0;
+}
+
+
+/**
+ * Fin d'une étape chronométrée : sa durée est ajoutée à celle de l'étape.
+ *
+ * @param metrics Mesures en cours, ou NULL si elles sont désactivées.
+ * @param stage Étape terminée.
+ * @param start Instant renvoyé par startStage.
+ */
+static inline void endStage(Metrics* metrics, MetricsStage stage, double start) {
+    if (metrics) metrics->seconds[stage] += metricsClock() - start;
+}
+
+
+/**
+ * Écrit les mesures d'un fichier sur une ligne JSON, en une seule écriture (les lignes
+ * de plusieurs threads ne se mélangent pas).
+ *
+ * @param output Flux de sortie.
+ * @param metrics Mesures du fichier.
+ * @param operation "encode" ou "decode".
+ * @param inputFile Nom du fichier d'entrée.
+ * @param outputFile Nom du fichier de sortie.
+ * @param status 0 si le traitement a réussi, -1 sinon.
+ */
+void writeMetrics(FILE* output, const Metrics* metrics, const char* operation, const char* inputFile,
+                  const char* outputFile, int status);
+
+
+#endif
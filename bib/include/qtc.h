@@ -1,6 +1,36 @@
 #ifndef QTC_H
 #define QTC_H
 
+#include <stdio.h>
+
+#include "threadpool.h"
+
+/**
+ * @brief Options de l'encodeur et du décodeur.
+ */
+typedef struct {
+    double alpha;       // facteur de filtrage pour le codage avec perte (<= 0 : sans perte)
+    int generateGrid;   // génération de la grille de segmentation (-g)
+    int generateSegments; // liste des blocs de la segmentation (-G)
+    int bavard;         // mode bavard (-v)
+    int nbThreads;      // nombre de threads (-j), 1 : séquentiel
+    int splitLevel;     // niveau de découpage du format Q2 (-p), -1 : format Q1
+    int tileSize;       // côté des tuiles du format Q3 (-t), 0 : image entière
+    int entropy;        // format Q4 à codage entropique (-e)
+    int level;          // dernier niveau décodé, aperçu réduit (-l), -1 : image entière
+    FILE* metrics;      // lignes JSON de mesures (-m), NULL : désactivées
+    size_t targetSize;  // taille visée du fichier en octets (-s), 0 : alpha fixe
+    double targetBpp;   // débit visé en bits par pixel (-b), 0 : alpha fixe
+} QTCOptions;
+
+
+/**
+ * Initialise les options avec les valeurs par défaut (sans perte, séquentiel, format Q1).
+ * 
+ * @param options Pointeur vers les options à initialiser.
+ */
+void initQTCOptions(QTCOptions* options) ;
+
 
 /**
  * Affiche l'utilisation du programme à l'utilisateur.
@@ -16,11 +46,21 @@ void printUsage(const char* executable) ;
  * 
  * @param inputFile Nom du fichier à encoder.
  * @param outputFile Nom du fichier de sortie où écrire les données encodées.
- * @param alpha facteur utilisé dans le cas d'un codage avec avec perte 
- * @param generateGrid utilisé pour savoir si l'option -g de génération de la grille de segemntation est activée.s
- * @param bavard Si différent de 0, affiche des informations détaillées pendant l'exécution.
+ * @param options Options d'encodage (alpha ou taille visée, grille, mode bavard, threads, format, tuiles).
  */
-void handleEncoding(const char* inputFile, const char* outputFile, double alpha, int generateGrid, int bavard) ;
+void handleEncoding(const char* inputFile, const char* outputFile, const QTCOptions* options) ;
+
+
+/**
+ * Encode un fichier PGM au format QTC, sans quitter le programme en cas d'erreur.
+ * 
+ * @param inputFile Nom du fichier PGM à encoder.
+ * @param outputFile Nom du fichier QTC à écrire.
+ * @param options Options d'encodage (alpha, grille, mode bavard, format, tuiles, mesures).
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ * @return 0 en cas de succès, -1 en cas d'erreur (message déjà affiché).
+ */
+int encodeQTCFile(const char* inputFile, const char* outputFile, const QTCOptions* options, ThreadPool* pool);
 
 
 /**
@@ -28,10 +68,21 @@ void handleEncoding(const char* inputFile, const char* outputFile, double alpha,
  * 
  * @param inputFile Nom du fichier.pgm à décoder.
  * @param outputFile Nom du fichier de sortie où écrire les données décodées.
- * @param generateGrid utilisé pour savoir si l'option -g de génération de la grille de segemntation est activée.
- * @param bavard Si différent de 0, affiche des informations détaillées pendant l'exécution.
+ * @param options Options de décodage (grille, mode bavard, threads).
+ */
+void handleDecoding(const char* inputFile, const char* outputFile, const QTCOptions* options) ;
+
+
+/**
+ * Décode un fichier QTC en PGM, sans quitter le programme en cas d'erreur.
+ * 
+ * @param inputFile Nom du fichier QTC à décoder.
+ * @param outputFile Nom du fichier PGM à écrire.
+ * @param options Options de décodage (grille, mode bavard, aperçu, mesures).
+ * @param pool Pool de threads (NULL pour un décodage séquentiel).
+ * @return 0 en cas de succès, -1 en cas d'erreur (message déjà affiché).
  */
-void handleDecoding(const char* inputFile, const char* outputFile, int generateGrid, int bavard) ;
+int decodeQTCFile(const char* inputFile, const char* outputFile, const QTCOptions* options, ThreadPool* pool);
 
 
 #endif 
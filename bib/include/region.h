@@ -0,0 +1,92 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Quadtree.h"
+#include "mappedfile.h"
+
+
+/**
+ * @brief Fichier QTC ouvert pour des accès à des régions ou à des pixels isolés.
+ *
+ * À l'ouverture, seul ce qui permet de se repérer dans l'image est décodé :
+ * - formats Q1 et Q4 (sans index) : l'arbre entier ;
+ * - format Q2 : les niveaux 0 à split et la position du sous-flux de chaque nœud du niveau split ;
+ * - format Q3 : les niveaux supérieurs et la position du sous-flux de chaque tuile.
+ *
+ * Une région ne parcourt ensuite que les blocs qui la coupent, et ne décode que les
+ * sous-arbres (Q2) ou les tuiles (Q3) qu'elle touche : son coût dépend de sa surface et de
+ * la profondeur de l'arbre, pas de la taille de l'image.
+ */
+typedef struct {
+    MappedFile file;
+    int format;             // version du format (1 à 4)
+    int depth;              // profondeur de l'image
+    int width;              // dimensions de l'image
+    int height;
+    QuadTree* top;          // arbre entier (Q1, Q4) ou niveaux 0 à topDepth (Q2, Q3)
+    int topDepth;           // niveau des racines des sous-flux (depth pour Q1 et Q4)
+    const uint8_t* stream;  // Q2 : flux qui suit l'index ; Q3 : sous-flux des tuiles
+    size_t streamSize;
+    uint64_t* offsets;      // Q2 : positions en bits ; Q3 : positions en octets (NULL pour Q1 et Q4)
+    int cols;               // Q3 : tuiles qui touchent l'image, par ligne
+} QTCImage;
+
+
+/**
+ * Ouvre un fichier QTC pour des accès à des régions (voir QTCImage).
+ *
+ * @param filename Nom du fichier QTC.
+ * @return Le fichier ouvert (à fermer par closeQTCImage), ou NULL en cas d'erreur.
+ */
+QTCImage* openQTCImage(const char* filename);
+
+
+/**
+ * Décode un rectangle de l'image.
+ *
+ * @param image Fichier ouvert par openQTCImage.
+ * @param x Colonne du coin haut-gauche du rectangle.
+ * @param y Ligne du coin haut-gauche du rectangle.
+ * @param w Largeur du rectangle.
+ * @param h Hauteur du rectangle.
+ * @param region Tableau de w * h pixels, ligne par ligne, à remplir.
+ * @return 0 en cas de succès, -1 si le rectangle sort de l'image ou si les données sont invalides.
+ */
+int decodeQTCRegion(const QTCImage* image, int x, int y, int w, int h, uint8_t* region);
+
+
+/**
+ * Écrit la liste des blocs de la segmentation de l'image (rectangles des feuilles), à la
+ * place d'une grille de la taille de l'image.
+ *
+ * @param image Fichier ouvert par openQTCImage.
+ * @param output Flux de sortie.
+ * @return 0 en cas de succès, -1 si les données sont invalides ou en cas d'erreur d'écriture.
+ */
+int writeQTCSegments(const QTCImage* image, FILE* output);
+
+
+/**
+ * Renvoie la valeur d'un pixel de l'image.
+ *
+ * @param image Fichier ouvert par openQTCImage.
+ * @param x Colonne du pixel.
+ * @param y Ligne du pixel.
+ * @return La valeur du pixel (0 à 255), ou -1 s'il est hors de l'image ou si les données sont invalides.
+ */
+int getQTCPixel(const QTCImage* image, int x, int y);
+
+
+/**
+ * Ferme un fichier ouvert par openQTCImage.
+ *
+ * @param image Fichier à fermer (peut être NULL).
+ */
+void closeQTCImage(QTCImage* image);
+
+
+#endif
@@ -1,9 +1,64 @@
 #ifndef SEGMENTATION_H
 #define SEGMENTATION_H
 
+#include <stdint.h>
+
 #include "Quadtree.h"
 
 
+/**
+ * Côtés d'un bloc à tracer dans une grille de segmentation (voir drawSegmentSides).
+ */
+#define SEGMENT_TOP 1
+#define SEGMENT_RIGHT 2
+#define SEGMENT_BOTTOM 4
+#define SEGMENT_LEFT 8
+#define SEGMENT_OUTLINE (SEGMENT_TOP | SEGMENT_RIGHT | SEGMENT_BOTTOM | SEGMENT_LEFT)
+
+
+/**
+ * Côtés d'un enfant non uniforme qui restent à tracer quand le contour de son parent
+ * l'est déjà : ceux qui donnent sur le centre du parent (les deux autres sont sur le
+ * contour du parent).
+ * 
+ * @param k Position de l'enfant (0 à 3 : haut-gauche, haut-droit, bas-droit, bas-gauche).
+ * @return Masque des côtés à tracer.
+ */
+static inline int childSegmentSides(int k) {
+    static const uint8_t sides[4] = {
+        SEGMENT_RIGHT | SEGMENT_BOTTOM, SEGMENT_LEFT | SEGMENT_BOTTOM, SEGMENT_LEFT | SEGMENT_TOP, SEGMENT_RIGHT | SEGMENT_TOP
+    };
+    return sides[k];
+}
+
+
+/**
+ * @brief Trace des côtés d'un bloc dans une grille de segmentation.
+ * 
+ * @param grid Tableau représentant la grille de segmentation.
+ * @param width Largeur de la grille.
+ * @param height Hauteur de la grille.
+ * @param x Coordonnée X du bloc.
+ * @param y Coordonnée Y du bloc.
+ * @param size Côté du bloc.
+ * @param sides Côtés à tracer (masque de SEGMENT_TOP, SEGMENT_RIGHT, SEGMENT_BOTTOM, SEGMENT_LEFT).
+ */
+void drawSegmentSides(uint8_t* grid, int width, int height, int x, int y, int size, int sides);
+
+
+/**
+ * @brief Trace le contour d'un bloc dans une grille de segmentation.
+ * 
+ * @param grid Tableau représentant la grille de segmentation.
+ * @param width Largeur de la grille.
+ * @param height Hauteur de la grille.
+ * @param x Coordonnée X du bloc.
+ * @param y Coordonnée Y du bloc.
+ * @param size Côté du bloc.
+ */
+void drawSegmentOutline(uint8_t* grid, int width, int height, int x, int y, int size);
+
+
 /**
  * @brief Génère une grille de segmentation à partir d'un QuadTree.
  * 
@@ -0,0 +1,73 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+
+/**
+ * @brief Fonction exécutée par une tâche du pool.
+ * 
+ * @param arg Argument passé lors de la soumission de la tâche.
+ */
+typedef void (*TaskFunc)(void* arg);
+
+
+/**
+ * @brief Pool de threads à vol de tâches (work-stealing).
+ * 
+ * Chaque thread possède sa propre file de tâches : il dépile ses tâches par la fin
+ * (les plus récentes) et, quand sa file est vide, vole les plus anciennes tâches
+ * des autres threads.
+ */
+typedef struct ThreadPool ThreadPool;
+
+
+/**
+ * Crée un pool de threads.
+ * 
+ * @param nbThreads Nombre de threads de travail (au moins 1).
+ * @return Pointeur vers le pool, ou NULL en cas d'erreur.
+ */
+ThreadPool* createThreadPool(int nbThreads);
+
+
+/**
+ * Renvoie le nombre de threads de travail d'un pool.
+ * 
+ * @param pool Pointeur vers le pool.
+ * @return Le nombre de threads.
+ */
+int threadPoolSize(const ThreadPool* pool);
+
+
+/**
+ * Soumet une tâche au pool.
+ * 
+ * Appelée depuis un thread du pool, la tâche est placée dans la file de ce thread ;
+ * sinon les tâches sont réparties à tour de rôle entre les files.
+ * 
+ * @param pool Pointeur vers le pool.
+ * @param func Fonction à exécuter.
+ * @param arg Argument passé à la fonction.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int submitTask(ThreadPool* pool, TaskFunc func, void* arg);
+
+
+/**
+ * Attend la fin de toutes les tâches soumises au pool.
+ * 
+ * Ne doit pas être appelée depuis une tâche du pool.
+ * 
+ * @param pool Pointeur vers le pool.
+ */
+void waitThreadPool(ThreadPool* pool);
+
+
+/**
+ * Arrête les threads et libère le pool (les tâches en attente sont d'abord exécutées).
+ * 
+ * @param pool Pointeur vers le pool à libérer.
+ */
+void freeThreadPool(ThreadPool* pool);
+
+
+#endif
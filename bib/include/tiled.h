@@ -0,0 +1,126 @@
+#ifndef TILED_H
+#define TILED_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "Quadtree.h"
+#include "mappedfile.h"
+
+
+/**
+ * Profondeur maximale d'une tuile du format Q3 (tuiles de 8192x8192 pixels au plus).
+ */
+#define MAX_TILE_DEPTH 13
+
+
+/**
+ * @brief Bilan d'un codage ou d'un décodage tuilé (compteurs sur 64 bits).
+ */
+typedef struct {
+    uint64_t tiles;         // Nombre de tuiles de l'image
+    uint64_t codedTiles;    // Tuiles dont le sous-flux n'est pas vide
+    uint64_t codedNodes;    // Nœuds codés (tuiles et niveaux supérieurs)
+    uint64_t bytes;         // Taille des données qui suivent l'octet de profondeur
+    uint64_t indexBytes;    // Taille de l'index (profondeur des tuiles et positions comprises)
+} TiledStats;
+
+
+/**
+ * @brief Encode une image par tuiles au format Q3, sans construire l'arbre de toute l'image.
+ *
+ * L'image est parcourue par bandes horizontales d'une tuile de haut. Chaque tuile est
+ * un sous-arbre complet, construit, filtré, élagué et encodé seul ; ses octets sont
+ * écrits dès que sa bande est terminée et les pages de la bande sont libérées. La
+ * mémoire utilisée dépend de la taille des tuiles (et, pour les niveaux supérieurs et
+ * l'index, de leur nombre), pas de celle de l'image.
+ *
+ * Après l'octet de profondeur, le format Q3 contient :
+ * - un octet donnant la profondeur t des tuiles (côté 2^t) ;
+ * - les sous-flux des tuiles, ligne par ligne, chacun aligné sur un octet : les
+ *   descendants de la racine de la tuile en largeur, avec les règles de Q1 (vide si
+ *   la tuile est couverte par un bloc uniforme) ;
+ * - le flux des niveaux supérieurs : les niveaux 0 à profondeur - t de l'image en
+ *   largeur, avec les règles de Q1 (les racines des tuiles sont des nœuds internes) ;
+ * - l'index : la position en octets (64 bits, gros-boutiste) du sous-flux de chaque
+ *   tuile, dans l'ordre des lignes, comptée depuis le premier sous-flux ;
+ * - la position du flux des niveaux supérieurs (64 bits, gros-boutiste).
+ *
+ * Seules les tuiles qui touchent l'image sont codées et indexées (dans l'ordre des
+ * lignes de tuiles qui la couvrent) ; une tuile qui déborde est restreinte à sa partie
+ * dans l'image, comme les blocs du bord dans le format Q1.
+ *
+ * Le codage avec perte refait deux passes sur l'image : la première calcule les
+ * variances moyenne et maximale, la seconde filtre les tuiles pour décider des
+ * niveaux supérieurs avant que les sous-flux ne soient écrits. L'image décodée est
+ * identique à celle du format Q1.
+ *
+ * @param file Fichier de sortie, positionné après l'octet de profondeur.
+ * @param input Fichier projeté contenant l'image.
+ * @param pixels Pixels de l'image dans la projection.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur de l'image (plus petit carré qui la contient).
+ * @param tileDepth Profondeur des tuiles (entre 1 et MAX_TILE_DEPTH, au plus depth).
+ * @param alpha Facteur de filtrage pour le codage avec perte (<= 0 : sans perte).
+ * @param grid Grille de segmentation à tracer (même taille que l'image), ou NULL.
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ * @param stats Pointeur où stocker le bilan du codage.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int encoderQuadTreeTiled(FILE* file, const MappedFile* input, const uint8_t* pixels, int width, int height, int depth,
+                         int tileDepth, double alpha, uint8_t* grid, ThreadPool* pool, TiledStats* stats);
+
+
+/**
+ * @brief Décode une image au format Q3, tuile par tuile (voir encoderQuadTreeTiled).
+ *
+ * Les niveaux supérieurs sont décodés d'abord ; chaque tuile est ensuite décodée dans
+ * son propre arbre creux, peinte dans l'image puis libérée.
+ *
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur de l'image.
+ * @param image Image à remplir.
+ * @param grid Grille de segmentation à tracer (même taille que l'image), ou NULL.
+ * @param pool Pool de threads (NULL pour un décodage séquentiel).
+ * @param stats Pointeur où stocker le bilan du décodage.
+ * @return 0 en cas de succès, -1 si les données sont invalides ou tronquées.
+ */
+int decoderQuadTreeTiled(const uint8_t* data, size_t dataSize, int width, int height, int depth, uint8_t* image,
+                         uint8_t* grid, ThreadPool* pool, TiledStats* stats);
+
+
+/**
+ * @brief Lit l'index d'un flux Q3 et vérifie les positions des sous-flux.
+ *
+ * @param area Données qui suivent l'octet de profondeur des tuiles.
+ * @param areaSize Taille de ces données en octets.
+ * @param nbTiles Nombre de tuiles.
+ * @param topSize Pointeur où stocker la taille du flux des niveaux supérieurs.
+ * @return Les nbTiles + 1 positions en octets depuis `area` (la dernière est celle du flux
+ * des niveaux supérieurs), à libérer par free, ou NULL si l'index est invalide.
+ */
+uint64_t* readTileIndex(const uint8_t* area, size_t areaSize, uint64_t nbTiles, size_t* topSize);
+
+
+/**
+ * @brief Repère le flux des niveaux supérieurs d'un fichier Q3 : les niveaux 0 à
+ * profondeur - t, codés comme en Q1 (voir encoderQuadTreeTiled).
+ *
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur de l'image.
+ * @param topSize Pointeur où stocker la taille du flux en octets.
+ * @param topDepth Pointeur où stocker le niveau des racines des tuiles (dernier niveau du flux).
+ * @return Le début du flux, ou NULL si l'index est invalide.
+ */
+const uint8_t* tiledTopStream(const uint8_t* data, size_t dataSize, int width, int height, int depth,
+                              size_t* topSize, int* topDepth);
+
+
+#endif
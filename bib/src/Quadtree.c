@@ -1,13 +1,24 @@
+#include <string.h>
+
 #include "Quadtree.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define FLAT_BLOCK_SIZE (1 << FLAT_BLOCK_DEPTH)
+
 /**
  * @brief Calcule le nombre total de noeud dans un QuadTree donné sa profondeur.
  * 
- * @param depth Profondeur du QuadTree 
+ * Le calcul est fait sur 64 bits : au-delà de la profondeur 15, le nombre de nœuds
+ * ne tient plus dans un int.
+ * 
+ * @param depth Profondeur du QuadTree (au plus 30)
  * @return Le nombre total de noeuds dans le QuadTree.
  */
-static int calculateTotalNodes(int depth) {
-    return (int)((pow(4, depth + 1) - 1) / 3); // Somme de 4^k pour k=0 à depth
+static int64_t calculateTotalNodes(int depth) {
+    return (((int64_t)1 << (2 * (depth + 1))) - 1) / 3; // Somme de 4^k pour k=0 à depth
 }
 
 /**
@@ -20,6 +31,74 @@ int isFourthChild(int index) { //1 si le noeud est 4eme sinon 0
     return (index - 1) % 4 == 3;
 }
 
+/**
+ * Vérifie si un nœud est l'enfant dont la moyenne se déduit de celle de son parent :
+ * le dernier de ses frères dans l'image (le quatrième si l'image remplit le bloc).
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index du nœud.
+ * @return 1 si la moyenne du nœud n'est pas codée, 0 sinon (toujours pour la racine).
+ */
+int isDerivedChild(const QuadTree* tree, int nodeIndex) {
+    if (nodeIndex == 0) return 0;
+    int k = (nodeIndex - 1) & 3;
+    if (!tree->border) return k == 3;
+
+    // Les frères suivants doivent tous être hors de l'image
+    for (int i = nodeIndex + 1; i < nodeIndex + 4 - k; i++) {
+        if (!(tree->border[i] & BORDER_OUTSIDE)) return 0;
+    }
+    return 1;
+}
+
+
+/**
+ * Calcule les indicateurs de bord des quatre enfants d'un nœud à partir des siens.
+ * 
+ * Un bloc qui contient la dernière colonne de l'image la transmet à l'un de ses enfants
+ * de gauche ou de droite, selon le bit de (largeur - 1) correspondant à la taille des
+ * enfants ; si c'est aux enfants de gauche, ceux de droite sont hors de l'image. Même
+ * chose pour la dernière ligne.
+ * 
+ * @param tree Pointeur vers le QuadTree (dimensions de l'image).
+ * @param level Niveau du nœud.
+ * @param border Indicateurs de bord du nœud (hors de l'image exclu).
+ * @param children Tableau recevant les indicateurs des quatre enfants.
+ * @return Masque des enfants hors de l'image (bit k pour l'enfant k).
+ */
+uint8_t childBorders(const QuadTree* tree, int level, uint8_t border, uint8_t children[4]) {
+    int shift = tree->depth - level - 1;
+    uint8_t x[2] = { 0, 0 };   // enfants de gauche, de droite
+    uint8_t y[2] = { 0, 0 };   // enfants du haut, du bas
+
+    if (border & BORDER_RIGHT) {
+        int cx = ((tree->width - 1) >> shift) & 1;
+        x[cx] = BORDER_RIGHT;
+        if (cx == 0) x[1] = BORDER_OUTSIDE;
+    }
+    if (border & BORDER_BOTTOM) {
+        int cy = ((tree->height - 1) >> shift) & 1;
+        y[cy] = BORDER_BOTTOM;
+        if (cy == 0) y[1] = BORDER_OUTSIDE;
+    }
+
+    // Haut-gauche, haut-droit, bas-droit, bas-gauche
+    children[0] = x[0] | y[0];
+    children[1] = x[1] | y[0];
+    children[2] = x[1] | y[1];
+    children[3] = x[0] | y[1];
+
+    uint8_t outside = 0;
+    for (int i = 0; i < 4; i++) {
+        if (children[i] & BORDER_OUTSIDE) {
+            children[i] = BORDER_OUTSIDE;
+            outside |= 1 << i;
+        }
+    }
+    return outside;
+}
+
+
 /**
  * Vérifie si un noeud une feuille
  * 
@@ -28,91 +107,482 @@ int isFourthChild(int index) { //1 si le noeud est 4eme sinon 0
  * @return 1 si le nœud est une feuille, 0 sinon.
  */
 int isLeaf(QuadTree* tree, int nodeIndex) {
-    int childIndex = 4 * nodeIndex + 1; // Index du premier fils
-    return (childIndex >= tree->totalNodes); // Aucun fils valide
+    return nodeIndex >= tree->levelFirst[tree->depth]; // Dernier niveau
 }
 
 
 /**
  * Calcule la profondeur du QuadTree à partir de la taille de l'image.
  * 
- * @param size Taille de l'image.
- * @return La profondeur calculée.
+ * @param size Taille de l'image (plus grande de ses deux dimensions).
+ * @return La plus petite profondeur dont le carré contient l'image.
  */
 
 int calculateDepth(int size) {
-    return (int)log2(size); // Taille = largeur (ou hauteur) de l'image
+    int depth = 0;
+    while (depth < 30 && (1 << depth) < size) depth++;
+    return depth;
 }
 
 
 /**
- * Calcule la variance pour un noeud dans le QuadTree.
+ * Récupère l'index du parent d'un noeud donné.
  * 
- * @param tree Pointeur vers le QuadTree.
- * @param indexNode Index du noeud pour lequel calculer la variance.
+ * @param nodeIndex Index du noeud dont le parent est recherché.
+ * @return L'index du nœud parent, ou -1 pour la racine.
  */
-static void calculerVariance( QuadTree * tree , int indexNode ) {
-    
-    if (isLeaf(tree, indexNode)) {
-        tree->nodes[indexNode].var = 0 ; 
-        return;
+int getParentIndex(int nodeIndex) {
+    if (nodeIndex == 0) {
+        return -1;
     }
 
-    double mu = 0.0; 
-    int firstChildIndex = 4 * indexNode + 1;
-    for (int i = 0 ; i < 4 ; i++ ){
-        mu += (tree->nodes[firstChildIndex+i].var * tree->nodes[firstChildIndex+i].var ) + 
-        ((tree->nodes[indexNode].m -  tree->nodes[firstChildIndex+i].m )*(tree->nodes[indexNode].m -  tree->nodes[firstChildIndex+i].m));
-    }
-    
- tree->nodes[indexNode].var = sqrt(mu)/4 ; 
+    return (nodeIndex - 1) / 4;
 }
 
 
 /**
- * Récupère le parent d'un noeud donné.
+ * @brief Taille en octets des bits d'uniformité de `count` nœuds.
  * 
- * @param tree Pointeur vers le QuadTree.
- * @param nodeIndex Index du noeud dont le parent est recherché.
- * @return Pointeur vers le nœud parent, ou NULL sinon.
+ * Arrondie à un mot de 64 bits entier au-delà du dernier nœud, pour getChildIndex.
  */
-QuadTreeNode* getParentNode(QuadTree* tree, int nodeIndex) {    //cette fonction sert à retourner le parent d'un noeud passé en parametre ( indice )
-    if (nodeIndex == 0) {
+static size_t uniformBytes(int count) {
+    return ((size_t)(count + UNIFORM_BIT_OFFSET) / 64 + 1) * 8;
+}
+
+
+/**
+ * @brief Crée un QuadTree complet dont seuls les `stored` premiers nœuds sont alloués.
+ * 
+ * @param depth Profondeur du QuadTree (au plus MAX_TREE_DEPTH).
+ * @param stored Nombre de nœuds alloués (tous, ou les nœuds internes).
+ * @return Pointeur vers le QuadTree nouvellement créé, ou NULL en cas d'erreur.
+ */
+static QuadTree* allocQuadTree(int depth, int stored) {
+    if (depth < 0 || depth > MAX_TREE_DEPTH) {
+        fprintf(stderr, "Erreur : Profondeur %d trop grande pour un QuadTree complet (codage tuilé conseillé)\n", depth);
+        return NULL;
+    }
+    int totalNodes = (int)calculateTotalNodes(depth);
+
+    QuadTree* tree = (QuadTree*)calloc(1, sizeof(QuadTree));
+    if (!tree) {
+        perror("Erreur lors de l'allocation du QuadTree");
+        return NULL;
+    }
+
+    tree->m = (uint8_t*)malloc(stored);
+    tree->epsilon = (uint8_t*)malloc(stored);
+    tree->uniform = (uint8_t*)calloc(uniformBytes(stored), 1);
+    tree->levelFirst = (int*)malloc((depth + 2) * sizeof(int));
+    if (!tree->m || !tree->epsilon || !tree->uniform || !tree->levelFirst) {
+        perror("Erreur lors de l'allocation des nœuds du QuadTree");
+        freeQuadTree(tree);
         return NULL;
     }
+    for (int level = 0; level <= depth + 1; level++) tree->levelFirst[level] = levelStart(level);
 
-    int parentIndex = (nodeIndex - 1) / 4;
+    tree->totalNodes = totalNodes;
+    tree->capacity = stored;
+    tree->depth = depth;
+    tree->width = tree->height = 1 << depth;
 
-    return &tree->nodes[parentIndex];
+    return tree;
 }
 
 
 /**
  * Crée un QuadTree vide avec une profondeur.
  * 
- * @param depth Profondeur du QuadTree.
- * @return Pointeur vers le QuadTree nouvellement créé.
+ * Les variances ne sont pas allouées : voir allocVariance.
+ * 
+ * @param depth Profondeur du QuadTree (au plus MAX_TREE_DEPTH).
+ * @return Pointeur vers le QuadTree nouvellement créé, ou NULL en cas d'erreur.
  */
 QuadTree* createQuadTree(int depth) {
-    int totalNodes = calculateTotalNodes(depth);
+    if (depth < 0 || depth > MAX_TREE_DEPTH) return allocQuadTree(depth, 0);
+    return allocQuadTree(depth, (int)calculateTotalNodes(depth));
+}
+
 
-    QuadTree* tree = (QuadTree*)malloc(sizeof(QuadTree));
+/**
+ * Crée un QuadTree complet dont les feuilles sont les pixels d'une image, sans les stocker.
+ * 
+ * Un arbre de profondeur 0 (une seule feuille, la racine) stocke sa racine.
+ * 
+ * @param depth Profondeur du QuadTree (au plus MAX_TREE_DEPTH).
+ * @param pixels Pixels de l'image (coin haut-gauche du carré de l'arbre).
+ * @param stride Largeur d'une ligne de `pixels`.
+ * @return Pointeur vers le QuadTree nouvellement créé, ou NULL en cas d'erreur.
+ */
+QuadTree* createQuadTreeOverImage(int depth, const uint8_t* pixels, int stride) {
+    if (depth <= 0) return createQuadTree(depth);
+
+    QuadTree* tree = allocQuadTree(depth, levelStart(depth));
+    if (tree) {
+        tree->pixels = pixels;
+        tree->stride = stride;
+    }
+    return tree;
+}
+
+
+/**
+ * Crée un QuadTree creux ne contenant que la racine (voir reserveNodes pour l'agrandir).
+ * 
+ * @param depth Profondeur du QuadTree.
+ * @return Pointeur vers le QuadTree nouvellement créé, ou NULL en cas d'erreur.
+ */
+QuadTree* createSparseQuadTree(int depth) {
+    if (depth < 0 || depth > 30) {
+        fprintf(stderr, "Erreur : Profondeur %d invalide pour un QuadTree\n", depth);
+        return NULL;
+    }
+    QuadTree* tree = (QuadTree*)calloc(1, sizeof(QuadTree));
     if (!tree) {
         perror("Erreur lors de l'allocation du QuadTree");
         return NULL;
     }
-
-    tree->nodes = (QuadTreeNode*)malloc(totalNodes * sizeof(QuadTreeNode));
-    if (!tree->nodes) {
+    tree->depth = depth;
+    tree->width = tree->height = 1 << depth;
+    tree->sparse = 1;
+    tree->levelFirst = (int*)calloc(depth + 2, sizeof(int));
+    if (!tree->levelFirst || reserveNodes(tree, 1) != 0) {
         perror("Erreur lors de l'allocation des nœuds du QuadTree");
-        free(tree);
+        freeQuadTree(tree);
         return NULL;
     }
+    tree->totalNodes = 1;
+    tree->levelFirst[1] = 1;
+    return tree;
+}
 
-    tree->totalNodes = totalNodes;
-    tree->depth = depth;
 
-    return tree;
+/**
+ * Restreint un QuadTree à une image qui ne remplit pas forcément son carré.
+ * 
+ * Les indicateurs de bord ne sont alloués que si l'image ne remplit pas le carré ; ils
+ * sont nuls (bloc entièrement dans l'image) sauf pour la racine, qui contient la
+ * dernière ligne et la dernière colonne.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param width Largeur de l'image (entre 1 et 2^depth).
+ * @param height Hauteur de l'image (entre 1 et 2^depth).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int setImageSize(QuadTree* tree, int width, int height) {
+    int side = 1 << tree->depth;
+    if (width < 1 || height < 1 || width > side || height > side) {
+        fprintf(stderr, "Erreur : Image de %dx%d pixels incompatible avec un QuadTree de profondeur %d\n",
+                width, height, tree->depth);
+        return -1;
+    }
+
+    tree->width = width;
+    tree->height = height;
+    free(tree->border);
+    tree->border = NULL;
+    if (width == side && height == side) return 0;
+
+    tree->border = (uint8_t*)calloc(tree->capacity, 1);
+    if (!tree->border) {
+        perror("Erreur lors de l'allocation des bords du QuadTree");
+        return -1;
+    }
+    tree->border[0] = BORDER_RIGHT | BORDER_BOTTOM;
+    return 0;
+}
+
+
+/**
+ * Agrandit un QuadTree creux pour qu'il puisse contenir un nombre de nœuds donné.
+ * 
+ * La capacité croît au moins de moitié à chaque agrandissement. Les bits de décalage
+ * des bits d'uniformité sont mis à 1 pour ne pas être comptés dans les rangs.
+ * 
+ * @param tree Pointeur vers le QuadTree creux.
+ * @param count Nombre de nœuds à pouvoir stocker.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int reserveNodes(QuadTree* tree, int count) {
+    if (count <= tree->capacity) return 0;
+
+    int capacity = tree->capacity + tree->capacity / 2;
+    if (capacity < count) capacity = count;
+
+    uint8_t* m = (uint8_t*)realloc(tree->m, capacity);
+    if (m) tree->m = m;
+    uint8_t* epsilon = (uint8_t*)realloc(tree->epsilon, capacity);
+    if (epsilon) tree->epsilon = epsilon;
+    size_t oldBytes = tree->uniform ? uniformBytes(tree->capacity) : 0;
+    uint8_t* uniform = (uint8_t*)realloc(tree->uniform, uniformBytes(capacity));
+    if (uniform) {
+        memset(uniform + oldBytes, 0, uniformBytes(capacity) - oldBytes);
+        if (!oldBytes) uniform[0] = (1 << UNIFORM_BIT_OFFSET) - 1;
+        tree->uniform = uniform;
+    }
+    uint8_t* border = tree->border;
+    if (border) {
+        border = (uint8_t*)realloc(tree->border, capacity);
+        if (border) {
+            memset(border + tree->capacity, 0, capacity - tree->capacity);
+            tree->border = border;
+        }
+    }
+    if (!m || !epsilon || !uniform || (tree->border && !border)) {
+        perror("Erreur lors de l'agrandissement du QuadTree");
+        return -1;
+    }
+
+    tree->capacity = capacity;
+    return 0;
+}
+
+
+/**
+ * Construit l'index des rangs d'un QuadTree creux, après que ses nœuds ont été remplis.
+ * 
+ * @param tree Pointeur vers le QuadTree creux.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int buildRankIndex(QuadTree* tree) {
+    int words = (int)(uniformBytes(tree->totalNodes) / 8);
+    uint32_t* rank = (uint32_t*)realloc(tree->rank, words * sizeof(uint32_t));
+    if (!rank) {
+        perror("Erreur lors de l'allocation de l'index des rangs");
+        return -1;
+    }
+
+    // Les bits au-delà du dernier nœud ne sont jamais comptés par getChildIndex
+    uint32_t count = 0;
+    for (int w = 0; w < words; w++) {
+        rank[w] = count;
+        count += popcount64(~uniformWord(tree, w));
+    }
+    tree->rank = rank;
+    return 0;
+}
+
+
+/**
+ * @brief Indicateurs de bord d'un bloc qui touche l'image.
+ * 
+ * @param tree Pointeur vers le QuadTree (dimensions de l'image).
+ * @param x Coordonnée X du bloc (dans l'image).
+ * @param y Coordonnée Y du bloc (dans l'image).
+ * @param size Côté du bloc.
+ * @return BORDER_RIGHT si le bloc contient la dernière colonne, BORDER_BOTTOM s'il contient la dernière ligne.
+ */
+static uint8_t blockBorder(const QuadTree* tree, int x, int y, int size) {
+    uint8_t border = 0;
+    if ((int64_t)x + size >= tree->width) border |= BORDER_RIGHT;
+    if ((int64_t)y + size >= tree->height) border |= BORDER_BOTTOM;
+    return border;
+}
+
+
+/**
+ * @brief Recopie depuis l'image les quatre feuilles d'un bloc 2x2 gardé par l'élagage.
+ * 
+ * @param tree Pointeur vers le QuadTree à feuilles implicites.
+ * @param parent Position du bloc dans le niveau depth-1.
+ * @param first Index de destination de la première feuille.
+ */
+static void copyPixelLeaves(QuadTree* tree, int parent, int first) {
+    static const int dx[4] = { 0, 1, 1, 0 };
+    static const int dy[4] = { 0, 0, 1, 1 };
+    int bx, by;
+    blockPosition(parent, &bx, &by);
+
+    for (int i = 0; i < 4; i++) {
+        int x = 2 * bx + dx[i], y = 2 * by + dy[i];
+        int outside = x >= tree->width || y >= tree->height;
+        tree->m[first + i] = outside ? 0 : tree->pixels[(size_t)y * tree->stride + x];
+        tree->epsilon[first + i] = 0;
+        if (tree->border) tree->border[first + i] = outside ? BORDER_OUTSIDE : blockBorder(tree, x, y, 1);
+    }
+    setChildrenUniform(tree, (first - 1) / 4, 0xF);
+}
+
+
+/**
+ * Élague un QuadTree complet pour n'en garder que les nœuds codés.
+ * 
+ * Les nœuds gardés d'un niveau sont les enfants des nœuds gardés non uniformes du niveau
+ * précédent, repérés par un masque de bits (un bit par bloc du niveau). Chaque nœud est
+ * recopié à un index inférieur ou égal au sien, dans l'ordre croissant : la compaction
+ * peut se faire sur place.
+ * 
+ * Les feuilles gardées d'un arbre à feuilles implicites (voir createQuadTreeOverImage)
+ * sont lues dans ses pixels, après avoir agrandi les tableaux à la taille de l'arbre élagué.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int pruneQuadTree(QuadTree* tree) {
+    if (tree->sparse) return 0;
+
+    int depth = tree->depth;
+    size_t maskWords = depth > 0 ? ((size_t)1 << (2 * (depth - 1))) / 64 + 1 : 1;
+    uint64_t* masks = (uint64_t*)calloc(2 * maskWords, sizeof(uint64_t));
+    if (!masks) {
+        perror("Erreur lors de l'allocation du masque d'élagage");
+        return -1;
+    }
+    uint64_t* expand = masks;             // nœuds gardés non uniformes du niveau précédent
+    uint64_t* next = masks + maskWords;   // ceux du niveau courant
+
+    // La racine reste à sa place
+    int count = 1;
+    expand[0] = (depth > 0 && !isUniform(tree, 0));
+    tree->levelFirst[0] = 0;
+
+    for (int level = 1; level <= depth; level++) {
+        tree->levelFirst[level] = count;
+        int last = (level == depth);
+        size_t words = ((size_t)1 << (2 * (level - 1))) / 64 + 1;
+        if (!last) memset(next, 0, (((size_t)1 << (2 * level)) / 64 + 1) * sizeof(uint64_t));
+
+        if (last && tree->pixels) {
+            int groups = 0;
+            for (size_t w = 0; w < words; w++) groups += popcount64(expand[w]);
+            if (reserveNodes(tree, count + 4 * groups) != 0) {
+                free(masks);
+                return -1;
+            }
+            for (size_t w = 0; w < words; w++) {
+                for (uint64_t bits = expand[w]; bits; bits &= bits - 1) {
+                    copyPixelLeaves(tree, (int)(64 * w + __builtin_ctzll(bits)), count);
+                    count += 4;
+                }
+            }
+            break;
+        }
+
+        for (size_t w = 0; w < words; w++) {
+            for (uint64_t bits = expand[w]; bits; bits &= bits - 1) {
+                size_t parent = 64 * w + __builtin_ctzll(bits);
+                int child = levelStart(level) + 4 * (int)parent;
+                uint8_t mask = 0;
+                for (int i = 0; i < 4; i++) {
+                    uint8_t uniform = isUniform(tree, child + i);
+                    tree->m[count + i] = tree->m[child + i];
+                    tree->epsilon[count + i] = tree->epsilon[child + i];
+                    if (tree->border) tree->border[count + i] = tree->border[child + i];
+                    mask |= uniform << i;
+                    if (!last && !uniform) {
+                        size_t b = 4 * parent + i;
+                        next[b >> 6] |= (uint64_t)1 << (b & 63);
+                    }
+                }
+                setChildrenUniform(tree, (count - 1) / 4, mask);
+                count += 4;
+            }
+        }
+
+        uint64_t* swap = expand;
+        expand = next;
+        next = swap;
+    }
+    tree->levelFirst[depth + 1] = count;
+    free(masks);
+
+    free(tree->moments);
+    tree->moments = NULL;
+    tree->momentNodes = 0;
+    tree->totalNodes = count;
+    tree->capacity = count;
+    tree->sparse = 1;
+    tree->pixels = NULL;
+
+    // Réduire les tableaux à la taille de l'arbre élagué
+    uint8_t* m = (uint8_t*)realloc(tree->m, count);
+    if (m) tree->m = m;
+    uint8_t* epsilon = (uint8_t*)realloc(tree->epsilon, count);
+    if (epsilon) tree->epsilon = epsilon;
+    uint8_t* uniform = (uint8_t*)realloc(tree->uniform, uniformBytes(count));
+    if (uniform) tree->uniform = uniform;
+    tree->uniform[0] |= (1 << UNIFORM_BIT_OFFSET) - 1;
+    if (tree->border) {
+        uint8_t* border = (uint8_t*)realloc(tree->border, count);
+        if (border) tree->border = border;
+    }
+
+    return buildRankIndex(tree);
+}
+
+
+/**
+ * Trouve le nœud qui couvre un bloc d'un niveau : le nœud lui-même, ou, s'il n'est pas
+ * stocké, son ancêtre uniforme le plus proche.
+ * 
+ * Les chiffres en base 4 de la position donnent l'enfant choisi à chaque niveau.
+ * 
+ * @param tree Pointeur vers le QuadTree (index des rangs à jour s'il est creux).
+ * @param level Niveau du bloc.
+ * @param offset Position du bloc dans son niveau (index complet - levelStart(niveau)).
+ * @param nodeLevel Pointeur où stocker le niveau du nœud trouvé.
+ * @return L'index du nœud trouvé.
+ */
+int findNode(const QuadTree* tree, int level, int offset, int* nodeLevel) {
+    int nodeIndex = 0;
+    int l = 0;
+    while (l < level && !isUniform(tree, nodeIndex)) {
+        l++;
+        nodeIndex = getChildIndex(tree, nodeIndex) + ((offset >> (2 * (level - l))) & 3);
+    }
+    *nodeLevel = l;
+    return nodeIndex;
+}
+
+
+/**
+ * Alloue les sommes des blocs d'un QuadTree (nécessaires uniquement pour le filtrage).
+ * 
+ * Les feuilles d'un arbre dont les feuilles sont des pixels ne stockent pas leurs
+ * sommes : les trois quarts des nœuds n'occupent ainsi aucune place.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param leaves 1 pour stocker aussi les sommes des feuilles.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int allocVariance(QuadTree* tree, int leaves) {
+    if (tree->moments) return 0;
+
+    int nodes = leaves ? tree->totalNodes : levelStart(tree->depth);
+    tree->moments = (BlockMoments*)malloc((nodes > 0 ? nodes : 1) * sizeof(BlockMoments));
+    if (!tree->moments) {
+        perror("Erreur lors de l'allocation des variances du QuadTree");
+        return -1;
+    }
+    tree->momentNodes = nodes;
+    return 0;
+}
+
+
+/**
+ * Renvoie l'écart type des pixels d'un bloc, calculé à partir de ses sommes.
+ * 
+ * Le numérateur n * somme(x^2) - somme(x)^2 est exact (entier sur 64 ou 128 bits) : seule
+ * la racine finale est arrondie, de la même façon sur toutes les plateformes.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index du nœud.
+ * @return L'écart type, 0 pour une feuille ou si les sommes ne sont pas allouées.
+ */
+double getNodeVar(const QuadTree* tree, int nodeIndex) {
+    if (nodeIndex >= tree->momentNodes) return 0.0;
+
+    const BlockMoments* b = &tree->moments[nodeIndex];
+    if (b->count == 0) return 0.0;
+
+    // Jusqu'à 2^23 pixels (blocs de 2048x2048), n * somme(x^2) < 2^62
+    double spread;
+    if (b->count < ((uint64_t)1 << 23)) {
+        spread = (double)(int64_t)(b->count * b->sumSq - b->sum * b->sum);
+    } else {
+        spread = (double)((unsigned __int128)b->count * b->sumSq - (unsigned __int128)b->sum * b->sum);
+    }
+    return sqrt(spread) / (double)b->count;
 }
 
 
@@ -124,51 +594,715 @@ QuadTree* createQuadTree(int depth) {
 
 void freeQuadTree(QuadTree* tree) {
     if (tree) {
-        free(tree->nodes);
+        free(tree->m);
+        free(tree->epsilon);
+        free(tree->uniform);
+        free(tree->moments);
+        free(tree->border);
+        free(tree->rank);
+        free(tree->levelFirst);
         free(tree);
     }
 }
 
 
 /**
- * @brief Calcule la moyenne des intensités et vérifie l'uniformité d'un bloc d'image.
+ * Renvoie la mémoire allouée pour un QuadTree, en octets.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @return La taille des tableaux du QuadTree et de sa structure.
+ */
+size_t quadTreeBytes(const QuadTree* tree) {
+    size_t bytes = sizeof(QuadTree) + (tree->depth + 2) * sizeof(int);
+    if (tree->m) bytes += 2 * (size_t)tree->capacity + uniformBytes(tree->capacity); // m, epsilon, uniform
+    if (tree->moments) bytes += (size_t)tree->momentNodes * sizeof(BlockMoments);
+    if (tree->border) bytes += tree->capacity;
+    if (tree->rank) bytes += uniformBytes(tree->totalNodes) / 8 * sizeof(uint32_t);
+    return bytes;
+}
+
+
+/**
+ * Compte les nœuds calculés par le remplissage d'un QuadTree complet (voir fillQuadTree).
+ * 
+ * Ce sont les nœuds stockés qui touchent l'image (les feuilles d'un arbre créé par
+ * createQuadTreeOverImage sont lues dans les pixels), moins les descendants des blocs
+ * de 2^FLAT_BLOCK_DEPTH pixels déclarés uniformes sans être construits. Un tel bloc est
+ * entièrement dans l'image, et c'est le seul cas où un nœud de ce niveau est uniforme.
+ * 
+ * @param tree Pointeur vers le QuadTree complet, rempli.
+ * @return Le nombre de nœuds calculés.
+ */
+uint64_t filledNodes(const QuadTree* tree) {
+    int depth = tree->depth;
+    int levels = tree->pixels ? depth : depth + 1; // niveaux stockés
+    uint64_t nodes = 0;
+    for (int level = 0; level < levels; level++) {
+        nodes += (uint64_t)coveringBlocks(tree->width, depth - level) * coveringBlocks(tree->height, depth - level);
+    }
+    if (depth <= FLAT_BLOCK_DEPTH) return nodes;
+
+    // Descendants stockés d'un bloc déclaré uniforme
+    int level = depth - FLAT_BLOCK_DEPTH;
+    uint64_t skipped = levelStart(levels - level) - 1;
+    int cols = tree->width >> FLAT_BLOCK_DEPTH, rows = tree->height >> FLAT_BLOCK_DEPTH;
+    for (int by = 0; by < rows; by++) {
+        for (int bx = 0; bx < cols; bx++) {
+            if (isUniform(tree, levelStart(level) + blockOffset(bx, by))) nodes -= skipped;
+        }
+    }
+    return nodes;
+}
+
+
+/**
+ * @brief Calcule les sommes d'un noeud interne en additionnant celles de ses enfants dans l'image.
+ * 
+ * @param tree Pointeur vers le QuadTree (sommes allouées).
+ * @param nodeIndex Index du noeud à calculer.
+ * @param childIndex Index du premier des quatre enfants (contigus).
+ * @param outside Enfants hors de l'image (bit k pour l'enfant k), ignorés.
+ */
+static void momentsFromChildren(QuadTree* tree, int nodeIndex, int childIndex, uint8_t outside) {
+    BlockMoments total = { 0, 0, 0 };
+    for (int i = 0; i < 4; i++) {
+        if (outside & (1 << i)) continue;
+        BlockMoments child = getNodeMoments(tree, childIndex + i);
+        total.sum += child.sum;
+        total.sumSq += child.sumSq;
+        total.count += child.count;
+    }
+    tree->moments[nodeIndex] = total;
+}
+
+
+/**
+ * @brief Calcule un noeud interne à partir de ses quatre enfants (m, epsilon, uniform, sommes).
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index du noeud à calculer.
+ */
+static void computeFromChildren(QuadTree* tree, int nodeIndex) {
+    int c = 4 * nodeIndex + 1;
+
+    // Les quatre moyennes en un mot : sommes par paires d'octets, puis des deux paires
+    uint32_t cm;
+    memcpy(&cm, &tree->m[c], sizeof(cm));
+    uint32_t pairs = (cm & 0x00FF00FFu) + ((cm >> 8) & 0x00FF00FFu);
+    uint32_t sum = (pairs & 0xFFFF) + (pairs >> 16);
+
+    tree->epsilon[nodeIndex] = sum % 4;
+    tree->m[nodeIndex] = sum / 4;
+    setUniform(tree, nodeIndex, getChildrenUniform(tree, nodeIndex) == 0xF && cm == (cm & 0xFF) * 0x01010101u);
+    if (tree->moments) momentsFromChildren(tree, nodeIndex, c, 0);
+}
+
+
+/**
+ * @brief Calcule un noeud au bord de l'image à partir de ses enfants qui sont dans l'image.
  * 
- * Cette fonction analyse un bloc rectangulaire d'une image représentée par un tableau de pixels.
- * Elle calcule la moyenne des intensités dans le bloc et détermine si toutes les intensités 
- * du bloc sont identiques.
+ * Les enfants hors de l'image deviennent des noeuds uniformes, sans descendants
+ * calculés ; avec k enfants dans l'image, m = somme / k et epsilon = somme % k (les
+ * sommes des pixels ne portent que sur ces enfants). Les indicateurs de bord du noeud doivent
+ * être à jour ; ceux des enfants dans l'image le sont déjà.
  * 
- * @param data Tableau contenant les pixels de l'image.
- * @param startX Coordonnée X de départ du bloc.
- * @param startY Coordonnée Y de départ du bloc.
- * @param size Taille du bloc 
- * @param width Largeur de l'image (utilisée pour le calcul des indices).
- * @param m Pointeur où la moyenne des intensités du bloc sera stockée.
- * @param uniform Pointeur où sera stocké 1 si le bloc est uniforme, 0 sinon.
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index du noeud à calculer.
+ * @param level Niveau du noeud.
  */
-static void computeBlock(uint8_t* data, int startX, int startY, int size, int width, uint8_t* m, uint8_t* uniform) {
-    int sum = 0;
-    uint8_t firstValue = data[startY * width + startX];
-    *uniform = 1; // Supposer uniforme par défaut
+static void computeFromInsideChildren(QuadTree* tree, int nodeIndex, int level) {
+    int c = 4 * nodeIndex + 1;
+    uint8_t borders[4];
+    uint8_t outside = childBorders(tree, level, tree->border[nodeIndex], borders);
+    int sum = 0, count = 0, uniform = 1;
+    const BlockMoments none = { 0, 0, 0 };
+
+    // L'enfant haut-gauche est toujours dans l'image
+    for (int i = 0; i < 4; i++) {
+        if (outside & (1 << i)) {
+            tree->border[c + i] = BORDER_OUTSIDE;
+            tree->m[c + i] = 0;
+            tree->epsilon[c + i] = 0;
+            setUniform(tree, c + i, 1);
+            setNodeMoments(tree, c + i, none);
+            continue;
+        }
+        if (!isUniform(tree, c + i) || tree->m[c + i] != tree->m[c]) uniform = 0;
+        sum += tree->m[c + i];
+        count++;
+    }
+
+    tree->m[nodeIndex] = sum / count;
+    tree->epsilon[nodeIndex] = sum % count;
+    setUniform(tree, nodeIndex, uniform);
+    if (tree->moments) momentsFromChildren(tree, nodeIndex, c, outside);
+}
 
-    for (int y = startY; y < startY + size; y++) {
-        for (int x = startX; x < startX + size; x++) {
-            uint8_t value = data[y * width + x];
-            sum += value;
 
-            // Vérifier l'uniformité
-            if (value != firstValue) {
-                *uniform = 0;
+/**
+ * @brief Calcule un bloc 2x2 au bord de l'image à partir de ses pixels dans l'image.
+ * 
+ * Même calcul que computeFromInsideChildren, pour un arbre dont les feuilles ne sont pas
+ * stockées (voir createQuadTreeOverImage).
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param data Tableau contenant les données de l'image.
+ * @param width Largeur d'une ligne de pixels de `data`.
+ * @param nodeIndex Index du bloc à calculer.
+ * @param x Coordonnée X du bloc (relative à `data`).
+ * @param y Coordonnée Y du bloc (relative à `data`).
+ */
+static void computeFromInsidePixels(QuadTree* tree, const uint8_t* data, int width, int nodeIndex, int x, int y) {
+    static const int dx[4] = { 0, 1, 1, 0 };
+    static const int dy[4] = { 0, 0, 1, 1 };
+    uint8_t first = data[(size_t)y * width + x];
+    BlockMoments total = { 0, 0, 0 };
+    int uniform = 1;
+
+    for (int i = 0; i < 4; i++) {
+        if (x + dx[i] >= tree->width || y + dy[i] >= tree->height) continue;
+        uint8_t v = data[(size_t)(y + dy[i]) * width + x + dx[i]];
+        if (v != first) uniform = 0;
+        total.sum += v;
+        total.sumSq += (uint64_t)v * v;
+        total.count++;
+    }
+
+    tree->m[nodeIndex] = (uint8_t)(total.sum / total.count);
+    tree->epsilon[nodeIndex] = (uint8_t)(total.sum % total.count);
+    setUniform(tree, nodeIndex, uniform);
+    if (tree->moments) tree->moments[nodeIndex] = total;
+}
+
+
+/**
+ * @brief Intercale des bits nuls entre les bits d'un entier (bit k -> bit 2k).
+ * 
+ * @param v Valeur sur 16 bits au plus.
+ * @return La valeur étalée.
+ */
+static uint32_t spreadBits(uint32_t v) {
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+
+/**
+ * @brief Regroupe les bits de rang pair d'un entier (bit 2k -> bit k).
+ * 
+ * @param v Valeur étalée.
+ * @return La valeur compactée.
+ */
+static uint32_t compactBits(uint32_t v) {
+    v &= 0x55555555;
+    v = (v | (v >> 1)) & 0x33333333;
+    v = (v | (v >> 2)) & 0x0F0F0F0F;
+    v = (v | (v >> 4)) & 0x00FF00FF;
+    v = (v | (v >> 8)) & 0x0000FFFF;
+    return v;
+}
+
+
+/**
+ * @brief Position d'un bloc (bx, by) dans son niveau, dans l'ordre des noeuds du QuadTree.
+ * 
+ * Les enfants sont rangés haut-gauche, haut-droit, bas-droit, bas-gauche : le chiffre
+ * en base 4 de chaque niveau vaut 2 * by + (bx ^ by).
+ * 
+ * @param sx Coordonnée X du bloc, étalée par spreadBits.
+ * @param sy Coordonnée Y du bloc, étalée par spreadBits.
+ * @return L'index du bloc relatif au premier noeud du niveau.
+ */
+static uint32_t blockCode(uint32_t sx, uint32_t sy) {
+    return (sy << 1) | (sx ^ sy);
+}
+
+
+/**
+ * @brief Réduit deux lignes de pixels en blocs 2x2 (moyenne, epsilon, uniformité).
+ * 
+ * La somme des pixels d'un bloc vaut 4 * m + epsilon ; celle de leurs carrés n'est
+ * calculée que si `sq` est donné.
+ * 
+ * @param r0 Ligne haute.
+ * @param r1 Ligne basse.
+ * @param count Nombre de blocs 2x2 à réduire.
+ * @param m Tableau recevant les moyennes.
+ * @param eps Tableau recevant les epsilons.
+ * @param uni Tableau recevant les indicateurs d'uniformité.
+ * @param sq Tableau recevant les sommes des carrés des pixels, ou NULL.
+ */
+static void reduceRows2x2(const uint8_t* r0, const uint8_t* r1, int count, uint8_t* m, uint8_t* eps, uint8_t* uni,
+                          uint32_t* sq) {
+    int bx = 0;
+#ifdef __SSE2__
+    const __m128i lowMask = _mm_set1_epi16(0x00FF);
+    const __m128i three = _mm_set1_epi16(3);
+    const __m128i one = _mm_set1_epi16(1);
+
+    for (; bx + 8 <= count; bx += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(r0 + 2 * bx));
+        __m128i b = _mm_loadu_si128((const __m128i*)(r1 + 2 * bx));
+
+        // Pixels gauche (pairs) et droit (impairs) de chaque bloc, sur 16 bits
+        __m128i tl = _mm_and_si128(a, lowMask);
+        __m128i tr = _mm_srli_epi16(a, 8);
+        __m128i bl = _mm_and_si128(b, lowMask);
+        __m128i br = _mm_srli_epi16(b, 8);
+
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(tl, tr), _mm_add_epi16(bl, br));
+        __m128i same = _mm_and_si128(_mm_cmpeq_epi16(tl, tr),
+                       _mm_and_si128(_mm_cmpeq_epi16(tl, bl), _mm_cmpeq_epi16(tl, br)));
+
+        __m128i vm = _mm_srli_epi16(sum, 2);
+        __m128i ve = _mm_and_si128(sum, three);
+        __m128i vu = _mm_and_si128(same, one);
+
+        _mm_storel_epi64((__m128i*)(m + bx), _mm_packus_epi16(vm, vm));
+        _mm_storel_epi64((__m128i*)(eps + bx), _mm_packus_epi16(ve, ve));
+        _mm_storel_epi64((__m128i*)(uni + bx), _mm_packus_epi16(vu, vu));
+
+        if (sq) {
+            // Pixels sur 16 bits : madd additionne les carrés des deux pixels d'une ligne du bloc
+            const __m128i zero = _mm_setzero_si128();
+            __m128i a0 = _mm_unpacklo_epi8(a, zero), a1 = _mm_unpackhi_epi8(a, zero);
+            __m128i b0 = _mm_unpacklo_epi8(b, zero), b1 = _mm_unpackhi_epi8(b, zero);
+            _mm_storeu_si128((__m128i*)(sq + bx), _mm_add_epi32(_mm_madd_epi16(a0, a0), _mm_madd_epi16(b0, b0)));
+            _mm_storeu_si128((__m128i*)(sq + bx + 4), _mm_add_epi32(_mm_madd_epi16(a1, a1), _mm_madd_epi16(b1, b1)));
+        }
+    }
+#endif
+    for (; bx < count; bx++) {
+        uint8_t tl = r0[2 * bx], tr = r0[2 * bx + 1];
+        uint8_t bl = r1[2 * bx], br = r1[2 * bx + 1];
+        int sum = tl + tr + bl + br;
+        m[bx] = sum / 4;
+        eps[bx] = sum % 4;
+        uni[bx] = (tl == tr && tl == bl && tl == br);
+        if (sq) sq[bx] = tl * tl + tr * tr + bl * bl + br * br;
+    }
+}
+
+
+/**
+ * @brief Calcule les noeuds d'un niveau qui touchent l'image, à partir de leurs enfants.
+ * 
+ * Les blocs sont parcourus ligne par ligne, en s'arrêtant au bord de l'image : les blocs
+ * qui en sont entièrement sortis ne sont pas visités.
+ * 
+ * @param tree Pointeur vers le QuadTree (indicateurs de bord alloués).
+ * @param first Index du premier noeud du niveau dans le sous-arbre.
+ * @param level Niveau des noeuds dans l'arbre entier.
+ * @param startX Coordonnée X du sous-arbre.
+ * @param startY Coordonnée Y du sous-arbre.
+ * @param shift Côté des blocs du niveau : 2^shift.
+ * @param blocks Nombre de blocs du niveau par ligne du sous-arbre.
+ */
+static void computeClippedLevel(QuadTree* tree, long first, int level, int startX, int startY, int shift, int blocks) {
+    int cols = coveringBlocks(tree->width - startX, shift);
+    int rows = coveringBlocks(tree->height - startY, shift);
+    if (cols > blocks) cols = blocks;
+    if (rows > blocks) rows = blocks;
+
+    for (int by = 0; by < rows; by++) {
+        uint32_t sy = spreadBits(by);
+        for (int bx = 0; bx < cols; bx++) {
+            long i = first + blockCode(spreadBits(bx), sy);
+            uint8_t border = blockBorder(tree, startX + (bx << shift), startY + (by << shift), 1 << shift);
+            tree->border[i] = border;
+            if (border) computeFromInsideChildren(tree, i, level);
+            else computeFromChildren(tree, i);
+        }
+    }
+}
+
+
+/**
+ * @brief Remplit un sous-arbre d'un QuadTree dont l'image ne remplit pas le carré.
+ * 
+ * Même parcours que fillQuadTree, limité aux blocs qui touchent l'image : les blocs 2x2
+ * entièrement dans l'image sont réduits de la même façon, ceux qui débordent et les
+ * noeuds au bord sont calculés à partir de leurs seuls enfants dans l'image. La racine
+ * du sous-arbre doit toucher l'image.
+ * 
+ * @param tree Pointeur vers le QuadTree (indicateurs de bord alloués).
+ * @param data Tableau contenant les données de l'image.
+ * @param width Largeur d'une ligne de pixels de `data`.
+ * @param depth Profondeur du sous-arbre (au plus FLAT_BLOCK_DEPTH).
+ * @param nodeIndex Index de la racine du sous-arbre.
+ * @param startX Coordonnée X de départ.
+ * @param startY Coordonnée Y de départ.
+ * @param size Taille de la zone à analyser.
+ */
+static void fillClippedQuadTree(QuadTree* tree, const uint8_t* data, int width, int depth, int nodeIndex,
+                                int startX, int startY, int size) {
+    static const int dx[4] = { 0, 1, 1, 0 };
+    static const int dy[4] = { 0, 0, 1, 1 };
+    int base = tree->depth - depth;   // niveau de la racine du sous-arbre
+
+    if (depth == 0) {
+        setNodeM(tree, nodeIndex, data[(size_t)startY * width + startX]);
+        setUniform(tree, nodeIndex, 1);
+        setNodeEpsilon(tree, nodeIndex, 0);
+        tree->border[nodeIndex] = blockBorder(tree, startX, startY, 1);
+        return;
+    }
+
+    int half = size / 2;
+    int cols = coveringBlocks(tree->width - startX, 1);
+    int rows = coveringBlocks(tree->height - startY, 1);
+    int fullCols = (tree->width - startX) / 2;
+    if (cols > half) cols = half;
+    if (rows > half) rows = half;
+    if (fullCols > half) fullCols = half;
+
+    uint8_t rowM[FLAT_BLOCK_SIZE / 2], rowE[FLAT_BLOCK_SIZE / 2], rowU[FLAT_BLOCK_SIZE / 2];
+    uint32_t sqBuf[FLAT_BLOCK_SIZE / 2];
+    uint32_t* rowSq = tree->moments ? sqBuf : NULL;
+
+    long levelSize = 1L << (2 * (depth - 1));
+    long levelFirst = nodeIndex * levelSize + (levelSize - 1) / 3;
+
+    for (int by = 0; by < rows; by++) {
+        int y = startY + 2 * by;
+        int fullRow = (y + 1 < tree->height);
+        const uint8_t* r0 = data + (size_t)y * width + startX;
+        const uint8_t* r1 = fullRow ? r0 + width : r0;
+        int full = fullRow ? fullCols : 0;
+        reduceRows2x2(r0, r1, full, rowM, rowE, rowU, rowSq);
+
+        uint32_t sy = spreadBits(by);
+        for (int bx = 0; bx < cols; bx++) {
+            int p = levelFirst + blockCode(spreadBits(bx), sy);
+            int c = 4 * p + 1;
+            int x = startX + 2 * bx;
+            tree->border[p] = blockBorder(tree, x, y, 2);
+
+            if (bx >= full && tree->pixels) {
+                computeFromInsidePixels(tree, data, width, p, x, y);
+                continue;
+            }
+            if (bx >= full) {
+                // Bloc qui déborde : seules les feuilles dans l'image sont lues
+                for (int i = 0; i < 4; i++) {
+                    if (x + dx[i] >= tree->width || y + dy[i] >= tree->height) continue;
+                    tree->m[c + i] = data[(size_t)(y + dy[i]) * width + x + dx[i]];
+                    tree->epsilon[c + i] = 0;
+                    setUniform(tree, c + i, 1);
+                    tree->border[c + i] = blockBorder(tree, x + dx[i], y + dy[i], 1);
+                }
+                computeFromInsideChildren(tree, p, base + depth - 1);
+                continue;
+            }
+
+            if (!tree->pixels) {
+                uint8_t* leaves = &tree->m[c];
+                leaves[0] = r0[2 * bx];
+                leaves[1] = r0[2 * bx + 1];
+                leaves[2] = r1[2 * bx + 1];
+                leaves[3] = r1[2 * bx];
+                memset(&tree->epsilon[c], 0, 4);
+                for (int i = 0; i < 4; i++) setUniform(tree, c + i, 1);
+                if (tree->border[p]) {
+                    for (int i = 0; i < 4; i++) tree->border[c + i] = blockBorder(tree, x + dx[i], y + dy[i], 1);
+                }
+            }
+
+            tree->m[p] = rowM[bx];
+            tree->epsilon[p] = rowE[bx];
+            setUniform(tree, p, rowU[bx]);
+            if (rowSq) {
+                BlockMoments block = { 4u * rowM[bx] + rowE[bx], rowSq[bx], 4 };
+                tree->moments[p] = block;
+            }
+        }
+    }
+
+    for (int level = depth - 2; level >= 0; level--) {
+        levelSize = 1L << (2 * level);
+        levelFirst = nodeIndex * levelSize + (levelSize - 1) / 3;
+        computeClippedLevel(tree, levelFirst, base + level, startX, startY, depth - level, 1 << level);
+    }
+}
+
+
+/**
+ * @brief Remplit un sous-arbre d'au plus FLAT_BLOCK_DEPTH niveaux, couvert par l'image.
+ * 
+ * Les deux lignes de pixels de chaque rangée de blocs 2x2 sont réduites ensemble (feuilles,
+ * si elles sont stockées, et premier niveau interne), puis chaque niveau supérieur est calculé à partir de ses
+ * quatre enfants contigus.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param data Tableau contenant les données de l'image.
+ * @param width Largeur d'une ligne de pixels de `data`.
+ * @param depth Profondeur du sous-arbre (entre 1 et FLAT_BLOCK_DEPTH).
+ * @param nodeIndex Index de la racine du sous-arbre.
+ * @param startX Coordonnée X de départ.
+ * @param startY Coordonnée Y de départ.
+ * @param size Taille de la zone à analyser.
+ */
+static void fillBlockLevels(QuadTree* tree, const uint8_t* data, int width, int depth, int nodeIndex,
+                            int startX, int startY, int size) {
+    int half = size / 2;
+    uint8_t rowM[FLAT_BLOCK_SIZE / 2], rowE[FLAT_BLOCK_SIZE / 2], rowU[FLAT_BLOCK_SIZE / 2];
+    uint32_t sqBuf[FLAT_BLOCK_SIZE / 2];
+    uint32_t* rowSq = tree->moments ? sqBuf : NULL;
+
+    // Premier noeud du niveau depth-1 du sous-arbre (blocs 2x2)
+    long levelSize = 1L << (2 * (depth - 1));
+    long levelFirst = nodeIndex * levelSize + (levelSize - 1) / 3;
+
+    for (int by = 0; by < half; by++) {
+        const uint8_t* r0 = data + (size_t)(startY + 2 * by) * width + startX;
+        const uint8_t* r1 = r0 + width;
+        reduceRows2x2(r0, r1, half, rowM, rowE, rowU, rowSq);
+
+        uint32_t sy = spreadBits(by);
+        for (int bx = 0; bx < half; bx++) {
+            int p = levelFirst + blockCode(spreadBits(bx), sy);
+            int c = 4 * p + 1;
+
+            // Feuilles : haut-gauche, haut-droit, bas-droit, bas-gauche (sauf si implicites)
+            if (!tree->pixels) {
+                uint8_t* leaves = &tree->m[c];
+                leaves[0] = r0[2 * bx];
+                leaves[1] = r0[2 * bx + 1];
+                leaves[2] = r1[2 * bx + 1];
+                leaves[3] = r1[2 * bx];
+                memset(&tree->epsilon[c], 0, 4);
+                for (int i = 0; i < 4; i++) setUniform(tree, c + i, 1);
+            }
+
+            tree->m[p] = rowM[bx];
+            tree->epsilon[p] = rowE[bx];
+            setUniform(tree, p, rowU[bx]);
+            if (rowSq) {
+                BlockMoments block = { 4u * rowM[bx] + rowE[bx], rowSq[bx], 4 };
+                tree->moments[p] = block;
+            }
+        }
+    }
+
+    // Niveaux supérieurs : les quatre enfants d'un noeud sont contigus dans le tableau
+    for (int level = depth - 2; level >= 0; level--) {
+        levelSize = 1L << (2 * level);
+        levelFirst = nodeIndex * levelSize + (levelSize - 1) / 3;
+        for (long i = levelFirst; i < levelFirst + levelSize; i++) {
+            computeFromChildren(tree, i);
+        }
+    }
+}
+
+
+/**
+ * @brief Position (ligne * 8 + colonne) du k-ième bloc 2x2 d'un bloc de 16x16 pixels dans
+ * son niveau (voir blockPosition).
+ */
+static const uint8_t block16Order[64] = {
+     0,  1,  9,  8,  2,  3, 11, 10, 18, 19, 27, 26, 16, 17, 25, 24,
+     4,  5, 13, 12,  6,  7, 15, 14, 22, 23, 31, 30, 20, 21, 29, 28,
+    36, 37, 45, 44, 38, 39, 47, 46, 54, 55, 63, 62, 52, 53, 61, 60,
+    32, 33, 41, 40, 34, 35, 43, 42, 50, 51, 59, 58, 48, 49, 57, 56
+};
+
+
+/**
+ * @brief Remplit un sous-arbre de profondeur 4 (16x16 pixels) à feuilles implicites, dans l'image.
+ * 
+ * Version de fillBlockLevels pour cette profondeur : les 64 blocs 2x2 sont d'abord réduits
+ * ligne par ligne dans des tableaux locaux, puis recopiés dans l'ordre des nœuds par une
+ * table de permutation. Leurs bits d'uniformité forment un mot de 64 bits aligné sur un
+ * octet (premier nœud 64 * nodeIndex + 21), écrit d'un coup au lieu de bit par bit.
+ * 
+ * @param tree Pointeur vers le QuadTree (feuilles implicites, voir createQuadTreeOverImage).
+ * @param data Pixel haut-gauche du bloc.
+ * @param width Largeur d'une ligne de pixels de `data`.
+ * @param nodeIndex Index de la racine du sous-arbre.
+ */
+static void fillBlock16(QuadTree* tree, const uint8_t* data, int width, int nodeIndex) {
+    uint8_t rowM[64], rowE[64], rowU[64];
+    uint32_t sqBuf[64];
+    uint32_t* rowSq = tree->moments ? sqBuf : NULL;
+
+    for (int by = 0; by < 8; by++) {
+        const uint8_t* r0 = data + (size_t)(2 * by) * width;
+        reduceRows2x2(r0, r0 + width, 8, rowM + 8 * by, rowE + 8 * by, rowU + 8 * by, rowSq ? rowSq + 8 * by : NULL);
+    }
+
+    long first = 64L * nodeIndex + 21;
+    uint8_t* m = &tree->m[first];
+    uint8_t* epsilon = &tree->epsilon[first];
+    uint64_t uniform = 0;
+    for (int k = 0; k < 64; k++) {
+        int r = block16Order[k];
+        m[k] = rowM[r];
+        epsilon[k] = rowE[r];
+        uniform |= (uint64_t)rowU[r] << k;
+        if (rowSq) {
+            BlockMoments block = { 4u * rowM[r] + rowE[r], rowSq[r], 4 };
+            tree->moments[first + k] = block;
+        }
+    }
+    uint8_t* bits = &tree->uniform[(first + UNIFORM_BIT_OFFSET) >> 3];
+    for (int i = 0; i < 8; i++) bits[i] = (uint8_t)(uniform >> (8 * i));
+
+    // Blocs 4x4, blocs 8x8, racine
+    for (long i = 16L * nodeIndex + 5; i < 16L * nodeIndex + 21; i++) computeFromChildren(tree, i);
+    for (long i = 4L * nodeIndex + 1; i < 4L * nodeIndex + 5; i++) computeFromChildren(tree, i);
+    computeFromChildren(tree, nodeIndex);
+}
+
+
+/**
+ * @brief Indique si tous les pixels d'un bloc de 2^FLAT_BLOCK_DEPTH pixels de côté sont égaux.
+ * 
+ * @param block Pixel haut-gauche du bloc.
+ * @param width Largeur d'une ligne de pixels.
+ * @return 1 si le bloc est uniforme, 0 sinon (dès la première ligne qui diffère).
+ */
+static int isFlatBlock(const uint8_t* block, int width) {
+#ifdef __SSE2__
+    const __m128i value = _mm_set1_epi8((char)block[0]);
+    for (int y = 0; y < FLAT_BLOCK_SIZE; y++) {
+        const uint8_t* row = block + (size_t)y * width;
+        for (int x = 0; x < FLAT_BLOCK_SIZE; x += 16) {
+            __m128i same = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(row + x)), value);
+            if (_mm_movemask_epi8(same) != 0xFFFF) return 0;
+        }
+    }
+#else
+    for (int y = 0; y < FLAT_BLOCK_SIZE; y++) {
+        const uint8_t* row = block + (size_t)y * width;
+        for (int x = 0; x < FLAT_BLOCK_SIZE; x++) {
+            if (row[x] != block[0]) return 0;
+        }
+    }
+#endif
+    return 1;
+}
+
+
+/**
+ * @brief Remplit un sous-arbre dont tous les pixels valent `value`, sans le parcourir.
+ * 
+ * Seule la racine est calculée ; les bits d'uniformité de ses descendants internes sont
+ * mis à 1 par plages (chaque niveau du sous-arbre est contigu), pour les parcours
+ * linéaires des niveaux comme sumAndMaxVars.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index de la racine du sous-arbre.
+ * @param depth Profondeur du sous-arbre.
+ * @param value Valeur des pixels.
+ */
+static void fillUniformBlock(QuadTree* tree, int nodeIndex, int depth, uint8_t value) {
+    tree->m[nodeIndex] = value;
+    tree->epsilon[nodeIndex] = 0;
+    setUniform(tree, nodeIndex, 1);
+    if (tree->moments) {
+        uint64_t n = (uint64_t)1 << (2 * depth);
+        BlockMoments block = { value * n, (uint64_t)value * value * n, n };
+        tree->moments[nodeIndex] = block;
+    }
+
+    long first = nodeIndex, count = 1;
+    for (int level = 1; level < depth; level++) {
+        first = 4 * first + 1;
+        count *= 4;
+        long bit = first + UNIFORM_BIT_OFFSET, end = bit + count;
+        for (; bit < end && (bit & 7); bit++) tree->uniform[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+        if (end - bit >= 8) {
+            memset(&tree->uniform[bit >> 3], 0xFF, (size_t)(end - bit) >> 3);
+            bit += (end - bit) & ~7L;
+        }
+        for (; bit < end; bit++) tree->uniform[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+    }
+}
+
+
+/**
+ * @brief Remplit un sous-arbre de plus de FLAT_BLOCK_DEPTH niveaux, bloc par bloc.
+ * 
+ * Chaque bloc de 2^FLAT_BLOCK_DEPTH pixels de côté est d'abord comparé à son premier
+ * pixel : un bloc uniforme (et entièrement dans l'image) est rempli par fillUniformBlock,
+ * les autres sont construits par fillQuadTree. Les niveaux au-dessus des blocs sont
+ * ensuite calculés à partir de leurs enfants.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param data Tableau contenant les données de l'image.
+ * @param width Largeur d'une ligne de pixels de `data`.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur du sous-arbre.
+ * @param nodeIndex Index de la racine du sous-arbre.
+ * @param startX Coordonnée X de départ.
+ * @param startY Coordonnée Y de départ.
+ */
+static void fillFlatBlocks(QuadTree* tree, uint8_t* data, int width, int height, int depth, int nodeIndex,
+                           int startX, int startY) {
+    int blocks = 1 << (depth - FLAT_BLOCK_DEPTH);
+    int cols = blocks, rows = blocks;
+    if (tree->border) {
+        cols = coveringBlocks(tree->width - startX, FLAT_BLOCK_DEPTH);
+        rows = coveringBlocks(tree->height - startY, FLAT_BLOCK_DEPTH);
+        if (cols > blocks) cols = blocks;
+        if (rows > blocks) rows = blocks;
+    }
+
+    long levelSize = (long)blocks * blocks;
+    long levelFirst = nodeIndex * levelSize + (levelSize - 1) / 3;
+
+    for (int by = 0; by < rows; by++) {
+        uint32_t sy = spreadBits(by);
+        int y = startY + by * FLAT_BLOCK_SIZE;
+        for (int bx = 0; bx < cols; bx++) {
+            int p = levelFirst + blockCode(spreadBits(bx), sy);
+            int x = startX + bx * FLAT_BLOCK_SIZE;
+            const uint8_t* block = data + (size_t)y * width + x;
+            int inside = !tree->border || (x + FLAT_BLOCK_SIZE <= tree->width && y + FLAT_BLOCK_SIZE <= tree->height);
+
+            if (inside && isFlatBlock(block, width)) {
+                fillUniformBlock(tree, p, FLAT_BLOCK_DEPTH, block[0]);
+                if (tree->border) tree->border[p] = blockBorder(tree, x, y, FLAT_BLOCK_SIZE);
+            } else {
+                fillQuadTree(tree, data, width, height, FLAT_BLOCK_DEPTH, p, x, y, FLAT_BLOCK_SIZE);
             }
         }
     }
 
-    *m = sum / (size * size); // Moyenne des intensités
+    int base = tree->depth - depth;   // niveau de la racine du sous-arbre
+    for (int level = depth - FLAT_BLOCK_DEPTH - 1; level >= 0; level--) {
+        levelSize = 1L << (2 * level);
+        levelFirst = nodeIndex * levelSize + (levelSize - 1) / 3;
+        if (tree->border) {
+            computeClippedLevel(tree, levelFirst, base + level, startX, startY, depth - level, 1 << level);
+            continue;
+        }
+        for (long i = levelFirst; i < levelFirst + levelSize; i++) {
+            computeFromChildren(tree, i);
+        }
+    }
 }
 
 
 /**
  * Remplit le QuadTree avec les données d'une image.
  * 
+ * La construction se fait par blocs de 2^FLAT_BLOCK_DEPTH pixels de côté : un bloc dont
+ * tous les pixels sont égaux devient un nœud uniforme sans que son sous-arbre soit
+ * construit (voir fillUniformBlock) ; les autres sont construits niveau par niveau, du
+ * bas vers le haut, à partir des lignes de pixels. Les niveaux au-dessus des blocs sont
+ * ensuite calculés à partir de leurs quatre enfants contigus. Les blocs des feuilles
+ * doivent être des pixels (size == 2^depth). Si l'image ne remplit pas le carré (voir
+ * setImageSize), seuls les blocs qui la touchent sont calculés. Les feuilles d'un arbre
+ * créé par createQuadTreeOverImage ne sont pas écrites.
+ * 
+ * Le noyau est choisi selon la profondeur du sous-arbre : fillBlock16 pour les blocs de
+ * 16x16 pixels d'un arbre à feuilles implicites, fillBlockLevels pour les autres
+ * profondeurs, fillClippedQuadTree pour les blocs qui touchent le bord de l'image.
+ * 
  * @param tree Pointeur vers le QuadTree.
  * @param data Tableau contenant les données de l'image.
  * @param width Largeur de l'image.
@@ -180,44 +1314,164 @@ static void computeBlock(uint8_t* data, int startX, int startY, int size, int wi
  * @param size Taille de la zone à analyser.
  */
 void fillQuadTree(QuadTree* tree, uint8_t* data, int width, int height, int depth, int nodeIndex, int startX, int startY, int size ) {
+    if (depth > FLAT_BLOCK_DEPTH) {
+        fillFlatBlocks(tree, data, width, height, depth, nodeIndex, startX, startY);
+        return;
+    }
+
+    // Seuls les blocs qui touchent le bord de l'image sont rognés
+    if (tree->border && blockBorder(tree, startX, startY, size)) {
+        fillClippedQuadTree(tree, data, width, depth, nodeIndex, startX, startY, size);
+        return;
+    }
+
     if (depth == 0) {
-        computeBlock(data, startX, startY, size, width, &tree->nodes[nodeIndex].m, &tree->nodes[nodeIndex].uniform);
-        tree->nodes[nodeIndex].epsilon = 0; // Les feuilles ont epsilon = 0
-        tree->nodes[nodeIndex].var = 0; 
+        setNodeM(tree, nodeIndex, data[startY * width + startX]);
+        setUniform(tree, nodeIndex, 1);
+        setNodeEpsilon(tree, nodeIndex, 0); // Les feuilles ont epsilon = 0
         return;
     }
 
-    // Nœud interne : diviser en 4 sous-blocs
-    int halfSize = size / 2;
-    int childIndex = 4 * nodeIndex + 1;
+    // Noyau dédié aux blocs de 16x16 pixels, les plus fréquents (voir fillFlatBlocks)
+    if (depth == 4 && tree->pixels) {
+        fillBlock16(tree, data + (size_t)startY * width + startX, width, nodeIndex);
+        return;
+    }
+    fillBlockLevels(tree, data, width, depth, nodeIndex, startX, startY, size);
+}
+
+
+/**
+ * Calcule les coordonnées du bloc associé à un nœud d'un niveau.
+ * 
+ * @param offset Position du nœud dans son niveau (index - levelStart(niveau)).
+ * @param bx Pointeur où stocker la colonne du bloc.
+ * @param by Pointeur où stocker la ligne du bloc.
+ */
+void blockPosition(int offset, int* bx, int* by) {
+    *by = compactBits(offset >> 1);
+    *bx = compactBits(offset) ^ *by;
+}
+
+
+/**
+ * Calcule la position dans son niveau du nœud associé à un bloc (inverse de blockPosition).
+ * 
+ * @param bx Colonne du bloc.
+ * @param by Ligne du bloc.
+ * @return La position du nœud dans son niveau (index - levelStart(niveau)).
+ */
+int blockOffset(int bx, int by) {
+    return (int)blockCode(spreadBits(bx), spreadBits(by));
+}
+
+
+/**
+ * Calcule les niveaux situés au-dessus d'un niveau déjà rempli, à partir des enfants.
+ * 
+ * @param tree Pointeur vers le QuadTree complet.
+ * @param level Niveau déjà rempli (ses nœuds sont les enfants du niveau level - 1).
+ */
+void fillUpperLevels(QuadTree* tree, int level) {
+    for (int l = level - 1; l >= 0; l--) {
+        if (tree->border) {
+            computeClippedLevel(tree, levelStart(l), l, 0, 0, tree->depth - l, 1 << l);
+            continue;
+        }
+        for (int i = levelStart(l); i < levelStart(l + 1); i++) {
+            computeFromChildren(tree, i);
+        }
+    }
+}
+
+
+/**
+ * Choisit le niveau de découpage en sous-arbres pour un traitement parallèle.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nbThreads Nombre de threads disponibles.
+ * @return Le niveau de découpage, ou -1 si l'arbre est trop petit pour être découpé.
+ */
+int parallelSplitLevel(const QuadTree* tree, int nbThreads) {
+    if (tree->depth < 2) return -1;
+
+    // Viser environ 8 groupes de tâches par thread pour laisser place au vol de tâches
+    int level = 2;
+    while (level < tree->depth && (1L << (2 * level)) / PARALLEL_GROUP < 8L * nbThreads) {
+        level++;
+    }
+    return level;
+}
+
+
+/**
+ * @brief Tâche de construction d'un groupe de sous-arbres consécutifs.
+ */
+typedef struct {
+    QuadTree* tree;
+    uint8_t* data;
+    int width;
+    int height;
+    int level;      // niveau des racines des sous-arbres
+    int first;      // index de la première racine
+} FillTask;
+
+
+/**
+ * @brief Construit les PARALLEL_GROUP sous-arbres d'une tâche.
+ * 
+ * @param arg Pointeur vers une FillTask.
+ */
+static void fillTask(void* arg) {
+    FillTask* task = (FillTask*)arg;
+    int subDepth = task->tree->depth - task->level;
+    int subSize = 1 << subDepth;
 
-    fillQuadTree(tree, data, width, height, depth - 1, childIndex, startX, startY, halfSize);                  // Haut-gauche
-    fillQuadTree(tree, data, width, height, depth - 1, childIndex + 1, startX + halfSize, startY, halfSize);  // Haut-droit
-    fillQuadTree(tree, data, width, height, depth - 1, childIndex + 2, startX + halfSize, startY + halfSize, halfSize); // Bas-droit
-    fillQuadTree(tree, data, width, height, depth - 1, childIndex + 3, startX, startY + halfSize, halfSize);  // Bas-gauche
+    for (int i = 0; i < PARALLEL_GROUP; i++) {
+        int nodeIndex = task->first + i;
+        int bx, by;
+        blockPosition(nodeIndex - levelStart(task->level), &bx, &by);
+        if (isBlockOutside(task->tree, task->level, bx, by)) continue;
+        fillQuadTree(task->tree, task->data, task->width, task->height, subDepth, nodeIndex,
+                     bx * subSize, by * subSize, subSize);
+    }
+}
 
-    // Calculer les moyennes des 4 sous-blocs
-    uint8_t m1 = tree->nodes[childIndex].m ;
-    uint8_t m2 = tree->nodes[childIndex + 1].m ; 
-    uint8_t m3 = tree->nodes[childIndex + 2].m ;
-    uint8_t m4 = tree->nodes[childIndex + 3].m ;
 
-    // Calculer epsilon pour le nœud courant
-    tree->nodes[nodeIndex].epsilon = (m1 + m2 + m3 + m4) % 4;
+/**
+ * Remplit tout le QuadTree avec les données d'une image, en parallèle.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param data Tableau contenant les données de l'image (carrée, de côté 2^depth).
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param pool Pool de threads (NULL pour une construction séquentielle).
+ */
+void fillQuadTreeParallel(QuadTree* tree, uint8_t* data, int width, int height, ThreadPool* pool) {
+    int split = pool ? parallelSplitLevel(tree, threadPoolSize(pool)) : -1;
+    if (tree->pixels && split >= tree->depth) split = -1; // pas de sous-arbres réduits à une feuille implicite
+    FillTask* tasks = NULL;
+    int nbTasks = 0;
 
-    // Calculer m pour le nœud courant (moyenne des sous-blocs)
-    tree->nodes[nodeIndex].m = (m1 + m2 + m3 + m4) / 4;
+    if (split >= 0) {
+        nbTasks = (1 << (2 * split)) / PARALLEL_GROUP;
+        tasks = (FillTask*)malloc(nbTasks * sizeof(FillTask));
+    }
+    if (!tasks) {
+        fillQuadTree(tree, data, width, height, tree->depth, 0, 0, 0, 1 << tree->depth);
+        return;
+    }
 
-    // Calculer u pour le nœud courant
-    tree->nodes[nodeIndex].uniform = (
-        tree->nodes[childIndex].uniform &&
-        tree->nodes[childIndex + 1].uniform &&
-        tree->nodes[childIndex + 2].uniform &&
-        tree->nodes[childIndex + 3].uniform &&
-        (m1 == m2 && m2 == m3 && m3 == m4) // Tous les m identiques
-    );
+    for (int t = 0; t < nbTasks; t++) {
+        FillTask task = { tree, data, width, height, split, levelStart(split) + t * PARALLEL_GROUP };
+        tasks[t] = task;
+        if (submitTask(pool, fillTask, &tasks[t]) != 0) fillTask(&tasks[t]);
+    }
+    waitThreadPool(pool);
+    free(tasks);
 
-    calculerVariance(tree , nodeIndex); 
+    // Niveaux au-dessus du découpage
+    fillUpperLevels(tree, split);
 }
 
 
@@ -233,16 +1487,16 @@ void printQuadTree(QuadTree* tree) {
 
     int nodeIndex = 0;
     for (int level = 0; level <= tree->depth; level++) {
-        int nodesAtLevel = (1 << (2 * level)); // Nombre de nœuds au niveau actuel
+        int nodesAtLevel = tree->levelFirst[level + 1] - tree->levelFirst[level]; // Nombre de nœuds au niveau actuel
         printf("Niveau %d:\n", level);
 
-        for (int i = 0; i < nodesAtLevel && nodeIndex < tree->totalNodes; i++, nodeIndex++) {
+        for (int i = 0; i < nodesAtLevel && nodeIndex < tree->totalNodes && nodeIndex < tree->capacity; i++, nodeIndex++) {
             printf("  Node %d -> m: %d, epsilon: %d, uniform: %d , variance %lf  \n" ,
                    nodeIndex, 
-                   tree->nodes[nodeIndex].m, 
-                   tree->nodes[nodeIndex].epsilon, 
-                   tree->nodes[nodeIndex].uniform,
-                   tree->nodes[nodeIndex].var 
+                   getNodeM(tree, nodeIndex), 
+                   getNodeEpsilon(tree, nodeIndex), 
+                   isUniform(tree, nodeIndex),
+                   getNodeVar(tree, nodeIndex) 
             );      
         }
     }
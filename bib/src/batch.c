@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "mappedfile.h"
+#include "threadpool.h"
+#include "batch.h"
+
+
+/**
+ * @brief État partagé par les threads qui traitent un lot.
+ */
+typedef struct {
+    const Batch* batch;
+    const QTCOptions* options;
+    int isEncode;
+    int lookahead;          // distance entre le fichier pris et celui dont la lecture est lancée
+    int next;               // prochain fichier à traiter
+    int failed;             // fichiers en échec
+    pthread_mutex_t lock;   // protège next et failed
+} BatchRun;
+
+
+/**
+ * @brief Ajoute un nom de fichier à un tableau extensible.
+ *
+ * @param names Pointeur vers le tableau.
+ * @param count Pointeur vers le nombre de noms.
+ * @param capacity Pointeur vers la capacité du tableau.
+ * @param name Nom à copier.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+static int appendName(char*** names, int* count, int* capacity, const char* name) {
+    if (*count == *capacity) {
+        int newCapacity = *capacity ? 2 * *capacity : 64;
+        char** bigger = (char**)realloc(*names, newCapacity * sizeof(char*));
+        if (!bigger) return -1;
+        *names = bigger;
+        *capacity = newCapacity;
+    }
+    char* copy = strdup(name);
+    if (!copy) return -1;
+    (*names)[(*count)++] = copy;
+    return 0;
+}
+
+
+/**
+ * @brief Compare deux noms de fichiers (tri par qsort).
+ */
+static int compareNames(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+
+/**
+ * @brief Liste les fichiers d'un répertoire ayant l'extension donnée, triés par nom.
+ *
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int listDirectory(const char* directory, const char* extension, char*** names, int* count) {
+    DIR* dir = opendir(directory);
+    if (!dir) {
+        perror("Erreur lors de l'ouverture du répertoire");
+        return -1;
+    }
+
+    int capacity = 0;
+    size_t extLength = strlen(extension);
+    char path[4096];
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (length <= extLength || strcmp(entry->d_name + length - extLength, extension) != 0) continue;
+
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (appendName(names, count, &capacity, path) != 0) {
+            perror("Erreur lors de l'allocation du lot");
+            closedir(dir);
+            return -1;
+        }
+    }
+    closedir(dir);
+
+    qsort(*names, *count, sizeof(char*), compareNames);
+    return 0;
+}
+
+
+/**
+ * @brief Lit une liste de fichiers (un nom par ligne, '#' pour les commentaires).
+ *
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int readFileList(const char* listFile, char*** names, int* count) {
+    FILE* list = fopen(listFile, "r");
+    if (!list) {
+        perror("Erreur lors de l'ouverture de la liste de fichiers");
+        return -1;
+    }
+
+    int capacity = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), list)) {
+        size_t length = strcspn(line, "\r\n");
+        line[length] = '\0';
+        if (length == 0 || line[0] == '#') continue;
+        if (appendName(names, count, &capacity, line) != 0) {
+            perror("Erreur lors de l'allocation du lot");
+            fclose(list);
+            return -1;
+        }
+    }
+    fclose(list);
+    return 0;
+}
+
+
+/**
+ * @brief Construit le nom de sortie d'un fichier : même nom de base, autre extension.
+ *
+ * @param input Nom du fichier d'entrée.
+ * @param outputDir Répertoire de sortie (NULL : celui de l'entrée).
+ * @param extension Extension de la sortie (".qtc" ou ".pgm").
+ * @return Le nom alloué (à libérer par free), ou NULL en cas d'erreur d'allocation.
+ */
+static char* outputName(const char* input, const char* outputDir, const char* extension) {
+    const char* base = strrchr(input, '/');
+    base = base ? base + 1 : input;
+    const char* dot = strrchr(base, '.');
+    int stem = dot && dot != base ? (int)(dot - base) : (int)strlen(base);
+
+    size_t size = (outputDir ? strlen(outputDir) + 1 : (size_t)(base - input)) + stem + strlen(extension) + 1;
+    char* name = (char*)malloc(size);
+    if (!name) return NULL;
+    if (outputDir) snprintf(name, size, "%s/%.*s%s", outputDir, stem, base, extension);
+    else snprintf(name, size, "%.*s%.*s%s", (int)(base - input), input, stem, base, extension);
+    return name;
+}
+
+
+/**
+ * Construit un lot à partir d'un répertoire ou d'une liste de fichiers.
+ *
+ * @param source Répertoire ou liste de fichiers.
+ * @param outputDir Répertoire des sorties (NULL : celui de chaque entrée).
+ * @param isEncode 1 pour un lot à encoder, 0 pour un lot à décoder.
+ * @param batch Pointeur vers le lot à remplir (à libérer par freeBatch).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int createBatch(const char* source, const char* outputDir, int isEncode, Batch* batch) {
+    memset(batch, 0, sizeof(*batch));
+
+    struct stat st;
+    if (stat(source, &st) != 0) {
+        perror("Erreur : Source du lot introuvable");
+        return -1;
+    }
+    int status = S_ISDIR(st.st_mode) ? listDirectory(source, isEncode ? ".pgm" : ".qtc", &batch->inputs, &batch->count)
+                                     : readFileList(source, &batch->inputs, &batch->count);
+    if (status != 0) {
+        freeBatch(batch);
+        return -1;
+    }
+    if (batch->count == 0) {
+        fprintf(stderr, "Erreur : Aucun fichier à traiter dans %s\n", source);
+        freeBatch(batch);
+        return -1;
+    }
+
+    if (outputDir && stat(outputDir, &st) != 0 && mkdir(outputDir, 0777) != 0) {
+        perror("Erreur : Impossible de créer le répertoire de sortie");
+        freeBatch(batch);
+        return -1;
+    }
+
+    batch->outputs = (char**)calloc(batch->count, sizeof(char*));
+    if (!batch->outputs) {
+        perror("Erreur lors de l'allocation du lot");
+        freeBatch(batch);
+        return -1;
+    }
+    for (int i = 0; i < batch->count; i++) {
+        batch->outputs[i] = outputName(batch->inputs[i], outputDir, isEncode ? ".qtc" : ".pgm");
+        if (!batch->outputs[i]) {
+            perror("Erreur lors de l'allocation du lot");
+            freeBatch(batch);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * Libère les noms de fichiers d'un lot.
+ *
+ * @param batch Pointeur vers le lot.
+ */
+void freeBatch(Batch* batch) {
+    for (int i = 0; i < batch->count; i++) {
+        free(batch->inputs[i]);
+        if (batch->outputs) free(batch->outputs[i]);
+    }
+    free(batch->inputs);
+    free(batch->outputs);
+    memset(batch, 0, sizeof(*batch));
+}
+
+
+/**
+ * @brief Tâche d'un thread du lot : traite les fichiers un par un jusqu'à la fin du lot.
+ *
+ * Chaque fichier est encodé ou décodé séquentiellement par le thread qui le prend
+ * (sans pool) : le parallélisme vient des fichiers traités en même temps. Le pool
+ * du lot ne peut pas servir aux fichiers, ses threads étant tous occupés par cette tâche.
+ *
+ * @param arg Pointeur vers l'état partagé du lot (BatchRun).
+ */
+static void batchTask(void* arg) {
+    BatchRun* run = (BatchRun*)arg;
+    const Batch* batch = run->batch;
+
+    for (;;) {
+        pthread_mutex_lock(&run->lock);
+        int k = run->next++;
+        pthread_mutex_unlock(&run->lock);
+        if (k >= batch->count) break;
+
+        // Lecture du fichier que ce thread prendra au tour suivant
+        if (k + run->lookahead < batch->count) prefetchFile(batch->inputs[k + run->lookahead]);
+
+        int status = run->isEncode ? encodeQTCFile(batch->inputs[k], batch->outputs[k], run->options, NULL)
+                                   : decodeQTCFile(batch->inputs[k], batch->outputs[k], run->options, NULL);
+        if (status != 0) {
+            fprintf(stderr, "Erreur : Échec du traitement de %s\n", batch->inputs[k]);
+            pthread_mutex_lock(&run->lock);
+            run->failed++;
+            pthread_mutex_unlock(&run->lock);
+        } else {
+            printf("[%d/%d] %s -> %s\n", k + 1, batch->count, batch->inputs[k], batch->outputs[k]);
+        }
+    }
+}
+
+
+/**
+ * Encode ou décode tous les fichiers d'un lot.
+ *
+ * @param batch Pointeur vers le lot.
+ * @param isEncode 1 pour encoder, 0 pour décoder.
+ * @param options Options d'encodage ou de décodage, communes à tout le lot.
+ * @return Le nombre de fichiers en échec.
+ */
+int runBatch(const Batch* batch, int isEncode, const QTCOptions* options) {
+    int nbThreads = options->nbThreads < batch->count ? options->nbThreads : batch->count;
+    if (nbThreads < 1) nbThreads = 1;
+
+    ThreadPool* pool = nbThreads > 1 ? createThreadPool(nbThreads) : NULL;
+    if (nbThreads > 1 && !pool) {
+        fprintf(stderr, "Attention : Pool de threads indisponible, traitement séquentiel\n");
+        nbThreads = 1;
+    }
+
+    BatchRun run = {
+        .batch = batch,
+        .options = options,
+        .isEncode = isEncode,
+        .lookahead = nbThreads,
+        .next = 0,
+        .failed = 0,
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+    };
+
+    // Premiers fichiers de chaque thread
+    for (int i = 0; i < nbThreads && i < batch->count; i++) prefetchFile(batch->inputs[i]);
+
+    if (pool) {
+        for (int t = 0; t < nbThreads; t++) {
+            if (submitTask(pool, batchTask, &run) != 0) break; // les tâches soumises finiront le lot
+        }
+        freeThreadPool(pool);
+    }
+    // Sans pool, ou si aucune tâche n'a pu être soumise : le thread appelant finit le lot
+    batchTask(&run);
+
+    pthread_mutex_destroy(&run.lock);
+    return run.failed;
+}
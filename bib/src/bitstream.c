@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitstream.h"
+
+
+/**
+ * Initialise un écrivain vide.
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ */
+void initBitWriter(BitWriter* writer) {
+    memset(writer, 0, sizeof(BitWriter));
+}
+
+
+/**
+ * Libère le tampon d'un écrivain.
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ */
+void freeBitWriter(BitWriter* writer) {
+    free(writer->data);
+    initBitWriter(writer);
+}
+
+
+/**
+ * @brief Garantit la place pour `extra` octets supplémentaires.
+ * 
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+static int reserveBytes(BitWriter* writer, size_t extra) {
+    if (writer->size + extra <= writer->capacity) return 0;
+
+    size_t capacity = writer->capacity ? writer->capacity : 4096;
+    while (capacity < writer->size + extra) capacity *= 2;
+
+    uint8_t* data = (uint8_t*)realloc(writer->data, capacity);
+    if (!data) {
+        perror("Erreur lors de l'allocation du tampon de codage");
+        writer->error = 1;
+        return -1;
+    }
+    writer->data = data;
+    writer->capacity = capacity;
+    return 0;
+}
+
+
+/**
+ * Vide 32 bits de l'accumulateur dans le tampon (agrandi si nécessaire).
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ */
+void spillBitWriter(BitWriter* writer) {
+    writer->accBits -= 32;
+    uint32_t word = (uint32_t)(writer->acc >> writer->accBits);
+
+    if (reserveBytes(writer, 4) == 0) {
+        uint8_t* out = writer->data + writer->size;
+        out[0] = (uint8_t)(word >> 24);
+        out[1] = (uint8_t)(word >> 16);
+        out[2] = (uint8_t)(word >> 8);
+        out[3] = (uint8_t)word;
+        writer->size += 4;
+    }
+}
+
+
+/**
+ * Complète le dernier octet avec des zéros et vide l'accumulateur.
+ * 
+ * @param writer Pointeur vers l'écrivain.
+ * @return Le nombre d'octets du flux, ou 0 en cas d'erreur (voir `error`).
+ */
+size_t flushBitWriter(BitWriter* writer) {
+    int pad = (8 - writer->accBits % 8) % 8;
+    writer->acc <<= pad;
+    writer->accBits += pad;
+
+    if (reserveBytes(writer, writer->accBits / 8) != 0) return 0;
+    while (writer->accBits > 0) {
+        writer->accBits -= 8;
+        writer->data[writer->size++] = (uint8_t)(writer->acc >> writer->accBits);
+    }
+    return writer->error ? 0 : writer->size;
+}
+
+
+/**
+ * Ajoute le flux d'un écrivain à la suite d'un autre, au bit près.
+ * 
+ * @param dst Écrivain de destination.
+ * @param src Écrivain source (non modifié).
+ */
+void appendBitWriter(BitWriter* dst, const BitWriter* src) {
+    size_t i = 0;
+
+    if (dst->accBits == 0 && src->size > 0) {
+        // Destination alignée : copie directe des octets complets (un écrivain vide n'a pas de tampon)
+        if (reserveBytes(dst, src->size) == 0) {
+            memcpy(dst->data + dst->size, src->data, src->size);
+            dst->size += src->size;
+        }
+        i = src->size;
+    }
+    for (; i + 4 <= src->size; i += 4) {
+        const uint8_t* in = src->data + i;
+        writeBits(dst, ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3], 32);
+    }
+    for (; i < src->size; i++) {
+        writeBits(dst, src->data[i], 8);
+    }
+    if (src->accBits > 0) writeBits(dst, (uint32_t)src->acc, src->accBits);
+    if (src->error) dst->error = 1;
+}
+
+
+/**
+ * Initialise un lecteur sur un tampon.
+ * 
+ * @param reader Pointeur vers le lecteur.
+ * @param data Tampon à lire.
+ * @param size Taille du tampon en octets.
+ */
+void initBitReader(BitReader* reader, const uint8_t* data, size_t size) {
+    reader->data = data;
+    reader->size = size;
+    reader->pos = 0;
+    reader->bits = 0;
+    reader->count = 0;
+}
+
+
+/**
+ * Recharge le registre octet par octet près de la fin du tampon.
+ * 
+ * Les octets au-delà de la fin valent zéro ; `pos` continue d'avancer pour que
+ * bitReaderOverrun détecte leur consommation.
+ * 
+ * @param reader Pointeur vers le lecteur.
+ */
+void refillBitReaderSlow(BitReader* reader) {
+    while (reader->count <= 56) {
+        uint64_t byte = (reader->pos < reader->size) ? reader->data[reader->pos] : 0;
+        reader->bits |= byte << (56 - reader->count);
+        reader->pos++;
+        reader->count += 8;
+    }
+}
+
+
+/**
+ * Positionne un lecteur sur un bit donné du tampon.
+ * 
+ * @param reader Pointeur vers le lecteur.
+ * @param bitOffset Position en bits depuis le début du tampon.
+ */
+void seekBitReader(BitReader* reader, size_t bitOffset) {
+    reader->pos = bitOffset / 8;
+    reader->bits = 0;
+    reader->count = 0;
+    refillBitReader(reader);
+    skipBits(reader, bitOffset % 8);
+}
@@ -1,17 +1,220 @@
 #include "codage.h"
+#include "bitstream.h"
+#include "entropy.h"
 
 
 /**
- * @brief Encode un QuadTree dans un fichier binaire en utilisant un format compressé.
+ * Taille minimale (en nœuds) d'un morceau d'arbre encodé par une tâche.
+ */
+#define CHUNK_MIN_NODES (1 << 14)
+
+
+/**
+ * @brief Encode une plage de nœuds consécutifs (dans l'ordre du parcours en largeur).
  * 
- * Cette fonction parcourt les noeud d'un QuadTree et écrit leurs informations 
- * dans un fichier en format compressé, en respectant les règles suivantes :
+ * Règles de codage :
+ * - Les enfants d'un noeud uniforme ne sont pas codés (un arbre creux ne les contient pas).
+ * - Les nœuds hors de l'image ne sont pas codés.
  * - Les feuilles qui sont des quatrièmes enfants ne sont pas codées.
- * - Les enfants d'un noeud uniforme ne sont pas codés.
- * - le m des noeuds qui sont quatrièmes enfants n'est pas codé.
- * - Chaque nœud encode ses valeurs `m` et `epsilon` .
+ * - le m des noeuds qui sont quatrièmes enfants n'est pas codé (au bord de l'image, c'est
+ *   le dernier enfant dans l'image qui en tient lieu, voir isDerivedChild).
+ * - Chaque nœud interne encode ses valeurs `m` et `epsilon`, les feuilles seulement `m`.
  * - Si `epsilon == 0`, le champ `uniform` est également encodé.
  * 
+ * Les champs d'un nœud (m sur 8 bits, epsilon sur 2 bits, uniform sur 1 bit) sont
+ * assemblés en un seul enregistrement écrit en une opération.
+ * 
+ * @param tree Pointeur vers le QuadTree à encoder.
+ * @param first Index du premier nœud de la plage.
+ * @param last Index suivant le dernier nœud de la plage.
+ * @param firstLeaf Index du premier nœud codé comme une feuille (voir encoderQuadTreeNodes).
+ * @param out Écrivain recevant les bits.
+ */
+static void encodeRange(QuadTree* tree, int first, int last, int firstLeaf, BitWriter* out) {
+    for (int nodeIndex = first; nodeIndex < last; nodeIndex++) {
+        if (!tree->sparse && nodeIndex != 0) { // sauter les enfant d'un noeud uniforme 
+            if (isUniform(tree, getParentIndex(nodeIndex))) {
+                continue; 
+            }
+        }
+        if (isOutside(tree, nodeIndex)) continue;
+        int fourth = isDerivedChild(tree, nodeIndex);
+
+        if (nodeIndex >= firstLeaf) {
+            // si c'est une feuille coder m, sauf pour les quatrièmes enfants
+            if (!fourth) writeBits(out, getNodeM(tree, nodeIndex), 8);
+            continue;
+        }
+
+        // m (sauf quatrième enfant) puis epsilon, puis uniform si epsilon == 0
+        uint8_t epsilon = getNodeEpsilon(tree, nodeIndex);
+        uint32_t record = fourth ? 0 : getNodeM(tree, nodeIndex);
+        int length = fourth ? 2 : 10;
+
+        record = (record << 2) | epsilon;
+        if (epsilon == 0) {
+            record = (record << 1) | isUniform(tree, nodeIndex);
+            length++;
+        }
+        writeBits(out, record, length);
+    }
+}
+
+
+/**
+ * Compte les champs codés d'un QuadTree, avec les mêmes règles que encodeRange.
+ * 
+ * @param tree Pointeur vers le QuadTree (complet ou élagué).
+ * @param counts Pointeur vers les compteurs à remplir.
+ */
+void countEncodedFields(const QuadTree* tree, EncodedFields* counts) {
+    memset(counts, 0, sizeof(*counts));
+    int firstLeaf = tree->levelFirst[tree->depth];
+    for (int nodeIndex = 0; nodeIndex < tree->totalNodes; nodeIndex++) {
+        if (!tree->sparse && nodeIndex != 0 && isUniform(tree, getParentIndex(nodeIndex))) continue;
+        if (isOutside(tree, nodeIndex)) continue;
+        int fourth = isDerivedChild(tree, nodeIndex);
+
+        if (nodeIndex >= firstLeaf) {
+            if (!fourth) {
+                counts->nodes++;
+                counts->mBits += 8;
+            }
+            continue;
+        }
+        counts->nodes++;
+        if (!fourth) counts->mBits += 8;
+        counts->epsilonBits += 2;
+        if (getNodeEpsilon(tree, nodeIndex) == 0) counts->uniformBits++;
+    }
+}
+
+
+/**
+ * @brief Compte les bits des descendants codés d'un nœud interne non uniforme d'un arbre complet.
+ * 
+ * @param tree Pointeur vers le QuadTree complet.
+ * @param nodeIndex Index du nœud (dans l'image).
+ * @param level Niveau du nœud.
+ * @return Le nombre de bits des champs de ses descendants.
+ */
+static uint64_t countSubtreeBits(const QuadTree* tree, int nodeIndex, int level) {
+    uint8_t outside = 0, borders[4];
+    if (tree->border) outside = childBorders(tree, level, tree->border[nodeIndex], borders);
+    int inside = 4 - popcount64(outside);
+
+    // Moyennes des enfants dans l'image, sauf celle qui se déduit des autres
+    uint64_t bits = 8 * (uint64_t)(inside - 1);
+    if (level + 1 == tree->depth) return bits; // les feuilles ne codent que `m`
+
+    int child = 4 * nodeIndex + 1;
+    for (int i = 0; i < 4; i++) {
+        if (outside & (1 << i)) continue;
+        bits += 2;
+        if (getNodeEpsilon(tree, child + i) == 0) {
+            bits++;
+            if (isUniform(tree, child + i)) continue;
+        }
+        bits += countSubtreeBits(tree, child + i, level + 1);
+    }
+    return bits;
+}
+
+
+/**
+ * Compte les bits du flux Q1 d'un QuadTree complet, sans rien écrire.
+ * 
+ * Seuls les nœuds codés sont visités : la descente s'arrête aux nœuds uniformes, dont
+ * les descendants (et les feuilles d'un arbre construit sur une image) ne sont pas lus.
+ * 
+ * @param tree Pointeur vers le QuadTree complet (non élagué), éventuellement filtré.
+ * @return Le nombre de bits du flux (hors alignement final).
+ */
+uint64_t countQuadTreeBits(const QuadTree* tree) {
+    uint64_t bits = 8;
+    if (tree->depth == 0) return bits;
+
+    bits += 2;
+    if (getNodeEpsilon(tree, 0) == 0) {
+        bits++;
+        if (isUniform(tree, 0)) return bits;
+    }
+    return bits + countSubtreeBits(tree, 0, 0);
+}
+
+
+/**
+ * @brief Morceau de l'arbre (nœuds consécutifs) encodé par une tâche.
+ */
+typedef struct {
+    QuadTree* tree;
+    int first;
+    int last;
+    BitWriter bits;
+} EncodeChunk;
+
+
+/**
+ * @brief Encode un morceau de l'arbre dans son propre tampon.
+ * 
+ * @param arg Pointeur vers un EncodeChunk.
+ */
+static void encodeChunkTask(void* arg) {
+    EncodeChunk* chunk = (EncodeChunk*)arg;
+    QuadTree* tree = chunk->tree;
+    encodeRange(tree, chunk->first, chunk->last, tree->levelFirst[tree->depth], &chunk->bits);
+}
+
+
+/**
+ * @brief Découpe les nœuds de l'arbre en morceaux consécutifs.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param nbThreads Nombre de threads disponibles.
+ * @param nbChunks Pointeur où stocker le nombre de morceaux.
+ * @return Le tableau des morceaux, ou NULL en cas d'erreur d'allocation.
+ */
+static EncodeChunk* splitNodes(QuadTree* tree, int nbThreads, int* nbChunks) {
+    int chunkSize = tree->totalNodes / (4 * nbThreads);
+    if (chunkSize < CHUNK_MIN_NODES) chunkSize = CHUNK_MIN_NODES;
+    int count = (tree->totalNodes + chunkSize - 1) / chunkSize;
+
+    EncodeChunk* chunks = (EncodeChunk*)calloc(count, sizeof(EncodeChunk));
+    if (!chunks) return NULL;
+
+    for (int c = 0; c < count; c++) {
+        chunks[c].tree = tree;
+        initBitWriter(&chunks[c].bits);
+        chunks[c].first = c * chunkSize;
+        chunks[c].last = (c + 1 < count) ? (c + 1) * chunkSize : tree->totalNodes;
+    }
+    *nbChunks = count;
+    return chunks;
+}
+
+
+/**
+ * @brief Encode une plage de nœuds d'un QuadTree dans un écrivain, avec les règles de Q1.
+ * 
+ * @param tree Pointeur vers le QuadTree à encoder.
+ * @param first Index du premier nœud de la plage.
+ * @param last Index suivant le dernier nœud de la plage.
+ * @param firstLeaf Index du premier nœud codé comme une feuille (m seul) : le premier nœud
+ * du dernier niveau, ou INT_MAX si les nœuds du dernier niveau de l'arbre sont des nœuds
+ * internes de l'image (niveaux supérieurs d'un codage tuilé).
+ * @param out Écrivain recevant les bits.
+ */
+void encoderQuadTreeNodes(QuadTree* tree, int first, int last, int firstLeaf, BitWriter* out) {
+    encodeRange(tree, first, last, firstLeaf, out);
+}
+
+
+/**
+ * @brief Encode un QuadTree dans un fichier binaire en utilisant un format compressé.
+ * 
+ * Le flux est construit en mémoire par un BitWriter puis écrit en une seule fois
+ * (voir encodeRange pour les règles de codage).
+ * 
  * @param file Pointeur vers le fichier où écrire les données compressées.
  * @param tree Pointeur vers le QuadTree à encoder.
  * @param bits_de_qtc Pointeur vers une variable pour compter le nombre total de bits écrits.
@@ -19,77 +222,272 @@
  * 
  */
 void encoderQuadTree(FILE* file, QuadTree* tree , size_t * bits_de_qtc ) {  
-    uint8_t buffer = 0; 
-    int bitPos = 0;   
+    encoderQuadTreeParallel(file, tree, bits_de_qtc, NULL);
+}
 
-    for (int nodeIndex = 0; nodeIndex < tree->totalNodes; nodeIndex++) {
-        QuadTreeNode* node = &tree->nodes[nodeIndex];
-        if (nodeIndex != 0) { // sauter les enfant d'un noeud uniforme 
-            QuadTreeNode* parentNode = getParentNode(tree, nodeIndex);
-            if (parentNode != NULL && parentNode->uniform == 1) {
-                continue; 
-            }
-        }
-        if (isLeaf(tree, nodeIndex) && isFourthChild(nodeIndex)) {
-            continue; // ne pas coder les feuilles qui sont des quatrièmes enfants
-        }
-        if (isLeaf(tree, nodeIndex) ) { // si c'est une feuille coder m 
-            *bits_de_qtc += 8 ; //m codé sur 8 bits
-            for (int i = 7; i >= 0; i--) {
-                buffer = (buffer << 1) | ((node->m >> i) & 1);
-                bitPos++;
-                if (bitPos == 8) {
-                    fwrite(&buffer, sizeof(uint8_t), 1, file);
-                    buffer = 0;
-                    bitPos = 0;
-                }
-            }
-            continue; // passer au prochain nœud
+
+/**
+ * @brief Encode un QuadTree en découpant ses nœuds en morceaux encodés en parallèle.
+ * 
+ * Chaque morceau est encodé dans son propre tampon, puis les tampons sont recollés
+ * au bit près dans l'ordre du parcours en largeur : le flux est identique à celui
+ * du codage séquentiel.
+ * 
+ * @param file Pointeur vers le fichier où écrire les données compressées.
+ * @param tree Pointeur vers le QuadTree à encoder.
+ * @param bits_de_qtc Pointeur vers une variable pour compter le nombre total de bits écrits.
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ */
+void encoderQuadTreeParallel(FILE* file, QuadTree* tree, size_t* bits_de_qtc, ThreadPool* pool) {
+    BitWriter stream;
+    initBitWriter(&stream);
+
+    EncodeChunk* chunks = NULL;
+    int nbChunks = 0;
+    if (pool) chunks = splitNodes(tree, threadPoolSize(pool), &nbChunks);
+
+    if (chunks) {
+        for (int c = 0; c < nbChunks; c++) {
+            if (submitTask(pool, encodeChunkTask, &chunks[c]) != 0) encodeChunkTask(&chunks[c]);
         }
-        // coder m
-        if (!isFourthChild(nodeIndex)) {
-            *bits_de_qtc += 8 ; 
-
-            for (int i = 7; i >= 0; i--) {
-                buffer = (buffer << 1) | ((node->m >> i) & 1);
-                bitPos++;
-                if (bitPos == 8) {
-                    fwrite(&buffer, sizeof(uint8_t), 1, file);
-                    buffer = 0;
-                    bitPos = 0;
-                }
-            }
+        waitThreadPool(pool);
+
+        for (int c = 0; c < nbChunks; c++) {
+            appendBitWriter(&stream, &chunks[c].bits);
+            freeBitWriter(&chunks[c].bits);
         }
-        //   coder epsilon
-        *bits_de_qtc += 2 ; //epsilon codé sur 2 bits 
-        for (int i = 1; i >= 0; i--) {
-            buffer = (buffer << 1) | ((node->epsilon >> i) & 1);
-            bitPos++;
-            if (bitPos == 8) {
-                fwrite(&buffer, sizeof(uint8_t), 1, file);
-                buffer = 0;
-                bitPos = 0;
-            }
+        free(chunks);
+    } else {
+        encodeRange(tree, 0, tree->totalNodes, tree->levelFirst[tree->depth], &stream);
+    }
+
+    // Les bits restants sont complétés avec des zéros pour former un octet
+    size_t bytes = flushBitWriter(&stream);
+    if (stream.error) {
+        fprintf(stderr, "Erreur : Encodage du QuadTree échoué\n");
+        freeBitWriter(&stream);
+        return;
+    }
+    *bits_de_qtc = bytes * 8;
+
+    if (bytes > 0 && fwrite(stream.data, sizeof(uint8_t), bytes, file) != bytes) {
+        fprintf(stderr, "Erreur : Écriture des données encodées échouée\n");
+    }
+    freeBitWriter(&stream);
+}
+
+
+/**
+ * @brief Code les quatre enfants d'un nœud non uniforme au format Q4.
+ * 
+ * Les moyennes codées du groupe viennent d'abord (écarts à la moyenne du parent), puis,
+ * pour des nœuds internes, la fin (epsilon et uniformité) de chaque enfant dans l'image.
+ * Les enfants hors de l'image et la moyenne de l'enfant qui se déduit du parent ne
+ * sont pas codés, comme en Q1.
+ * 
+ * @param coder Codeur rANS.
+ * @param model Modèle de contexte.
+ * @param tree Pointeur vers le QuadTree.
+ * @param parent Index du parent.
+ * @param child Index du premier enfant.
+ * @param level Niveau du parent.
+ */
+static void encodeGroupEntropy(RansEncoder* coder, EntropyModel* model, QuadTree* tree, int parent, int child, int level) {
+    int ctx = levelContext(level + 1);
+    uint8_t predicted = getNodeM(tree, parent);
+    int total = 0;
+    int activity = 0;
+
+    for (int i = 0; i < 4; i++) {
+        if (isOutside(tree, child + i) || isDerivedChild(tree, child + i)) continue;
+        int z = zigzagResidual(getNodeM(tree, child + i), predicted);
+        encodeSymbol(coder, &model->m[ctx][activity], z);
+        total += z;
+        activity = nextActivity(total);
+    }
+    if (level + 1 == tree->depth) return; // les feuilles ne codent que `m`
+
+    for (int i = 0; i < 4; i++) {
+        if (isOutside(tree, child + i)) continue;
+        encodeSymbol(coder, &model->tail[ctx], tailSymbol(getNodeEpsilon(tree, child + i), isUniform(tree, child + i)));
+    }
+}
+
+
+/**
+ * @brief Encode un QuadTree au format Q4 : les champs de Q1, codés par un codeur rANS adaptatif.
+ * 
+ * Les nœuds sont codés dans l'ordre du flux Q1, groupe de frères par groupe de frères
+ * (voir encodeGroupEntropy). La racine code sa moyenne comme un écart à 128.
+ * 
+ * @param file Pointeur vers le fichier où écrire les données compressées.
+ * @param tree Pointeur vers le QuadTree élagué à encoder.
+ * @param bits_de_qtc Pointeur où stocker le nombre de bits écrits.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int encoderQuadTreeEntropy(FILE* file, QuadTree* tree, size_t* bits_de_qtc) {
+    EntropyModel* model = (EntropyModel*)malloc(sizeof(EntropyModel));
+    if (!model) {
+        perror("Erreur lors de l'allocation du modèle de contexte");
+        return -1;
+    }
+    initEntropyModel(model, tree->depth);
+
+    RansEncoder coder;
+    initRansEncoder(&coder);
+    encodeSymbol(&coder, &model->m[0][0], zigzagResidual(getNodeM(tree, 0), 128));
+    if (tree->depth > 0) encodeSymbol(&coder, &model->tail[0], tailSymbol(getNodeEpsilon(tree, 0), isUniform(tree, 0)));
+
+    for (int level = 0; level < tree->depth; level++) {
+        for (int parent = tree->levelFirst[level]; parent < tree->levelFirst[level + 1]; parent++) {
+            if (!isUniform(tree, parent)) encodeGroupEntropy(&coder, model, tree, parent, getChildIndex(tree, parent), level);
         }
-        if (node->epsilon == 0) {                    //je vais donc coder uniform
-            *bits_de_qtc += 1 ; 
-
-            buffer = (buffer << 1) | (node->uniform & 1);
-            bitPos++;
-            if (bitPos == 8) {
-                fwrite(&buffer, sizeof(uint8_t), 1, file);
-                buffer = 0;
-                bitPos = 0;
-            }
+    }
+    free(model);
+
+    BitWriter stream;
+    initBitWriter(&stream);
+    int status = flushRansEncoder(&coder, &stream);
+    freeRansEncoder(&coder);
+
+    size_t bytes = flushBitWriter(&stream);
+    if (status != 0 || stream.error) {
+        fprintf(stderr, "Erreur : Encodage du QuadTree échoué\n");
+        status = -1;
+    } else if (bytes > 0 && fwrite(stream.data, 1, bytes, file) != bytes) {
+        fprintf(stderr, "Erreur : Écriture des données encodées échouée\n");
+        status = -1;
+    }
+    *bits_de_qtc = bytes * 8;
+    freeBitWriter(&stream);
+    return status;
+}
+
+
+/**
+ * @brief Sous-flux d'un sous-arbre du format Q2.
+ */
+typedef struct {
+    QuadTree* tree;
+    int first;          // position de la première racine du groupe dans le niveau de découpage
+    int split;          // niveau de découpage
+    BitWriter* bits;    // un écrivain par racine du groupe
+} SubtreeChunk;
+
+
+/**
+ * @brief Encode les descendants d'un nœud, niveau par niveau (parcours en largeur du sous-arbre).
+ * 
+ * Les descendants d'un nœud forment une plage contiguë de chaque niveau, obtenue en
+ * descendant les bornes de la plage précédente (voir getChildIndex).
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param root Racine du sous-arbre (déjà codée dans le flux principal).
+ * @param levels Nombre de niveaux sous la racine.
+ * @param out Écrivain recevant les bits.
+ */
+static void encodeSubtree(QuadTree* tree, int root, int levels, BitWriter* out) {
+    int first = root, last = root + 1;
+    for (int k = 1; k <= levels && first < last; k++) {
+        first = getChildIndex(tree, first);
+        last = getChildIndex(tree, last);
+        encodeRange(tree, first, last, tree->levelFirst[tree->depth], out);
+    }
+}
+
+
+/**
+ * @brief Encode les sous-flux d'un groupe de PARALLEL_GROUP sous-arbres.
+ * 
+ * @param arg Pointeur vers un SubtreeChunk.
+ */
+static void encodeSubtreeTask(void* arg) {
+    SubtreeChunk* chunk = (SubtreeChunk*)arg;
+    for (int i = 0; i < PARALLEL_GROUP; i++) {
+        // Un bloc couvert par un ancêtre uniforme a un sous-flux vide
+        int level;
+        int root = findNode(chunk->tree, chunk->split, chunk->first + i, &level);
+        if (level == chunk->split && !isUniform(chunk->tree, root)) {
+            encodeSubtree(chunk->tree, root, chunk->tree->depth - chunk->split, &chunk->bits[i]);
         }
     }
+}
+
+
+/**
+ * @brief Encode un QuadTree au format Q2 (flux découpé en sous-arbres indexés).
+ * 
+ * Après l'octet de profondeur, le format Q2 contient :
+ * - un octet donnant le niveau de découpage s ;
+ * - un index de 4^s positions (64 bits, gros-boutiste) : la position en bits, dans le flux,
+ *   du sous-flux de chaque nœud du niveau s ;
+ * - le flux : les niveaux 0 à s en largeur (mêmes règles que Q1), puis, pour chaque
+ *   nœud du niveau s, ses descendants en largeur.
+ * 
+ * @param file Pointeur vers le fichier où écrire les données compressées.
+ * @param tree Pointeur vers le QuadTree à encoder.
+ * @param split Niveau de découpage (entre 2 et la profondeur de l'arbre).
+ * @param bits_de_qtc Pointeur où stocker le nombre de bits écrits (index compris).
+ * @param indexBytes Pointeur où stocker la taille de l'index en octets (niveau de découpage compris).
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int encoderQuadTreeIndexed(FILE* file, QuadTree* tree, int split, size_t* bits_de_qtc, size_t* indexBytes, ThreadPool* pool) {
+    // Le niveau est vérifié par l'appelant avant l'ouverture du fichier : simple garde
+    if (split < 2 || split > tree->depth) {
+        fprintf(stderr, "Erreur : Niveau de découpage %d invalide pour une profondeur %d\n", split, tree->depth);
+        return -1;
+    }
+
+    int nbRoots = 1 << (2 * split);
+    int nbChunks = nbRoots / PARALLEL_GROUP;
+    BitWriter* bits = (BitWriter*)calloc(nbRoots, sizeof(BitWriter));
+    SubtreeChunk* chunks = (SubtreeChunk*)calloc(nbChunks, sizeof(SubtreeChunk));
+    size_t headerSize = 1 + 8 * (size_t)nbRoots;
+    uint8_t* header = (uint8_t*)malloc(headerSize);
+    if (!bits || !chunks || !header) {
+        perror("Erreur lors de l'allocation des sous-flux");
+        free(bits);
+        free(chunks);
+        free(header);
+        return -1;
+    }
 
-    // Écrire les bits restants dans le tampon (si incomplet)    
-    if (bitPos > 0) {
-        *bits_de_qtc += (8 - bitPos); 
+    for (int c = 0; c < nbChunks; c++) {
+        SubtreeChunk chunk = { tree, c * PARALLEL_GROUP, split, bits + c * PARALLEL_GROUP };
+        chunks[c] = chunk;
+        if (!pool || submitTask(pool, encodeSubtreeTask, &chunks[c]) != 0) encodeSubtreeTask(&chunks[c]);
+    }
 
-        buffer <<= (8 - bitPos); // Compléter avec des zéros pour former un octet
+    // Flux principal (niveaux 0 à split) pendant que les sous-arbres sont encodés
+    BitWriter stream;
+    initBitWriter(&stream);
+    encodeRange(tree, 0, tree->levelFirst[split + 1], tree->levelFirst[tree->depth], &stream);
+    if (pool) waitThreadPool(pool);
 
-        fwrite(&buffer, sizeof(uint8_t), 1, file);
+    header[0] = (uint8_t)split;
+    for (int r = 0; r < nbRoots; r++) {
+        putUint64(header + 1 + 8 * r, bitWriterBits(&stream));
+        appendBitWriter(&stream, &bits[r]);
+        freeBitWriter(&bits[r]);
     }
+    free(bits);
+    free(chunks);
+
+    size_t bytes = flushBitWriter(&stream);
+    int status = 0;
+    if (stream.error) {
+        fprintf(stderr, "Erreur : Encodage du QuadTree échoué\n");
+        status = -1;
+    } else if (fwrite(header, 1, headerSize, file) != headerSize ||
+               (bytes > 0 && fwrite(stream.data, 1, bytes, file) != bytes)) {
+        fprintf(stderr, "Erreur : Écriture des données encodées échouée\n");
+        status = -1;
+    }
+
+    *bits_de_qtc = (headerSize + bytes) * 8;
+    *indexBytes = headerSize;
+    free(header);
+    freeBitWriter(&stream);
+    return status;
 }
@@ -4,106 +4,335 @@
 #include <string.h>
 
 #include "decodage.h"
+#include "bitstream.h"
+#include "mappedfile.h"
+#include "entropy.h"
+#include "segmentation.h"
 
 
 /**
- * @brief Lit un fichier QTC et retourne les données binaires associées.
- * 
- * Cette fonction lit un fichier QTC . 
- * Elle extrait la taille de la structure à partir du premier octet, puis 
- * lit les données binaires restantes.
+ * @brief Analyse l'en-tête d'un fichier QTC chargé en mémoire.
  * 
- * @param file Pointeur vers le fichier ouvert en mode lecture.
- * @param taille Pointeur où la taille lue sera stockée.
- * @return Un pointeur vers les données binaires lues (tableau d'octets), 
- * ou NULL en cas d'erreur.
+ * L'en-tête fait trois lignes (la première donne le format), suivies de l'octet de profondeur.
+ * La ligne du format porte aussi les dimensions de l'image ("Q1 largeur hauteur") quand
+ * elle ne remplit pas le carré de côté 2^profondeur.
  * 
- *  */
-uint8_t* readQTCFile(FILE* file, int* taille) {
-    if (!file) {
-        fprintf(stderr, "Erreur : Fichier non valide\n");
-        return NULL;
-    }
-
+ * @param buffer Contenu du fichier.
+ * @param size Taille du contenu en octets.
+ * @param taille Pointeur où la profondeur lue sera stockée.
+ * @param width Pointeur où la largeur de l'image sera stockée.
+ * @param height Pointeur où la hauteur de l'image sera stockée.
+ * @param dataSize Pointeur où la taille des données binaires (en octets) sera stockée.
+ * @param format Pointeur où la version du format (1 à 4) sera stockée.
+ * @return Un pointeur vers les données binaires dans le contenu, ou NULL en cas d'erreur.
+ */
+static const uint8_t* parseQTCHeader(const uint8_t* buffer, size_t size, int* taille, int* width, int* height,
+                                     size_t* dataSize, int* format) {
+    const uint8_t* p = buffer;
+    const uint8_t* end = buffer + size;
     char line[256];
+    int dimensions = 0;
 
     // Lire et ignorer les trois premières lignes du fichier (en-tête QTC)
     for (int i = 0; i < 3; i++) {
-        if (!fgets(line, sizeof(line), file)) {
+        if ((p = readLine(p, end, line, sizeof(line))) == NULL) {
             fprintf(stderr, "Erreur : Format de fichier QTC incorrect ou ligne manquante\n");
             return NULL;
         }
+        if (i == 0) { // Q1 : flux unique, Q2 : flux indexé par sous-arbres, Q3 : tuiles, Q4 : codage entropique
+            if (line[0] != 'Q' || line[1] < '1' || line[1] > '4') {
+                fprintf(stderr, "Erreur : Format de fichier QTC inconnu\n");
+                return NULL;
+            }
+            *format = line[1] - '0';
+            dimensions = (sscanf(line + 2, "%d %d", width, height) == 2);
+        }
     }
 
     //  les 8 premiers bits (1 octet) pour la taille
-    uint8_t sizeByte;
-    if (fread(&sizeByte, sizeof(uint8_t), 1, file) != 1) {
+    if (p >= end) {
         fprintf(stderr, "Erreur : Impossible de lire la taille dans le fichier QTC\n");
         return NULL;
     }
+    *taille = *p++;
+    if (*taille > 30) {
+        fprintf(stderr, "Erreur : Profondeur %d invalide\n", *taille);
+        return NULL;
+    }
+    if (!dimensions) {
+        *width = *height = 1 << *taille;
+    } else if (*width < 1 || *height < 1 || *width > (1 << *taille) || *height > (1 << *taille)) {
+        fprintf(stderr, "Erreur : Dimensions %dx%d incompatibles avec la profondeur %d\n", *width, *height, *taille);
+        return NULL;
+    }
 
-    
-    *taille = sizeByte; 
+    if (p >= end) {
+        fprintf(stderr, "Erreur : Données binaires manquantes\n");
+        return NULL;
+    }
 
-    // Calculer la taille des données binaires restantes
-    long currentPos = ftell(file); //position actuelle dans le fichier
-    fseek(file, 0, SEEK_END);      //fin du fichier 
-    long fileSize = ftell(file);  //taille du fichier 
-    long binaryDataSize = fileSize - currentPos; // taille des donées binaire sans l'entete
+    *dataSize = end - p;
+    return p;
+}
 
-    fseek(file, currentPos, SEEK_SET); // reprendre depuis la position actuelle
 
-    if (binaryDataSize <= 0) {
-        fprintf(stderr, "Erreur : Données binaires manquantes\n");
+/**
+ * @brief Projette un fichier QTC : le flux binaire est lu en place, sans copie.
+ * 
+ * @param filename Nom du fichier QTC.
+ * @param file Pointeur vers le fichier projeté (à fermer par closeMappedFile).
+ * @param taille Pointeur où la profondeur lue sera stockée.
+ * @param width Pointeur où la largeur de l'image sera stockée.
+ * @param height Pointeur où la hauteur de l'image sera stockée.
+ * @param dataSize Pointeur où la taille des données binaires (en octets) sera stockée.
+ * @param format Pointeur où la version du format (1 à 4) sera stockée.
+ * @return Un pointeur vers les données binaires dans la projection, ou NULL en cas d'erreur (fichier fermé).
+ */
+const uint8_t* mapQTCFile(const char* filename, MappedFile* file, int* taille, int* width, int* height, size_t* dataSize, int* format) {
+    if (openMappedFile(filename, file) != 0) {
         return NULL;
     }
+    const uint8_t* data = parseQTCHeader(file->data, file->size, taille, width, height, dataSize, format);
+    if (!data) closeMappedFile(file);
+    return data;
+}
 
-    uint8_t* data = (uint8_t*)malloc(binaryDataSize);
-    if (!data) {
-        perror("Erreur : Allocation mémoire échouée");
+
+/**
+ * @brief Lit un fichier QTC et retourne les données binaires associées.
+ * 
+ * Cette fonction lit un fichier QTC . 
+ * Elle extrait la taille de la structure à partir du premier octet, puis 
+ * lit les données binaires restantes. Le flux est lu jusqu'au bout, sans se
+ * déplacer dans le fichier : il peut s'agir d'un tube.
+ * 
+ * @param file Pointeur vers le fichier ouvert en mode lecture.
+ * @param taille Pointeur où la taille lue sera stockée.
+ * @param width Pointeur où la largeur de l'image sera stockée.
+ * @param height Pointeur où la hauteur de l'image sera stockée.
+ * @param dataSize Pointeur où la taille des données binaires (en octets) sera stockée.
+ * @param format Pointeur où la version du format (1 à 4) sera stockée.
+ * @return Un pointeur vers les données binaires lues (tableau d'octets), 
+ * ou NULL en cas d'erreur.
+ * 
+ *  */
+uint8_t* readQTCFile(FILE* file, int* taille, int* width, int* height, size_t* dataSize, int* format) {
+    if (!file) {
+        fprintf(stderr, "Erreur : Fichier non valide\n");
         return NULL;
     }
 
-    if (fread(data, sizeof(uint8_t), binaryDataSize, file) != (size_t)binaryDataSize) {
-        fprintf(stderr, "Erreur : Lecture des données binaires échouée\n");
-        free(data);
+    size_t size;
+    uint8_t* buffer = readStream(file, &size);
+    if (!buffer) return NULL;
+
+    const uint8_t* data = parseQTCHeader(buffer, size, taille, width, height, dataSize, format);
+    if (!data) {
+        free(buffer);
         return NULL;
     }
 
-    return data; 
+    // Les données binaires sont ramenées au début du tampon, qui est renvoyé
+    memmove(buffer, data, *dataSize);
+    return buffer; 
 }
 
 
 /**
- * @brief Lit un nombre spécifié de bits depuis un tableau de données binaires.
+ * @brief Table de décodage de la fin d'un enregistrement de nœud interne.
  * 
- * Cette fonction lit `n` bits consécutifs depuis un tableau binaire, à partir 
- * d'un index donné. L'index est mis à jour après la lecture.
+ * Indexée par les 3 bits qui suivent `m` : epsilon (2 bits) puis, si epsilon == 0,
+ * uniform (1 bit). Chaque entrée contient epsilon (bits 0-1), uniform (bit 2)
+ * et le nombre de bits consommés (bits 4-5).
+ */
+static const uint8_t nodeTailTable[8] = {
+    0x30, 0x34,     // epsilon 0, uniform 0 / 1 : 3 bits
+    0x21, 0x21,     // epsilon 1 : 2 bits
+    0x22, 0x22,     // epsilon 2 : 2 bits
+    0x23, 0x23      // epsilon 3 : 2 bits
+};
+
+
+/**
+ * @brief Lit la fin de l'enregistrement d'un nœud interne (epsilon, uniform).
  * 
- * @param data Tableau contenant les données binaires.
- * @param bitIndex Pointeur vers l'index des bits à lire (mis à jour après lecture).
- * @param n Nombre de bits à lire.
- * @return La valeur des bits lus sous forme d'entier.
+ * @param reader Lecteur (au moins 3 bits disponibles).
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index du nœud.
+ * @return L'uniformité lue.
  */
-static uint8_t readBits(const uint8_t* data, size_t* bitIndex, int n) {
-    uint8_t value = 0;
-    size_t byteOffset = *bitIndex / 8;
-    int bitOffset = 7 - (*bitIndex % 8);
+static inline uint8_t readNodeTail(BitReader* reader, QuadTree* tree, int nodeIndex) {
+    uint8_t tail = nodeTailTable[peekBits(reader, 3)];
+    skipBits(reader, tail >> 4);
+    setNodeEpsilon(tree, nodeIndex, tail & 3);
+    return (tail >> 2) & 1;
+}
+
 
+/**
+ * @brief Compte les nœuds non uniformes d'une plage, 64 bits d'uniformité à la fois.
+ * 
+ * @param tree Pointeur vers le QuadTree.
+ * @param first Index du premier nœud de la plage.
+ * @param last Index suivant le dernier nœud de la plage.
+ * @return Le nombre de nœuds non uniformes.
+ */
+static int countNonUniform(const QuadTree* tree, int first, int last) {
+    int count = 0;
+    int end = last + UNIFORM_BIT_OFFSET;
+    for (int bit = first + UNIFORM_BIT_OFFSET; bit < end; ) {
+        int shift = bit & 63;
+        int n = (end - bit < 64 - shift) ? end - bit : 64 - shift;
+        uint64_t word = ~uniformWord(tree, bit >> 6) >> shift;
+        if (n < 64) word &= ((uint64_t)1 << n) - 1;
+        count += popcount64(word);
+        bit += n;
+    }
+    return count;
+}
 
 
-    //lecture des bits   
-    for (int i = 0; i < n; i++) {
-        // ajoute le bit actuel à la valeur
-        value = (value << 1) | ((data[byteOffset] >> bitOffset) & 1);
+/**
+ * @brief Décode les enfants d'un nœud au bord de l'image.
+ * 
+ * Les enfants hors de l'image ne sont pas codés : ils sont ajoutés comme nœuds uniformes.
+ * Avec k enfants dans l'image, la moyenne du dernier d'entre eux vaut k * m + epsilon du
+ * parent, moins celles des autres.
+ * 
+ * @param reader Lecteur positionné sur le premier enfant codé.
+ * @param tree Pointeur vers le QuadTree creux (indicateurs de bord alloués).
+ * @param parent Index du parent (non uniforme).
+ * @param child Index du premier enfant.
+ * @param level Niveau du parent.
+ * @param leaf 1 si les enfants sont des feuilles.
+ */
+static void decodeBorderGroup(BitReader* reader, QuadTree* tree, int parent, int child, int level, int leaf) {
+    uint8_t* borders = &tree->border[child];
+    uint8_t outside = childBorders(tree, level, tree->border[parent], borders);
+    int inside = 4 - popcount64(outside);
+    int sum = inside * getNodeM(tree, parent) + getNodeEpsilon(tree, parent);
+    uint8_t mask = 0;
 
-        if (--bitOffset < 0) {
-            bitOffset = 7; 
-            byteOffset++;
+    for (int i = 0; i < 4; i++) {
+        if (outside & (1 << i)) {
+            setNodeM(tree, child + i, 0);
+            setNodeEpsilon(tree, child + i, 0);
+            mask |= 1 << i;
+            continue;
+        }
+        if (reader->count < 11) refillBitReader(reader);
+        if (--inside > 0) {
+            setNodeM(tree, child + i, peekBits(reader, 8));
+            skipBits(reader, 8);
+            sum -= getNodeM(tree, child + i);
+        } else {
+            setNodeM(tree, child + i, sum);
+        }
+        if (leaf) {
+            setNodeEpsilon(tree, child + i, 0);
+            mask |= 1 << i;
+        } else {
+            mask |= readNodeTail(reader, tree, child + i) << i;
         }
-        (*bitIndex)++;
     }
-    return value;
+    setChildrenUniform(tree, (child - 1) / 4, mask);
+}
+
+
+/**
+ * @brief Décode les niveaux suivants d'un QuadTree creux, niveau par niveau.
+ * 
+ * Seuls les enfants des nœuds non uniformes sont codés : ils sont ajoutés à la suite
+ * de l'arbre, par groupes de quatre frères. Les trois `m` codés d'un groupe de feuilles
+ * sont lus en une fois, et la fin de l'enregistrement d'un nœud interne (epsilon,
+ * uniform) est décodée par nodeTailTable. Les enfants des nœuds au bord de l'image
+ * sont décodés à part (voir decodeBorderGroup).
+ * 
+ * @param reader Lecteur positionné sur le premier enfant codé.
+ * @param tree Pointeur vers le QuadTree creux, décodé jusqu'au niveau fromLevel.
+ * @param fromLevel Dernier niveau déjà décodé.
+ * @param lastLevel Dernier niveau à décoder.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+static int decodeLevels(BitReader* reader, QuadTree* tree, int fromLevel, int lastLevel) {
+    for (int level = fromLevel; level < lastLevel; level++) {
+        int leaf = (level + 1 == tree->depth);
+        int first = tree->levelFirst[level];
+        int last = tree->levelFirst[level + 1];
+
+        // Taille exacte du niveau suivant : quatre enfants par nœud non uniforme
+        int count = countNonUniform(tree, first, last);
+        if (reserveNodes(tree, tree->totalNodes + 4 * count) != 0) return -1;
+
+        int child = tree->totalNodes;
+        for (int parent = first; parent < last; parent++) {
+            //si le parent est uniforme ses enfants ne sont pas codés
+            if (isUniform(tree, parent)) continue;
+
+            if (tree->border && tree->border[parent]) {
+                decodeBorderGroup(reader, tree, parent, child, level, leaf);
+                child += 4;
+                continue;
+            }
+
+            // m4 n'est pas codé : 4 * m + epsilon du parent, moins les trois autres m
+            int sum4 = 4 * getNodeM(tree, parent) + getNodeEpsilon(tree, parent);
+            int group = (child - 1) / 4;
+
+            if (leaf) { // les feuilles ne codent que `m`
+                if (reader->count < 24) refillBitReader(reader);
+                uint32_t ms = peekBits(reader, 24);
+                skipBits(reader, 24);
+
+                uint8_t* m = &tree->m[child];
+                m[0] = ms >> 16;
+                m[1] = ms >> 8;
+                m[2] = ms;
+                m[3] = sum4 - (m[0] + m[1] + m[2]);
+                memset(&tree->epsilon[child], 0, 4);
+                setChildrenUniform(tree, group, 0xF); // Par défaut pour les feuilles
+                child += 4;
+                continue;
+            }
+
+            uint8_t mask = 0;
+            for (int i = 0; i < 4; i++) {
+                if (reader->count < 11) refillBitReader(reader);
+                if (i < 3) {
+                    setNodeM(tree, child + i, peekBits(reader, 8));
+                    skipBits(reader, 8);
+                } else {
+                    setNodeM(tree, child + 3, sum4 - (getNodeM(tree, child) + getNodeM(tree, child + 1) + getNodeM(tree, child + 2)));
+                }
+                mask |= readNodeTail(reader, tree, child + i) << i;
+            }
+            setChildrenUniform(tree, group, mask);
+            child += 4;
+        }
+
+        tree->totalNodes = child;
+        tree->levelFirst[level + 2] = child;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Décode la racine de l'arbre.
+ * 
+ * @param reader Lecteur positionné au début du flux.
+ * @param tree Pointeur vers le QuadTree à remplir.
+ */
+static void decodeRoot(BitReader* reader, QuadTree* tree) {
+    refillBitReader(reader);
+    setNodeM(tree, 0, peekBits(reader, 8));
+    skipBits(reader, 8);
+    if (tree->depth == 0) {
+        setNodeEpsilon(tree, 0, 0);
+        setUniform(tree, 0, 1);
+    } else {
+        setUniform(tree, 0, readNodeTail(reader, tree, 0));
+    }
 }
 
 
@@ -112,87 +341,567 @@ static uint8_t readBits(const uint8_t* data, size_t* bitIndex, int n) {
  * 
  * Cette fonction reconstruit les les noeuds d'un QuadTree en utilisant les données binaires 
  * fournies. Elle suit les règles spécifiques de compression pour déterminer les valeurs 
- * des neoud.
+ * des neoud (voir decodeLevels). Seuls les nœuds codés sont stockés.
  * 
  * @param data Tableau contenant les données binaires QTC.
- * @param tree Pointeur vers le QuadTree à remplir.
+ * @param dataSize Taille des données binaires en octets.
+ * @param tree Pointeur vers le QuadTree creux à remplir (voir createSparseQuadTree).
+ * @return 0 en cas de succès, -1 si les données sont absentes ou tronquées.
  * 
  */
-void fillQuadTreeFromQTC(const uint8_t* data, QuadTree* tree) {
-    if (!tree || !data) {
-        fprintf(stderr, "Erreur : QuadTree ou données binaires nulles\n");
-        return;
+int fillQuadTreeFromQTC(const uint8_t* data, size_t dataSize, QuadTree* tree) {
+    if (!tree || !data || !tree->sparse) {
+        fprintf(stderr, "Erreur : QuadTree creux ou données binaires nulles\n");
+        return -1;
+    }
+
+    BitReader reader;
+    initBitReader(&reader, data, dataSize);
+    decodeRoot(&reader, tree);
+    if (decodeLevels(&reader, tree, 0, tree->depth) != 0) return -1;
+
+    if (bitReaderOverrun(&reader)) {
+        fprintf(stderr, "Erreur : Données QTC tronquées\n");
+        return -1;
     }
+    return buildRankIndex(tree);
+}
+
+
+/**
+ * @brief Décode la racine et les premiers niveaux d'un QuadTree creux, puis construit son index des rangs.
+ * 
+ * @param reader Lecteur positionné sur la racine.
+ * @param tree Pointeur vers le QuadTree creux à remplir (voir createSparseQuadTree).
+ * @param lastLevel Dernier niveau à décoder (au plus la profondeur de l'arbre).
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int fillQuadTreeLevelsFromQTC(BitReader* reader, QuadTree* tree, int lastLevel) {
+    decodeRoot(reader, tree);
+    if (decodeLevels(reader, tree, 0, lastLevel) != 0) return -1;
+    return buildRankIndex(tree);
+}
+
+
+/**
+ * @brief Décode les descendants de la racine d'un QuadTree creux, puis construit son index des rangs.
+ * 
+ * @param reader Lecteur positionné sur les enfants de la racine.
+ * @param tree Pointeur vers le QuadTree creux, dont la racine (non uniforme) est remplie.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int fillSubtreeFromQTC(BitReader* reader, QuadTree* tree) {
+    if (decodeLevels(reader, tree, 0, tree->depth) != 0) return -1;
+    return buildRankIndex(tree);
+}
 
-    size_t bitIndex = 0; //  position des bits 
-    int nodeIndex = 0;  
 
-    while (nodeIndex < tree->totalNodes) {
-        QuadTreeNode* node = &tree->nodes[nodeIndex];
+/**
+ * @brief Table de décodage du symbole de fin d'un nœud interne (voir tailSymbol).
+ * 
+ * Chaque entrée contient epsilon (bits 0-1) et uniform (bit 2).
+ */
+static const uint8_t tailTable[TAIL_SYMBOLS] = { 0x00, 0x04, 0x01, 0x02, 0x03 };
 
-        //si le parent est uniforme on attribue m du parent directement à ce noeud
-        
-        QuadTreeNode* parent = getParentNode(tree, nodeIndex); 
 
-        if (parent && parent->uniform == 1) {
+/**
+ * @brief Décode l'epsilon et l'uniformité d'un nœud interne au format Q4.
+ * 
+ * @param decoder Décodeur rANS.
+ * @param model Contexte des fins de nœuds du niveau.
+ * @param tree Pointeur vers le QuadTree.
+ * @param nodeIndex Index du nœud.
+ * @return L'uniformité décodée.
+ */
+static inline uint8_t decodeTailEntropy(RansDecoder* decoder, RansModel* model, QuadTree* tree, int nodeIndex) {
+    uint8_t tail = tailTable[decodeSymbol(decoder, model)];
+    setNodeEpsilon(tree, nodeIndex, tail & 3);
+    return tail >> 2;
+}
 
-            node->m = parent->m;
-            node->epsilon = 0;
-            node->uniform = 1;
-            nodeIndex++;
-            continue; 
+
+/**
+ * @brief Décode les enfants d'un nœud au bord de l'image, au format Q4 (voir decodeBorderGroup).
+ * 
+ * @param decoder Décodeur rANS.
+ * @param model Modèle de contexte.
+ * @param tree Pointeur vers le QuadTree creux (indicateurs de bord alloués).
+ * @param parent Index du parent (non uniforme).
+ * @param child Index du premier enfant.
+ * @param level Niveau du parent.
+ * @param leaf 1 si les enfants sont des feuilles.
+ */
+static void decodeBorderGroupEntropy(RansDecoder* decoder, EntropyModel* model, QuadTree* tree, int parent, int child,
+                                     int level, int leaf) {
+    uint8_t outside = childBorders(tree, level, tree->border[parent], &tree->border[child]);
+    int inside = 4 - popcount64(outside);
+    int sum = inside * getNodeM(tree, parent) + getNodeEpsilon(tree, parent);
+    int ctx = levelContext(level + 1);
+    uint8_t predicted = getNodeM(tree, parent);
+    int total = 0;
+    int activity = 0;
+
+    for (int i = 0; i < 4; i++) {
+        if (outside & (1 << i)) {
+            setNodeM(tree, child + i, 0);
+            setNodeEpsilon(tree, child + i, 0);
+            continue;
+        }
+        if (--inside > 0) {
+            int z = decodeSymbol(decoder, &model->m[ctx][activity]);
+            total += z;
+            activity = nextActivity(total);
+            setNodeM(tree, child + i, unzigzagResidual(z, predicted));
+            sum -= getNodeM(tree, child + i);
+        } else {
+            setNodeM(tree, child + i, sum);
         }
+    }
+
+    uint8_t mask = outside;
+    for (int i = 0; i < 4; i++) {
+        if (outside & (1 << i)) continue;
+        if (leaf) {
+            setNodeEpsilon(tree, child + i, 0);
+            mask |= 1 << i;
+        } else {
+            mask |= decodeTailEntropy(decoder, &model->tail[ctx], tree, child + i) << i;
+        }
+    }
+    setChildrenUniform(tree, (child - 1) / 4, mask);
+}
 
-        if (isLeaf(tree, nodeIndex)) { //si c'est une feuille on ne peut lire que `m`
-            
-            if (!isFourthChild(nodeIndex)) { //on sait que le 4ème noeud n'est pas codé 
 
-                node->m = readBits(data, &bitIndex, 8);
-            } else {
-                QuadTreeNode* firstChild = &tree->nodes[nodeIndex - 3];
-                QuadTreeNode* secondChild = &tree->nodes[nodeIndex - 2];
-                QuadTreeNode* thirdChild = &tree->nodes[nodeIndex - 1];
+/**
+ * Reconstruit un QuadTree à partir de données au format Q4 (voir encoderQuadTreeEntropy).
+ * 
+ * Les niveaux sont décodés comme en Q1 (voir decodeLevels), chaque groupe de frères
+ * lisant ses trois moyennes codées puis, pour des nœuds internes, la fin de chaque enfant.
+ * 
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param tree Pointeur vers le QuadTree creux à remplir (voir createSparseQuadTree).
+ * @return 0 en cas de succès, -1 si les données sont absentes ou tronquées.
+ */
+int fillQuadTreeFromQTCEntropy(const uint8_t* data, size_t dataSize, QuadTree* tree) {
+    if (!tree || !data || !tree->sparse) {
+        fprintf(stderr, "Erreur : QuadTree creux ou données binaires nulles\n");
+        return -1;
+    }
+    EntropyModel* model = (EntropyModel*)malloc(sizeof(EntropyModel));
+    if (!model) {
+        perror("Erreur lors de l'allocation du modèle de contexte");
+        return -1;
+    }
+    initEntropyModel(model, tree->depth);
+
+    RansDecoder decoder;
+    initRansDecoder(&decoder, data, dataSize);
+    setNodeM(tree, 0, unzigzagResidual(decodeSymbol(&decoder, &model->m[0][0]), 128));
+    if (tree->depth == 0) {
+        setNodeEpsilon(tree, 0, 0);
+        setUniform(tree, 0, 1);
+    } else {
+        setUniform(tree, 0, decodeTailEntropy(&decoder, &model->tail[0], tree, 0));
+    }
+
+    for (int level = 0; level < tree->depth; level++) {
+        int leaf = (level + 1 == tree->depth);
+        int ctx = levelContext(level + 1);
+        RansModel* ms = model->m[ctx];
+        RansModel* tails = &model->tail[ctx];
+        int first = tree->levelFirst[level];
+        int last = tree->levelFirst[level + 1];
+
+        int count = countNonUniform(tree, first, last);
+        if (reserveNodes(tree, tree->totalNodes + 4 * count) != 0) {
+            free(model);
+            return -1;
+        }
 
-                node->m = (4 * parent->m + parent->epsilon) -
-                          (firstChild->m + secondChild->m + thirdChild->m);
+        int child = tree->totalNodes;
+        for (int parent = first; parent < last; parent++) {
+            if (isUniform(tree, parent)) continue;
+
+            if (tree->border && tree->border[parent]) {
+                decodeBorderGroupEntropy(&decoder, model, tree, parent, child, level, leaf);
+                child += 4;
+                continue;
             }
-            node->epsilon = 0;
-            node->uniform = 1; // Par défaut pour les feuilles
-      
-        } else { // cas des noeuds internes 
-
-            if (!isFourthChild(nodeIndex)) { 
-                //  m est codé pour trois enfants 
-                node->m = readBits(data, &bitIndex, 8);
-            } else {
-                // calcul du `m4` 
-                if (!parent) {
-                    fprintf(stderr, "Erreur : Nœud parent non trouvé pour le 4ème fils\n");
-                    return;
-                }
 
-                QuadTreeNode* firstChild = &tree->nodes[nodeIndex - 3];
-                QuadTreeNode* secondChild = &tree->nodes[nodeIndex - 2];
-                QuadTreeNode* thirdChild = &tree->nodes[nodeIndex - 1];
+            // m4 n'est pas codé : 4 * m + epsilon du parent, moins les trois autres m
+            uint8_t predicted = getNodeM(tree, parent);
+            int sum4 = 4 * predicted + getNodeEpsilon(tree, parent);
+            int z0 = decodeSymbol(&decoder, &ms[0]);
+            int z1 = decodeSymbol(&decoder, &ms[nextActivity(z0)]);
+            int z2 = decodeSymbol(&decoder, &ms[nextActivity(z0 + z1)]);
+            uint8_t m0 = unzigzagResidual(z0, predicted);
+            uint8_t m1 = unzigzagResidual(z1, predicted);
+            uint8_t m2 = unzigzagResidual(z2, predicted);
+            uint8_t m3 = sum4 - (m0 + m1 + m2);
+            uint32_t ms4 = m0 | m1 << 8 | m2 << 16 | (uint32_t)m3 << 24;
+            memcpy(&tree->m[child], &ms4, 4);
 
-                node->m = (4 * parent->m + parent->epsilon) -
-                          (firstChild->m + secondChild->m + thirdChild->m);
+            uint8_t mask = 0xF; // Par défaut pour les feuilles
+            uint32_t eps4 = 0;
+            if (!leaf) {
+                mask = 0;
+                for (int i = 0; i < 4; i++) {
+                    uint8_t tail = tailTable[decodeSymbol(&decoder, tails)];
+                    eps4 |= (uint32_t)(tail & 3) << (8 * i);
+                    mask |= (tail >> 2) << i;
+                }
             }
+            memcpy(&tree->epsilon[child], &eps4, 4);
+            setChildrenUniform(tree, (child - 1) / 4, mask);
+            child += 4;
+        }
+
+        tree->totalNodes = child;
+        tree->levelFirst[level + 2] = child;
+    }
+    free(model);
+
+    if (ransDecoderOverrun(&decoder)) {
+        fprintf(stderr, "Erreur : Données QTC tronquées\n");
+        return -1;
+    }
+    return buildRankIndex(tree);
+}
+
+
+/**
+ * @brief Décodage d'un groupe de sous-arbres du format Q2.
+ */
+typedef struct {
+    QuadTree* tree;
+    const uint8_t* stream;
+    size_t streamSize;
+    const uint64_t* offsets;    // positions des sous-flux du groupe
+    const uint64_t* ends;       // fins des sous-flux du groupe
+    QuadTree** subtrees;        // sous-arbres décodés du groupe (NULL si non codés)
+    int first;                  // position de la première racine du groupe dans le niveau split
+    int split;
+    int status;
+} SubtreeDecodeTask;
+
+
+/**
+ * @brief Décode les PARALLEL_GROUP sous-arbres d'une tâche.
+ * 
+ * Chaque sous-arbre codé est décodé dans son propre QuadTree creux, dont la racine
+ * est une copie du nœud du niveau split.
+ * 
+ * @param arg Pointeur vers un SubtreeDecodeTask.
+ */
+static void decodeSubtreeTask(void* arg) {
+    SubtreeDecodeTask* task = (SubtreeDecodeTask*)arg;
+    QuadTree* tree = task->tree;
 
-            // lire `epsilon` 
-            node->epsilon = readBits(data, &bitIndex, 2);
+    for (int i = 0; i < PARALLEL_GROUP; i++) {
+        int level;
+        int root = findNode(tree, task->split, task->first + i, &level);
+        if (level != task->split || isUniform(tree, root)) continue; // sous-flux vide
 
-            if (node->epsilon == 0) { // si epsilon est de valeur 0 donc uniforme et codé et on dot le lire 
-                node->uniform = readBits(data, &bitIndex, 1);
-            } else { // si epsilon ne vaut pas 0 , uniform=0 automatiquement
+        QuadTree* sub = createSparseQuadTree(tree->depth - task->split);
+        if (!sub) {
+            task->status = -1;
+            continue;
+        }
+        if (tree->border) {
+            // Partie de l'image couverte par le sous-arbre
+            int bx, by;
+            blockPosition(task->first + i, &bx, &by);
+            int width = tree->width - (bx << sub->depth), height = tree->height - (by << sub->depth);
+            int side = 1 << sub->depth;
+            if (setImageSize(sub, width < side ? width : side, height < side ? height : side) != 0) task->status = -1;
+        }
+        setNodeM(sub, 0, getNodeM(tree, root));
+        setNodeEpsilon(sub, 0, getNodeEpsilon(tree, root));
+        task->subtrees[i] = sub;
 
-                node->uniform = 0;
+        BitReader reader;
+        initBitReader(&reader, task->stream, task->streamSize);
+        seekBitReader(&reader, task->offsets[i]);
+        if (decodeLevels(&reader, sub, 0, sub->depth) != 0) task->status = -1;
+        if (bitReaderPosition(&reader) > task->ends[i]) task->status = -1;
+    }
+}
+
+
+/**
+ * @brief Ajoute les sous-arbres décodés sous le niveau split d'un QuadTree creux.
+ * 
+ * Dans chaque niveau, les descendants des nœuds du niveau split se suivent dans l'ordre
+ * de ces nœuds : le niveau est la concaténation des niveaux des sous-arbres. Les
+ * indicateurs de bord recopiés sont relatifs à chaque sous-arbre : seul BORDER_OUTSIDE
+ * garde son sens dans l'arbre entier.
+ * 
+ * @param tree Pointeur vers le QuadTree creux, décodé jusqu'au niveau split.
+ * @param subtrees Sous-arbres dans l'ordre du niveau split (NULL si non codés).
+ * @param nbRoots Nombre de positions du niveau split.
+ * @param split Niveau de découpage.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+static int mergeSubtrees(QuadTree* tree, QuadTree** subtrees, int nbRoots, int split) {
+    for (int k = 1; split + k <= tree->depth; k++) {
+        int count = 0;
+        for (int r = 0; r < nbRoots; r++) {
+            if (subtrees[r]) count += subtrees[r]->levelFirst[k + 1] - subtrees[r]->levelFirst[k];
+        }
+        if (reserveNodes(tree, tree->totalNodes + count) != 0) return -1;
+
+        // Les niveaux sont faits de groupes de quatre frères, alignés dans les deux arbres
+        int child = tree->totalNodes;
+        for (int r = 0; r < nbRoots; r++) {
+            QuadTree* sub = subtrees[r];
+            if (!sub) continue;
+            int first = sub->levelFirst[k];
+            int n = sub->levelFirst[k + 1] - first;
+            memcpy(&tree->m[child], &sub->m[first], n);
+            memcpy(&tree->epsilon[child], &sub->epsilon[first], n);
+            if (sub->border) memcpy(&tree->border[child], &sub->border[first], n);
+            for (int g = 0; g < n; g += 4) {
+                setChildrenUniform(tree, (child + g - 1) / 4, getChildrenUniform(sub, (first + g - 1) / 4));
             }
+            child += n;
+        }
+        tree->totalNodes = child;
+        tree->levelFirst[split + k + 1] = child;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Remplit un QuadTree à partir de données au format Q2, les sous-arbres étant décodés en parallèle.
+ * 
+ * @param data Données qui suivent l'octet de profondeur (niveau de découpage, index, flux).
+ * @param dataSize Taille des données en octets.
+ * @param tree Pointeur vers le QuadTree creux à remplir (voir createSparseQuadTree).
+ * @param pool Pool de threads (NULL pour un décodage séquentiel).
+ * @param indexBytes Pointeur où stocker la taille de l'index en octets (peut être NULL).
+ * @return 0 en cas de succès, -1 si les données sont invalides ou tronquées.
+ */
+int fillQuadTreeFromQTCIndexed(const uint8_t* data, size_t dataSize, QuadTree* tree, ThreadPool* pool, size_t* indexBytes) {
+    if (!tree || !data || dataSize < 1 || !tree->sparse) {
+        fprintf(stderr, "Erreur : QuadTree creux ou données binaires nulles\n");
+        return -1;
+    }
+
+    int split = data[0];
+    if (split < 2 || split > tree->depth) {
+        fprintf(stderr, "Erreur : Niveau de découpage %d invalide\n", split);
+        return -1;
+    }
+    int nbRoots = 1 << (2 * split);
+    size_t headerSize = 1 + 8 * (size_t)nbRoots;
+    if (dataSize < headerSize) {
+        fprintf(stderr, "Erreur : Index QTC tronqué\n");
+        return -1;
+    }
+    if (indexBytes) *indexBytes = headerSize;
+
+    const uint8_t* stream = data + headerSize;
+    size_t streamSize = dataSize - headerSize;
+    uint64_t* offsets = (uint64_t*)malloc((nbRoots + 1) * sizeof(uint64_t));
+    int nbTasks = nbRoots / PARALLEL_GROUP;
+    SubtreeDecodeTask* tasks = (SubtreeDecodeTask*)calloc(nbTasks, sizeof(SubtreeDecodeTask));
+    QuadTree** subtrees = (QuadTree**)calloc(nbRoots, sizeof(QuadTree*));
+    if (!offsets || !tasks || !subtrees) {
+        perror("Erreur lors de l'allocation de l'index");
+        free(offsets);
+        free(tasks);
+        free(subtrees);
+        return -1;
+    }
+
+    // Les positions doivent être croissantes et rester dans le flux
+    int status = 0;
+    for (int r = 0; r < nbRoots; r++) {
+        offsets[r] = getUint64(data + 1 + 8 * (size_t)r);
+        if (offsets[r] > streamSize * 8 || (r > 0 && offsets[r] < offsets[r - 1])) status = -1;
+    }
+    offsets[nbRoots] = streamSize * 8;
+    if (status != 0) {
+        fprintf(stderr, "Erreur : Index QTC invalide\n");
+        free(offsets);
+        free(tasks);
+        free(subtrees);
+        return -1;
+    }
+
+    // Niveaux 0 à split
+    BitReader reader;
+    initBitReader(&reader, stream, streamSize);
+    decodeRoot(&reader, tree);
+    if (decodeLevels(&reader, tree, 0, split) != 0 || buildRankIndex(tree) != 0) status = -1;
+    if (bitReaderPosition(&reader) > offsets[0]) status = -1;
+
+    // Sous-arbres du niveau split
+    int submitted = 0;
+    for (int t = 0; t < nbTasks && status == 0; t++, submitted++) {
+        SubtreeDecodeTask task = { tree, stream, streamSize, offsets + t * PARALLEL_GROUP, offsets + t * PARALLEL_GROUP + 1,
+                                   subtrees + t * PARALLEL_GROUP, t * PARALLEL_GROUP, split, 0 };
+        tasks[t] = task;
+        if (!pool || submitTask(pool, decodeSubtreeTask, &tasks[t]) != 0) decodeSubtreeTask(&tasks[t]);
+    }
+    if (pool) waitThreadPool(pool);
+    for (int t = 0; t < submitted; t++) {
+        if (tasks[t].status != 0) status = -1;
+    }
+
+    if (status == 0 && (mergeSubtrees(tree, subtrees, nbRoots, split) != 0 || buildRankIndex(tree) != 0)) status = -1;
+
+    for (int r = 0; r < nbRoots; r++) freeQuadTree(subtrees[r]);
+    free(subtrees);
+    free(offsets);
+    free(tasks);
+    if (status != 0) {
+        fprintf(stderr, "Erreur : Données QTC tronquées\n");
+    }
+    return status;
+}
+
+
+/**
+ * Repère le flux des niveaux supérieurs d'un fichier Q2 : la racine et les niveaux jusqu'au
+ * niveau de découpage, codés comme en Q1 au début du flux, avant les sous-arbres.
+ * 
+ * @param data Données qui suivent l'octet de profondeur (niveau de découpage, index, flux).
+ * @param dataSize Taille des données en octets.
+ * @param depth Profondeur de l'image.
+ * @param streamSize Pointeur où stocker la taille du flux en octets.
+ * @param split Pointeur où stocker le niveau de découpage (dernier niveau du flux).
+ * @return Le début du flux, ou NULL si l'en-tête Q2 est invalide.
+ */
+const uint8_t* indexedTopStream(const uint8_t* data, size_t dataSize, int depth, size_t* streamSize, int* split) {
+    if (!data || dataSize < 1 || data[0] < 2 || data[0] > depth) {
+        fprintf(stderr, "Erreur : Niveau de découpage invalide\n");
+        return NULL;
+    }
+    size_t headerSize = 1 + 8 * ((size_t)1 << (2 * data[0]));
+    if (dataSize < headerSize) {
+        fprintf(stderr, "Erreur : Index QTC tronqué\n");
+        return NULL;
+    }
+    *split = data[0];
+    *streamSize = dataSize - headerSize;
+    return data + headerSize;
+}
+
+
+/**
+ * @brief Peint un bloc uniforme, rogné aux dimensions de l'image.
+ * 
+ * @param image Image à remplir.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param x Coordonnée X du bloc (dans l'image).
+ * @param y Coordonnée Y du bloc (dans l'image).
+ * @param size Côté du bloc.
+ * @param m Intensité du bloc.
+ */
+static void paintBlock(uint8_t* image, int width, int height, int x, int y, int size, uint8_t m) {
+    int w = (size < width - x) ? size : width - x;
+    int h = (size < height - y) ? size : height - y;
+    uint8_t* corner = image + (size_t)y * width + x;
+
+    // Petits blocs entiers (les plus nombreux) : une écriture de taille fixe par ligne
+    if (w == size && h == size && size <= 8) {
+        uint64_t line = m * 0x0101010101010101ULL;
+        switch (size) {
+            case 8:
+                for (int row = 0; row < 8; row++) memcpy(corner + (size_t)row * width, &line, 8);
+                return;
+            case 4:
+                for (int row = 0; row < 4; row++) memcpy(corner + (size_t)row * width, &line, 4);
+                return;
+            case 2:
+                memcpy(corner, &line, 2);
+                memcpy(corner + width, &line, 2);
+                return;
+            case 1:
+                *corner = m;
+                return;
         }
+    }
+    for (int row = 0; row < h; row++) memset(corner + (size_t)row * width, m, w);
+}
 
-        nodeIndex++; 
+
+/**
+ * @brief Peint le bloc d'un nœud interne non uniforme (voir createDataFromTree).
+ * 
+ * L'index du premier petit-enfant n'est calculé qu'une fois par groupe de frères : dans
+ * un arbre creux, les petits-enfants des frères non uniformes se suivent, quatre par frère.
+ * 
+ * @param tree Pointeur vers le QuadTree contenant les données.
+ * @param data Tableau de données représentant l'image à remplir.
+ * @param grid Grille de segmentation (contour du nœud déjà tracé), ou NULL.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param childIndex Index du premier enfant du nœud.
+ * @param startX Coordonnée X du bloc du nœud (dans l'image).
+ * @param startY Coordonnée Y du bloc du nœud (dans l'image).
+ * @param size Côté du bloc du nœud.
+ */
+static void paintInternalNode(QuadTree* tree, uint8_t* data, uint8_t* grid, int width, int height, int childIndex,
+                              int startX, int startY, int size) {
+    if (isLeaf(tree, childIndex)) {
+        const uint8_t* m = &tree->m[childIndex];
+        if (startX + 1 < width && startY + 1 < height) {
+            // Enfants feuilles : quatre pixels (haut-gauche, haut-droit, bas-droit, bas-gauche)
+            uint8_t* row = data + (size_t)startY * width + startX;
+            row[0] = m[0];
+            row[1] = m[1];
+            row[width + 1] = m[2];
+            row[width] = m[3];
+        } else {
+            // Bloc rogné : seuls les pixels dans l'image
+            data[(size_t)startY * width + startX] = m[0];
+            if (startX + 1 < width) data[(size_t)startY * width + startX + 1] = m[1];
+            if (startY + 1 < height) data[(size_t)(startY + 1) * width + startX] = m[3];
+        }
+        return;
     }
 
+    // Enfants : haut-gauche, haut-droit, bas-droit, bas-gauche
+    static const int dx[4] = { 0, 1, 1, 0 }, dy[4] = { 0, 0, 1, 1 };
+    int halfSize = size / 2;
+    uint8_t uniform = getChildrenUniform(tree, (childIndex - 1) / 4);
+    int grandChild = tree->sparse ? getChildIndex(tree, childIndex) : 0;
+    for (int k = 0; k < 4; k++) {
+        int x = startX + dx[k] * halfSize, y = startY + dy[k] * halfSize;
+        if ((uniform >> k) & 1) {
+            if (x < width && y < height) paintBlock(data, width, height, x, y, halfSize, getNodeM(tree, childIndex + k));
+            continue;
+        }
+        if (!tree->sparse) grandChild = 4 * (childIndex + k) + 1;
+        if (x < width && y < height) {
+            if (grid) drawSegmentSides(grid, width, height, x, y, halfSize, childSegmentSides(k));
+            paintInternalNode(tree, data, grid, width, height, grandChild, x, y, halfSize);
+        }
+        grandChild += 4;
+    }
+}
+
+
+/**
+ * @brief Peint le bloc d'un nœud et, dans la grille, les côtés donnés de son bloc puis
+ * les contours de ses descendants non uniformes.
+ */
+static void paintNode(QuadTree* tree, uint8_t* data, uint8_t* grid, int width, int height, int nodeIndex,
+                      int startX, int startY, int size, int sides) {
+    if (startX >= width || startY >= height) return; // bloc hors de l'image
+
+    if (grid && sides) drawSegmentSides(grid, width, height, startX, startY, size, sides);
+    if (isLeaf(tree, nodeIndex) || isUniform(tree, nodeIndex)) {
+        // Feuille ou bloc uniforme : une ligne du bloc par memset
+        paintBlock(data, width, height, startX, startY, size, getNodeM(tree, nodeIndex));
+        return;
+    }
+    paintInternalNode(tree, data, grid, width, height, getChildIndex(tree, nodeIndex), startX, startY, size);
 }
 
 
@@ -200,11 +909,17 @@ void fillQuadTreeFromQTC(const uint8_t* data, QuadTree* tree) {
  * @brief Génère les données d'image à partir d'un QuadTree.
  * 
  * Cette fonction remplit un tableau représentant une image en divisant l'image en blocs 
- * selon la structure du QuadTree. Les feuilles du QuadTree contiennent les intensités 
- * à appliquer aux blocs correspondants.
+ * selon la structure du QuadTree. Les feuilles et les nœuds uniformes du QuadTree
+ * contiennent les intensités à appliquer aux blocs correspondants ; un bloc uniforme est
+ * peint d'un coup, une ligne par memset, sans descendre plus bas. Les blocs sont
+ * rognés aux dimensions de l'image : ceux qui en sortent ne sont pas visités.
+ * 
+ * La grille de segmentation, si elle est demandée, est tracée pendant le même parcours
+ * (même résultat que generateSegmentationGrid à partir du même nœud).
  * 
  * @param tree Pointeur vers le QuadTree contenant les données.
  * @param data Tableau de données représentant l'image à remplir.
+ * @param grid Grille de segmentation à tracer (même taille que l'image), ou NULL.
  * @param width Largeur de l'image.
  * @param height Hauteur de l'image.
  * @param nodeIndex Index du nœud actuel dans le QuadTree.
@@ -212,28 +927,493 @@ void fillQuadTreeFromQTC(const uint8_t* data, QuadTree* tree) {
  * @param startY Coordonnée Y de départ pour le bloc courant.
  * @param size Taille du bloc courant (longueur du côté).
  */
-void createDataFromTree(QuadTree* tree, uint8_t* data, int width, int height, int nodeIndex, int startX, int startY, int size) {
-    if (isLeaf(tree, nodeIndex)) {
-        // Si c'est une feuille, remplir le bloc correspondant dans les données de l'image
-        for (int y = 0; y < size; y++) {
-            for (int x = 0; x < size; x++) {
-                data[(startY + y) * width + (startX + x)] = tree->nodes[nodeIndex].m;
+void createDataFromTree(QuadTree* tree, uint8_t* data, uint8_t* grid, int width, int height, int nodeIndex,
+                        int startX, int startY, int size) {
+    paintNode(tree, data, grid, width, height, nodeIndex, startX, startY, size, isUniform(tree, nodeIndex) ? 0 : SEGMENT_OUTLINE);
+}
+
+
+/**
+ * @brief Taille visée d'une bande de reconstruction (lignes entières de l'image), pour
+ * qu'elle reste dans le cache pendant que ses blocs sont peints.
+ */
+#define PAINT_BAND_BYTES (1 << 17)
+
+/**
+ * @brief Hauteur minimale d'une bande (2^PAINT_MIN_SHIFT lignes), pour les images très larges.
+ */
+#define PAINT_MIN_SHIFT 3
+
+
+/**
+ * @brief Tâche de reconstruction d'une bande de l'image.
+ */
+typedef struct {
+    QuadTree* tree;
+    uint8_t* data;
+    uint8_t* grid;  // grille de segmentation, ou NULL
+    int width;
+    int height;
+    int shift;      // les blocs de la bande ont 2^shift pixels de côté
+    int band;       // ligne des blocs de la bande
+} PaintTask;
+
+
+/**
+ * @brief Côtés d'un bloc situés sur le contour d'un bloc d'un niveau supérieur.
+ * 
+ * @param bx Colonne du bloc.
+ * @param by Ligne du bloc.
+ * @param levels Écart entre les niveaux des deux blocs.
+ * @return Masque des côtés du bloc sur le contour du bloc qui le contient.
+ */
+static int sidesOnAncestor(int bx, int by, int levels) {
+    int last = (1 << levels) - 1;
+    return ((by & last) == 0 ? SEGMENT_TOP : 0) | ((bx & last) == last ? SEGMENT_RIGHT : 0)
+         | ((by & last) == last ? SEGMENT_BOTTOM : 0) | ((bx & last) == 0 ? SEGMENT_LEFT : 0);
+}
+
+
+/**
+ * @brief Reconstruit les blocs d'une bande, de gauche à droite.
+ * 
+ * Un bloc couvert par un ancêtre uniforme est rempli avec la moyenne de cet ancêtre.
+ * Dans la grille, chaque bloc trace sa part des contours de ses ancêtres : son propre
+ * contour s'il est non uniforme (il contient alors celui de ses ancêtres), sinon ceux de
+ * ses côtés qui sont sur le contour du parent de son ancêtre uniforme.
+ * 
+ * @param arg Pointeur vers une PaintTask.
+ */
+static void paintTask(void* arg) {
+    PaintTask* task = (PaintTask*)arg;
+    int level = task->tree->depth - task->shift;
+    int size = 1 << task->shift;
+    int cols = coveringBlocks(task->width, task->shift);
+
+    for (int bx = 0; bx < cols; bx++) {
+        int nodeLevel;
+        int nodeIndex = findNode(task->tree, level, blockOffset(bx, task->band), &nodeLevel);
+        int sides = 0;
+        if (task->grid) {
+            if (!isUniform(task->tree, nodeIndex)) sides = SEGMENT_OUTLINE;
+            else if (nodeLevel > 0) sides = sidesOnAncestor(bx, task->band, level - nodeLevel + 1);
+        }
+        paintNode(task->tree, task->data, task->grid, task->width, task->height, nodeIndex, bx * size, task->band * size,
+                  size, sides);
+    }
+}
+
+
+/**
+ * @brief Génère les données d'image à partir d'un QuadTree, par bandes reconstruites en parallèle.
+ * 
+ * L'image est découpée en bandes de lignes entières, assez basses pour tenir dans le
+ * cache (voir PAINT_BAND_BYTES) : chaque bande est écrite d'un bloc, de haut en bas, au
+ * lieu d'être parcourue en ordre Z sur toute la hauteur de l'image. Les blocs uniformes
+ * sont peints ligne par ligne (memset), sans descendre jusqu'aux pixels.
+ * 
+ * @param tree Pointeur vers le QuadTree contenant les données.
+ * @param data Tableau de données représentant l'image à remplir (dimensions du QuadTree).
+ * @param grid Grille de segmentation à tracer (même taille que l'image), ou NULL.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param pool Pool de threads (NULL pour une reconstruction séquentielle).
+ */
+void createDataFromTreeParallel(QuadTree* tree, uint8_t* data, uint8_t* grid, int width, int height, ThreadPool* pool) {
+    int shift = PAINT_MIN_SHIFT;
+    while (shift < tree->depth && ((int64_t)width << (shift + 1)) <= PAINT_BAND_BYTES) shift++;
+    if (shift > tree->depth) shift = tree->depth;
+
+    int nbTasks = coveringBlocks(height, shift);
+    PaintTask* tasks = (PaintTask*)malloc(nbTasks * sizeof(PaintTask));
+    if (!tasks) {
+        createDataFromTree(tree, data, grid, width, height, 0, 0, 0, 1 << tree->depth);
+        return;
+    }
+
+    for (int t = 0; t < nbTasks; t++) {
+        PaintTask task = { tree, data, grid, width, height, shift, t };
+        tasks[t] = task;
+        if (!pool || submitTask(pool, paintTask, &tasks[t]) != 0) paintTask(&tasks[t]);
+    }
+    if (pool) waitThreadPool(pool);
+    free(tasks);
+}
+
+
+/**
+ * @brief Nœud non uniforme conservé par decodeQTCImage : colonne et ligne de son bloc dans
+ * son niveau (BLOCK_COORD_BITS bits chacune), puis son epsilon.
+ */
+#define BLOCK_COORD_BITS (MAX_TREE_DEPTH - 1)
+#define BLOCK_COORD_MASK ((1u << BLOCK_COORD_BITS) - 1)
+
+
+/**
+ * @brief Range la position et l'epsilon d'un nœud non uniforme dans un entier.
+ */
+static inline uint32_t packBlock(uint32_t bx, uint32_t by, uint32_t epsilon) {
+    return bx | by << BLOCK_COORD_BITS | epsilon << (2 * BLOCK_COORD_BITS);
+}
+
+
+/**
+ * @brief État d'un décodage direct d'un flux unique dans l'image.
+ */
+typedef struct {
+    int format;
+    BitReader reader;       // format Q1
+    RansDecoder decoder;    // format Q4
+    EntropyModel* model;    // format Q4
+    uint8_t* image;
+    uint8_t* grid;
+    int width;              // dimensions de l'image produite (réduite si level < depth)
+    int height;
+    int depth;              // profondeur de l'arbre codé
+    int level;              // dernier niveau décodé : ses blocs sont les pixels de l'image
+} ImageDecoder;
+
+
+/**
+ * @brief Lit un groupe de quatre frères au format Q1 (voir decodeLevels et decodeBorderGroup).
+ * 
+ * @param reader Lecteur positionné sur le premier enfant codé.
+ * @param m Moyenne du parent.
+ * @param epsilon Epsilon du parent.
+ * @param outside Masque des enfants hors de l'image (non codés).
+ * @param leaf 1 si les enfants sont des feuilles.
+ * @param ms Tableau recevant les moyennes des enfants.
+ * @param tails Tableau recevant l'epsilon (bits 0-1) et l'uniformité (bit 2) des enfants internes.
+ */
+static inline void readGroupQ1(BitReader* reader, uint8_t m, uint8_t epsilon, uint8_t outside, int leaf,
+                               uint8_t ms[4], uint8_t tails[4]) {
+    if (!outside) {
+        int sum4 = 4 * m + epsilon;
+        if (leaf) {
+            if (reader->count < 24) refillBitReader(reader);
+            uint32_t bits = peekBits(reader, 24);
+            skipBits(reader, 24);
+            ms[0] = bits >> 16;
+            ms[1] = bits >> 8;
+            ms[2] = bits;
+            ms[3] = sum4 - (ms[0] + ms[1] + ms[2]);
+            return;
+        }
+        for (int i = 0; i < 4; i++) {
+            if (reader->count < 11) refillBitReader(reader);
+            if (i < 3) {
+                ms[i] = peekBits(reader, 8);
+                skipBits(reader, 8);
+            } else {
+                ms[3] = sum4 - (ms[0] + ms[1] + ms[2]);
             }
+            uint8_t tail = nodeTailTable[peekBits(reader, 3)];
+            skipBits(reader, tail >> 4);
+            tails[i] = tail & 7;
         }
         return;
     }
 
-    // Nœud interne : diviser en 4 sous-blocs
-    int halfSize = size / 2;
-    int childIndex = 4 * nodeIndex + 1;
+    int inside = 4 - popcount64(outside);
+    int sum = inside * m + epsilon;
+    for (int i = 0; i < 4; i++) {
+        if (outside & (1 << i)) continue;
+        if (reader->count < 11) refillBitReader(reader);
+        if (--inside > 0) {
+            ms[i] = peekBits(reader, 8);
+            skipBits(reader, 8);
+            sum -= ms[i];
+        } else {
+            ms[i] = sum;
+        }
+        if (!leaf) {
+            uint8_t tail = nodeTailTable[peekBits(reader, 3)];
+            skipBits(reader, tail >> 4);
+            tails[i] = tail & 7;
+        }
+    }
+}
+
+
+/**
+ * @brief Lit un groupe de quatre frères au format Q4 (voir fillQuadTreeFromQTCEntropy).
+ * 
+ * @param decoder Décodeur rANS.
+ * @param model Modèle de contexte.
+ * @param ctx Contexte de niveau des enfants.
+ * @param m Moyenne du parent.
+ * @param epsilon Epsilon du parent.
+ * @param outside Masque des enfants hors de l'image (non codés).
+ * @param leaf 1 si les enfants sont des feuilles.
+ * @param ms Tableau recevant les moyennes des enfants.
+ * @param tails Tableau recevant l'epsilon (bits 0-1) et l'uniformité (bit 2) des enfants internes.
+ */
+static inline void readGroupQ4(RansDecoder* decoder, EntropyModel* model, int ctx, uint8_t m, uint8_t epsilon,
+                               uint8_t outside, int leaf, uint8_t ms[4], uint8_t tails[4]) {
+    RansModel* contexts = model->m[ctx];
+    if (!outside) {
+        int z0 = decodeSymbol(decoder, &contexts[0]);
+        int z1 = decodeSymbol(decoder, &contexts[nextActivity(z0)]);
+        int z2 = decodeSymbol(decoder, &contexts[nextActivity(z0 + z1)]);
+        ms[0] = unzigzagResidual(z0, m);
+        ms[1] = unzigzagResidual(z1, m);
+        ms[2] = unzigzagResidual(z2, m);
+        ms[3] = 4 * m + epsilon - (ms[0] + ms[1] + ms[2]);
+        if (leaf) return;
+        for (int i = 0; i < 4; i++) tails[i] = tailTable[decodeSymbol(decoder, &model->tail[ctx])];
+        return;
+    }
+
+    int inside = 4 - popcount64(outside);
+    int sum = inside * m + epsilon;
+    int total = 0;
+    int activity = 0;
+
+    for (int i = 0; i < 4; i++) {
+        if (outside & (1 << i)) continue;
+        if (--inside > 0) {
+            int z = decodeSymbol(decoder, &contexts[activity]);
+            total += z;
+            activity = nextActivity(total);
+            ms[i] = unzigzagResidual(z, m);
+            sum -= ms[i];
+        } else {
+            ms[i] = sum;
+        }
+    }
+    if (leaf) return;
+    for (int i = 0; i < 4; i++) {
+        if (!(outside & (1 << i))) tails[i] = tailTable[decodeSymbol(decoder, &model->tail[ctx])];
+    }
+}
+
+
+/**
+ * @brief Lit la racine, puis la peint si elle est uniforme.
+ * 
+ * @param d État du décodage.
+ * @param epsilon Pointeur où stocker l'epsilon de la racine.
+ * @param stats Bilan à compléter.
+ * @return 1 si la racine a des enfants codés, 0 sinon.
+ */
+static int readImageRoot(ImageDecoder* d, uint8_t* epsilon, DecodeStats* stats) {
+    uint8_t m, tail = 0x04;
+    if (d->format == 4) {
+        m = unzigzagResidual(decodeSymbol(&d->decoder, &d->model->m[0][0]), 128);
+        if (d->depth > 0) tail = tailTable[decodeSymbol(&d->decoder, &d->model->tail[0])];
+    } else {
+        refillBitReader(&d->reader);
+        m = peekBits(&d->reader, 8);
+        skipBits(&d->reader, 8);
+        if (d->depth > 0) {
+            tail = nodeTailTable[peekBits(&d->reader, 3)];
+            skipBits(&d->reader, tail >> 4);
+        }
+    }
 
-    // Haut-gauche
-    createDataFromTree(tree, data, width, height, childIndex, startX, startY, halfSize);
-    // Haut-droit
-    createDataFromTree(tree, data, width, height, childIndex + 1, startX + halfSize, startY, halfSize);
-    // Bas-droit
-    createDataFromTree(tree, data, width, height, childIndex + 2, startX + halfSize, startY + halfSize, halfSize);
-    // Bas-gauche
-    createDataFromTree(tree, data, width, height, childIndex + 3, startX, startY + halfSize, halfSize);
+    stats->nodes = 1;
+    stats->fields.nodes = 1;
+    stats->fields.mBits = 8;
+    if (d->depth > 0) {
+        stats->fields.epsilonBits = 2;
+        stats->fields.uniformBits = (tail & 3) == 0;
+    }
+
+    *epsilon = tail & 3;
+    if (tail & 4 || d->level == 0) {
+        paintBlock(d->image, d->width, d->height, 0, 0, 1 << d->level, m);
+        return 0;
+    }
+    d->image[0] = m;
+    if (d->grid) drawSegmentOutline(d->grid, d->width, d->height, 0, 0, 1 << d->level);
+    return 1;
 }
 
+
+/**
+ * @brief Décode les niveaux d'un flux unique dans l'image (voir decodeQTCImage).
+ * 
+ * @param d État du décodage.
+ * @param stats Bilan à compléter.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+static int decodeImageLevels(ImageDecoder* d, DecodeStats* stats) {
+    uint8_t* image = d->image;
+    int width = d->width;
+    int height = d->height;
+
+    uint8_t epsilon;
+    int count = readImageRoot(d, &epsilon, stats);
+    uint32_t* nodes = (uint32_t*)malloc(sizeof(uint32_t));
+    if (!nodes) {
+        perror("Erreur lors de l'allocation des niveaux");
+        return -1;
+    }
+    nodes[0] = packBlock(0, 0, epsilon);
+    stats->bytes = sizeof(uint32_t);
+
+    // Copie locale du décodeur rANS : ses états restent dans des registres malgré les
+    // écritures de pixels, qui pourraient sinon les modifier aux yeux du compilateur
+    RansDecoder decoder = d->decoder;
+    EntropyModel* model = d->model;
+
+    for (int level = 0; level < d->level && count > 0; level++) {
+        int leaf = (level + 1 == d->depth);     // enfants sans epsilon ni uniformité
+        int pixels = (level + 1 == d->level);   // enfants écrits comme pixels
+        int ctx = levelContext(level + 1);
+        int shift = d->level - level - 1;
+        int half = 1 << shift; // côté des enfants
+
+        // Niveau suivant : au plus quatre enfants non uniformes par nœud
+        uint32_t* next = NULL;
+        if (!pixels) {
+            next = (uint32_t*)malloc(4 * (size_t)count * sizeof(uint32_t));
+            if (!next) {
+                perror("Erreur lors de l'allocation des niveaux");
+                free(nodes);
+                d->decoder = decoder;
+                return -1;
+            }
+            size_t bytes = 5 * (size_t)count * sizeof(uint32_t);
+            if (bytes > stats->bytes) stats->bytes = bytes;
+        }
+
+        int nextCount = 0;
+        uint8_t ms[4], tails[4];
+        for (int j = 0; j < count; j++) {
+            uint32_t bx = nodes[j] & BLOCK_COORD_MASK;
+            uint32_t by = (nodes[j] >> BLOCK_COORD_BITS) & BLOCK_COORD_MASK;
+            int x = bx << (shift + 1);
+            int y = by << (shift + 1);
+            uint8_t* corner = image + (size_t)y * width + x;
+
+            // La moyenne du parent est dans le premier pixel de son bloc
+            uint8_t outside = 0;
+            if (x + half >= width) outside |= 0x6;  // enfants de droite
+            if (y + half >= height) outside |= 0xC; // enfants du bas
+            if (d->format == 4) {
+                readGroupQ4(&decoder, model, ctx, *corner, nodes[j] >> (2 * BLOCK_COORD_BITS), outside, leaf, ms, tails);
+            } else {
+                readGroupQ1(&d->reader, *corner, nodes[j] >> (2 * BLOCK_COORD_BITS), outside, leaf, ms, tails);
+            }
+
+            int inside = 4 - popcount64(outside);
+            stats->nodes += 4;
+            stats->fields.nodes += leaf ? inside - 1 : inside;
+            stats->fields.mBits += 8 * (inside - 1);
+            if (!leaf) {
+                stats->fields.epsilonBits += 2 * inside;
+                for (int i = 0; i < 4; i++) {
+                    if (!(outside & (1 << i))) stats->fields.uniformBits += (tails[i] & 3) == 0;
+                }
+            }
+
+            if (pixels) {
+                // Haut-gauche, haut-droit, bas-droit, bas-gauche
+                if (!outside) {
+                    corner[0] = ms[0];
+                    corner[1] = ms[1];
+                    corner[width + 1] = ms[2];
+                    corner[width] = ms[3];
+                } else {
+                    corner[0] = ms[0];
+                    if (!(outside & 0x2)) corner[1] = ms[1];
+                    if (!(outside & 0x8)) corner[width] = ms[3];
+                }
+                continue;
+            }
+
+            for (int i = 0; i < 4; i++) {
+                if (outside & (1 << i)) continue;
+                uint32_t dx = (i == 1 || i == 2);
+                uint32_t dy = i >> 1;
+                int cx = x + dx * half;
+                int cy = y + dy * half;
+                if (tails[i] & 4) {
+                    paintBlock(image, width, height, cx, cy, half, ms[i]);
+                    continue;
+                }
+                image[(size_t)cy * width + cx] = ms[i];
+                next[nextCount++] = packBlock(2 * bx + dx, 2 * by + dy, tails[i] & 3);
+                if (d->grid) drawSegmentSides(d->grid, width, height, cx, cy, half, childSegmentSides(i));
+            }
+        }
+
+        free(nodes);
+        nodes = next;
+        count = nextCount;
+    }
+    free(nodes);
+    d->decoder = decoder;
+    return 0;
+}
+
+
+/**
+ * Décode un flux unique (format Q1 ou Q4) directement dans l'image, sans construire l'arbre.
+ * 
+ * Le flux est lu niveau par niveau, dans l'ordre de fillQuadTreeFromQTC. Seuls les nœuds
+ * non uniformes du niveau en cours sont conservés, avec la position de leur bloc et leur
+ * epsilon ; leur moyenne est rangée dans le premier pixel de leur bloc, que leurs enfants
+ * recouvrent ensuite. Un bloc uniforme est peint dès qu'il est lu, et les feuilles sont
+ * écrites directement dans l'image.
+ * 
+ * Avec level < depth, la lecture s'arrête après le niveau level : chaque bloc de ce niveau
+ * devient un pixel, de valeur la moyenne du bloc (ou de son ancêtre uniforme).
+ * 
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param format Version du format (1 ou 4).
+ * @param width Largeur de l'image codée.
+ * @param height Hauteur de l'image codée.
+ * @param depth Profondeur de l'image codée.
+ * @param level Dernier niveau à décoder (au plus depth).
+ * @param image Image à remplir, de coveringBlocks(width, depth - level) pixels sur
+ *              coveringBlocks(height, depth - level).
+ * @param grid Grille de segmentation à tracer (même taille que l'image), ou NULL.
+ * @param stats Pointeur où stocker le bilan du décodage.
+ * @return 0 en cas de succès, -1 si les données sont invalides ou tronquées.
+ */
+int decodeQTCImage(const uint8_t* data, size_t dataSize, int format, int width, int height, int depth, int level,
+                   uint8_t* image, uint8_t* grid, DecodeStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!data || !image || (format != 1 && format != 4)) {
+        fprintf(stderr, "Erreur : Données binaires nulles ou format non décodable directement\n");
+        return -1;
+    }
+    if (depth < 0 || depth > MAX_TREE_DEPTH || level < 0 || level > depth) {
+        fprintf(stderr, "Erreur : Profondeur %d ou niveau %d invalide\n", depth, level);
+        return -1;
+    }
+
+    ImageDecoder d;
+    memset(&d, 0, sizeof(d));
+    d.format = format;
+    d.image = image;
+    d.grid = grid;
+    d.width = coveringBlocks(width, depth - level);
+    d.height = coveringBlocks(height, depth - level);
+    d.depth = depth;
+    d.level = level;
+    if (format == 4) {
+        d.model = (EntropyModel*)malloc(sizeof(EntropyModel));
+        if (!d.model) {
+            perror("Erreur lors de l'allocation du modèle de contexte");
+            return -1;
+        }
+        initEntropyModel(d.model, depth);
+        initRansDecoder(&d.decoder, data, dataSize);
+    } else {
+        initBitReader(&d.reader, data, dataSize);
+    }
+
+    int status = decodeImageLevels(&d, stats);
+    free(d.model);
+    if (status != 0) return -1;
+
+    if (format == 4 ? ransDecoderOverrun(&d.decoder) : bitReaderOverrun(&d.reader)) {
+        fprintf(stderr, "Erreur : Données QTC tronquées\n");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "entropy.h"
+
+
+/**
+ * @brief Initialise un contexte : tous les symboles équiprobables.
+ *
+ * @param model Pointeur vers le contexte.
+ * @param symbols Taille de l'alphabet.
+ */
+static void initRansModel(RansModel* model, int symbols) {
+    model->symbols = symbols;
+    for (int s = 0; s < symbols; s++) model->counts[s] = 1;
+    model->interval = 8;
+    rebuildRansModel(model);
+}
+
+
+/**
+ * Initialise les contextes d'un modèle utiles à un arbre de profondeur donnée.
+ *
+ * @param model Pointeur vers le modèle.
+ * @param depth Profondeur de l'arbre.
+ */
+void initEntropyModel(EntropyModel* model, int depth) {
+    for (int level = 0; level <= levelContext(depth); level++) {
+        for (int a = 0; a < ENTROPY_ACTIVITY; a++) initRansModel(&model->m[level][a], M_SYMBOLS);
+        initRansModel(&model->tail[level], TAIL_SYMBOLS);
+    }
+}
+
+
+/**
+ * Reconstruit les fréquences et la table de décodage d'un contexte à partir de ses comptes.
+ *
+ * Chaque symbole garde une fréquence d'au moins 1 ; le reste de RANS_SCALE est réparti
+ * proportionnellement aux comptes, l'arrondi allant au symbole le plus fréquent. Les
+ * comptes sont divisés par deux quand leur somme devient trop grande, pour suivre les
+ * variations de la distribution d'un niveau à l'autre de l'image.
+ *
+ * @param model Pointeur vers le contexte.
+ */
+void rebuildRansModel(RansModel* model) {
+    int n = model->symbols;
+    uint32_t total = 0;
+    for (int s = 0; s < n; s++) total += model->counts[s];
+    if (total > RANS_MAX_TOTAL) {
+        total = 0;
+        for (int s = 0; s < n; s++) {
+            model->counts[s] = (model->counts[s] + 1) >> 1;
+            total += model->counts[s];
+        }
+    }
+
+    uint16_t freq[M_SYMBOLS];
+    uint64_t scale = ((uint64_t)(RANS_SCALE - n) << 32) / total;
+    int sum = 0, best = 0;
+    for (int s = 0; s < n; s++) {
+        freq[s] = (uint16_t)(((model->counts[s] * scale) >> 32) + 1);
+        sum += freq[s];
+        if (model->counts[s] > model->counts[best]) best = s;
+    }
+    freq[best] += RANS_SCALE - sum;
+
+    int start = 0;
+    for (int s = 0; s < n; s++) {
+        model->ranges[s] = (uint32_t)start | (uint32_t)freq[s] << 16;
+        memset(model->lookup + start, s, freq[s]);
+        start += freq[s];
+    }
+
+    if (model->interval < RANS_MAX_INTERVAL) model->interval *= 2;
+    model->left = model->interval;
+}
+
+
+/**
+ * Initialise un codeur vide.
+ *
+ * @param encoder Pointeur vers le codeur.
+ */
+void initRansEncoder(RansEncoder* encoder) {
+    memset(encoder, 0, sizeof(RansEncoder));
+}
+
+
+/**
+ * Agrandit le tableau des symboles enregistrés d'un codeur.
+ *
+ * @param encoder Pointeur vers le codeur.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int growRansEncoder(RansEncoder* encoder) {
+    size_t capacity = encoder->capacity ? 2 * encoder->capacity : 4096;
+    uint32_t* symbols = (uint32_t*)realloc(encoder->symbols, capacity * sizeof(uint32_t));
+    if (!symbols) {
+        perror("Erreur lors de l'allocation du tampon de codage");
+        encoder->error = 1;
+        return -1;
+    }
+    encoder->symbols = symbols;
+    encoder->capacity = capacity;
+    return 0;
+}
+
+
+/**
+ * Code les symboles enregistrés et écrit le flux obtenu.
+ *
+ * Les symboles sont codés du dernier au premier, les symboles pairs par le premier état
+ * et les impairs par le second ; les mots de renormalisation, produits eux aussi à
+ * rebours, sont rangés depuis la fin d'un tampon. Le flux commence par les deux états
+ * finaux (4 octets chacun), suivis des mots de 16 bits dans l'ordre où le décodeur les
+ * lit, tous gros-boutistes. Chaque symbole produit au plus un mot.
+ *
+ * @param encoder Pointeur vers le codeur (vidé, mais à libérer par freeRansEncoder).
+ * @param out Écrivain recevant les octets du flux.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int flushRansEncoder(RansEncoder* encoder, BitWriter* out) {
+    if (encoder->error) return -1;
+
+    size_t capacity = 2 * encoder->count + 8;
+    uint8_t* buffer = (uint8_t*)malloc(capacity);
+    if (!buffer) {
+        perror("Erreur lors de l'allocation du tampon de codage");
+        return -1;
+    }
+
+    uint8_t* p = buffer + capacity;
+    uint32_t states[2] = { RANS_LOW, RANS_LOW };
+    for (size_t i = encoder->count; i-- > 0; ) {
+        uint32_t* state = &states[i & 1];
+        uint32_t start = encoder->symbols[i] & 0xFFFF;
+        uint32_t freq = encoder->symbols[i] >> 16;
+        uint32_t limit = ((RANS_LOW >> RANS_SCALE_BITS) << 16) * freq;
+        if (*state >= limit) {
+            p -= 2;
+            p[0] = (uint8_t)(*state >> 8);
+            p[1] = (uint8_t)*state;
+            *state >>= 16;
+        }
+        *state = ((*state / freq) << RANS_SCALE_BITS) + *state % freq + start;
+    }
+    for (int k = 1; k >= 0; k--) {
+        for (int i = 0; i < 4; i++) {
+            *--p = (uint8_t)states[k];
+            states[k] >>= 8;
+        }
+    }
+
+    for (; p < buffer + capacity; p++) writeBits(out, *p, 8);
+    free(buffer);
+    encoder->count = 0;
+    return 0;
+}
+
+
+/**
+ * Libère un codeur.
+ *
+ * @param encoder Pointeur vers le codeur.
+ */
+void freeRansEncoder(RansEncoder* encoder) {
+    free(encoder->symbols);
+    initRansEncoder(encoder);
+}
+
+
+/**
+ * Initialise un décodeur sur un tampon.
+ *
+ * @param decoder Pointeur vers le décodeur.
+ * @param data Tampon à lire.
+ * @param size Taille du tampon en octets.
+ */
+void initRansDecoder(RansDecoder* decoder, const uint8_t* data, size_t size) {
+    decoder->data = data;
+    decoder->size = size;
+    decoder->pos = 0;
+    for (int k = 0; k < 2; k++) {
+        decoder->state[k] = 0;
+        for (int i = 0; i < 4; i++) {
+            uint32_t byte = decoder->pos < size ? data[decoder->pos] : 0;
+            decoder->pos++;
+            decoder->state[k] = (decoder->state[k] << 8) | byte;
+        }
+    }
+}
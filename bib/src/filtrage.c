@@ -2,30 +2,66 @@
 
 
 /**
- * Calcule la variance moyenne et maximale des blocs dans un QuadTree.
+ * Calcule la somme et le maximum des variances des nœuds internes d'un QuadTree.
  * 
- * @param tree Pointeur vers un QuadTree.
- * @param medvar Pointeur où la variance moyenne sera stockée.
+ * Si l'image ne remplit pas le carré, seuls les nœuds qui la touchent sont comptés.
+ * 
+ * @param tree Pointeur vers un QuadTree complet (variances allouées).
+ * @param sumvar Pointeur où la somme des variances sera stockée.
  * @param maxvar Pointeur où la variance maximale sera stockée.
+ * @return Le nombre de nœuds internes comptés.
  */
-void avgAndMaxVars(QuadTree* tree, double* medvar, double* maxvar) {
-    int nodeIndex = 0;
+double sumAndMaxVars(const QuadTree* tree, double* sumvar, double* maxvar) {
     double sumvars = 0.0;
     double maxVar = 0.0;
-    int totalNode =0 ; 
+    double totalNode = levelStart(tree->depth); // nombre de noeuds internes
+    int vars = tree->moments != NULL;
 
-    for (int level = 0; level <= tree->depth; level++) {
-        int nodesAtLevel = (1 << (2 * level));
-
-        for (int i = 0; i < nodesAtLevel && nodeIndex < tree->totalNodes; i++, nodeIndex++) {
-            if (tree->nodes[nodeIndex].var > maxVar) maxVar = tree->nodes[nodeIndex].var;
-            sumvars += tree->nodes[nodeIndex].var;
-            if(!isLeaf(tree , nodeIndex)) totalNode +=1 ; 
+    if (!tree->border) {
+        // Parcours linéaire des nœuds internes (les feuilles et les blocs uniformes, dont les
+        // descendants ne sont pas calculés, ont une variance nulle)
+        for (int nodeIndex = 0; vars && nodeIndex < totalNode; nodeIndex++) {
+            if (isUniform(tree, nodeIndex)) continue;
+            double var = getNodeVar(tree, nodeIndex);
+            if (var > maxVar) maxVar = var;
+            sumvars += var;
+        }
+    } else {
+        // Parcours des blocs de chaque niveau, en s'arrêtant au bord de l'image
+        totalNode = 0;
+        for (int level = 0; vars && level < tree->depth; level++) {
+            int cols = coveringBlocks(tree->width, tree->depth - level);
+            int rows = coveringBlocks(tree->height, tree->depth - level);
+            totalNode += (double)cols * rows;
+            for (int by = 0; by < rows; by++) {
+                for (int bx = 0; bx < cols; bx++) {
+                    int nodeIndex = levelStart(level) + blockOffset(bx, by);
+                    if (isUniform(tree, nodeIndex)) continue;
+                    double var = getNodeVar(tree, nodeIndex);
+                    if (var > maxVar) maxVar = var;
+                    sumvars += var;
+                }
+            }
         }
     }
 
-    *medvar = sumvars/totalNode;
+    *sumvar = sumvars;
     *maxvar = maxVar;
+    return totalNode;
+}
+
+
+/**
+ * Calcule la variance moyenne et maximale des blocs dans un QuadTree.
+ * 
+ * @param tree Pointeur vers un QuadTree.
+ * @param medvar Pointeur où la variance moyenne sera stockée.
+ * @param maxvar Pointeur où la variance maximale sera stockée.
+ */
+void avgAndMaxVars(QuadTree* tree, double* medvar, double* maxvar) {
+    double sumvars;
+    double totalNode = sumAndMaxVars(tree, &sumvars, maxvar);
+    *medvar = sumvars/totalNode;
 }
 
 
@@ -39,13 +75,11 @@ void avgAndMaxVars(QuadTree* tree, double* medvar, double* maxvar) {
  * @return 1 si le filtrage a été appliqué avec succès, 0 sinon.
  */
 int filtrage (QuadTree * tree , int nodeIndex , double sigma , double alpha ) {  // must return 0 or 1 
-    QuadTreeNode * node = &tree->nodes[nodeIndex]; 
+    if (isLeaf(tree , nodeIndex)) return 1 ; // avant isUniform : les feuilles peuvent ne pas être stockées
 
-    if( node->uniform == 1) return 1 ; 
-    
-    if (isLeaf(tree , nodeIndex)) return 1 ; 
+    if (isUniform(tree, nodeIndex)) return 1 ; 
 
-    int childIndex = 4 * nodeIndex+1 ;
+    int childIndex = getChildIndex(tree, nodeIndex) ;
 
     int s = 0 ; 
     s += filtrage(tree , childIndex ,  sigma*alpha  , alpha); 
@@ -54,13 +88,125 @@ int filtrage (QuadTree * tree , int nodeIndex , double sigma , double alpha ) {
     s += filtrage(tree , childIndex + 3,  sigma*alpha  , alpha); 
     
     if ( s < 4) return 0 ; 
-    if( node->var > sigma) return 0 ;
+    if (getNodeVar(tree, nodeIndex) > sigma) return 0 ;
 
 
     
-    node->epsilon = 0 ; 
-    node-> uniform = 1 ; 
+    setNodeEpsilon(tree, nodeIndex, 0); 
+    setUniform(tree, nodeIndex, 1); 
 
   
     return 1 ; 
 }
+
+
+/**
+ * @brief Tâche de filtrage d'un groupe de sous-arbres consécutifs.
+ */
+typedef struct {
+    QuadTree* tree;
+    int level;          // niveau des racines
+    int first;          // index de la première racine
+    double sigma;       // seuil au niveau des racines
+    double alpha;
+    uint8_t* results;   // résultats de filtrage des racines
+} FiltrageTask;
+
+
+/**
+ * @brief Filtre les PARALLEL_GROUP sous-arbres d'une tâche.
+ * 
+ * @param arg Pointeur vers une FiltrageTask.
+ */
+static void filtrageTask(void* arg) {
+    FiltrageTask* task = (FiltrageTask*)arg;
+    for (int i = 0; i < PARALLEL_GROUP; i++) {
+        if (task->tree->border) {
+            // Les sous-arbres hors de l'image n'ont jamais été remplis
+            int bx, by;
+            blockPosition(task->first + i - levelStart(task->level), &bx, &by);
+            if (isBlockOutside(task->tree, task->level, bx, by)) {
+                task->results[i] = 1;
+                continue;
+            }
+        }
+        task->results[i] = filtrage(task->tree, task->first + i, task->sigma, task->alpha);
+    }
+}
+
+
+/**
+ * Filtrage des niveaux situés au-dessus du découpage, à partir des résultats des sous-arbres.
+ * 
+ * Même règle que filtrage, mais la récursion s'arrête au niveau de découpage.
+ * 
+ * @param tree Pointeur vers le QuadTree complet à filtrer.
+ * @param nodeIndex Index du nœud actuel.
+ * @param level Niveau du nœud actuel.
+ * @param split Niveau de découpage.
+ * @param sigma Seuil de variance au niveau du nœud actuel.
+ * @param alpha Facteur pour ajuster le filtrage.
+ * @param results Résultats du filtrage des nœuds du niveau de découpage (par position dans le niveau).
+ * @return Le résultat du filtrage du nœud.
+ */
+int filtrageTop(QuadTree* tree, int nodeIndex, int level, int split, double sigma, double alpha, const uint8_t* results) {
+    if (level == split) return results[nodeIndex - levelStart(split)];
+
+    if (isUniform(tree, nodeIndex)) return 1 ; 
+
+    int childIndex = 4 * nodeIndex+1 ;
+
+    int s = 0 ; 
+    for (int i = 0; i < 4; i++) {
+        s += filtrageTop(tree, childIndex + i, level + 1, split, sigma*alpha, alpha, results);
+    }
+
+    if ( s < 4) return 0 ; 
+    if (getNodeVar(tree, nodeIndex) > sigma) return 0 ;
+
+    setNodeEpsilon(tree, nodeIndex, 0); 
+    setUniform(tree, nodeIndex, 1); 
+
+    return 1 ; 
+}
+
+
+/**
+ * Applique le filtrage à tout un QuadTree, les sous-arbres étant filtrés en parallèle.
+ * 
+ * @param tree Pointeur vers le QuadTree à filtrer.
+ * @param sigma Seuil de variance à la racine.
+ * @param alpha Facteur pour ajuster le filtrage.
+ * @param pool Pool de threads (NULL pour un filtrage séquentiel).
+ * @return Le résultat du filtrage de la racine.
+ */
+int filtrageParallel(QuadTree* tree, double sigma, double alpha, ThreadPool* pool) {
+    int split = pool ? parallelSplitLevel(tree, threadPoolSize(pool)) : -1;
+    if (split < 0) return filtrage(tree, 0, sigma, alpha);
+
+    int nbRoots = 1 << (2 * split);
+    int nbTasks = nbRoots / PARALLEL_GROUP;
+    uint8_t* results = (uint8_t*)malloc(nbRoots);
+    FiltrageTask* tasks = (FiltrageTask*)malloc(nbTasks * sizeof(FiltrageTask));
+    if (!results || !tasks) {
+        free(results);
+        free(tasks);
+        return filtrage(tree, 0, sigma, alpha);
+    }
+
+    // Seuil au niveau de découpage, calculé dans le même ordre que la récursion
+    double splitSigma = sigma;
+    for (int level = 0; level < split; level++) splitSigma = splitSigma * alpha;
+
+    for (int t = 0; t < nbTasks; t++) {
+        FiltrageTask task = { tree, split, levelStart(split) + t * PARALLEL_GROUP, splitSigma, alpha, results + t * PARALLEL_GROUP };
+        tasks[t] = task;
+        if (submitTask(pool, filtrageTask, &tasks[t]) != 0) filtrageTask(&tasks[t]);
+    }
+    waitThreadPool(pool);
+
+    int result = filtrageTop(tree, 0, 0, split, sigma, alpha, results);
+    free(tasks);
+    free(results);
+    return result;
+}
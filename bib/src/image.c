@@ -1,91 +1,132 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "image.h"
 
 
 /**
- * Lit un fichier image au format PGM.
+ * Projette un fichier PGM et renvoie ses pixels, lus en place après l'en-tête.
  * 
  * @param filename Nom du fichier PGM à lire.
- * @param size Pointeur pour stocker la taille de l'image.
+ * @param file Pointeur vers le fichier projeté (à fermer par closeMappedFile).
+ * @param width Pointeur pour stocker la largeur de l'image.
+ * @param height Pointeur pour stocker la hauteur de l'image.
  * @param maxval Pointeur pour stocker le niveau de gris de la PGM
  * @param dataSizePGM Pointeur pour stocker la taille des données en octets.
- * @return Un tableau d'octets contenant les données de l'image.
+ * @return Les pixels de l'image dans la projection, ou NULL en cas d'erreur (fichier fermé).
  */
-uint8_t* readPGMFile(const char* filename, int* size, int* maxval, size_t* dataSizePGM) {
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
-        perror("Erreur lors de l'ouverture du fichier");
+uint8_t* mapPGMFile(const char* filename, MappedFile* file, int* width, int* height, int* maxval, size_t* dataSizePGM) {
+    if (openMappedFile(filename, file) != 0) {
         return NULL;
     }
+    const uint8_t* p = file->data;
+    const uint8_t* end = file->data + file->size;
 
     // Lire la première ligne P5
     char line[256];
-    if (fgets(line, sizeof(line), file) == NULL || line[0] != 'P' || line[1] != '5') {
+    if ((p = readLine(p, end, line, sizeof(line))) == NULL || line[0] != 'P' || line[1] != '5') {
         fprintf(stderr, "Erreur : Format PGM non valide\n");
-        fclose(file);
+        closeMappedFile(file);
         return NULL;
     }
 
     // ignorer  les commentaires
     do {
-        if (fgets(line, sizeof(line), file) == NULL) {
+        if ((p = readLine(p, end, line, sizeof(line))) == NULL) {
             fprintf(stderr, "Erreur : En-tête du fichier incorrect\n");
-            fclose(file);
+            closeMappedFile(file);
             return NULL;
         }
     } while (line[0] == '#');
 
     // Lire les dimensions et éventuellement le niveau de gris
-    int width = 0, height = 0;
-    if (sscanf(line, "%d %d %d", &width, &height, maxval) == 3) {
+    *width = *height = 0;
+    if (sscanf(line, "%d %d %d", width, height, maxval) == 3) {
         // Cas où width, height et maxval sont sur la même ligne
 
-    } else if (sscanf(line, "%d %d", &width, &height) == 2) {
+    } else if (sscanf(line, "%d %d", width, height) == 2) {
         // Cas où seulement width et height sont sur la ligne
         // Lire le niveau de gris sur la ligne suivante
-        if (fgets(line, sizeof(line), file) == NULL || sscanf(line, "%d", maxval) != 1) {
+        if ((p = readLine(p, end, line, sizeof(line))) == NULL || sscanf(line, "%d", maxval) != 1) {
             fprintf(stderr, "Erreur : Niveau de gris introuvable\n");
-            fclose(file);
+            closeMappedFile(file);
             return NULL;
         }
     } else {
         fprintf(stderr, "Erreur : Dimensions introuvables\n");
-        fclose(file);
+        closeMappedFile(file);
         return NULL;
     }
 
     // Vérification de la validité des dimensions et du niveau de gris
-    if (width != height) {
-        fprintf(stderr, "Erreur : L'image doit être carrée\n");
-        fclose(file);
+    if (*width <= 0 || *height <= 0) {
+        fprintf(stderr, "Erreur : Dimensions invalides (%dx%d)\n", *width, *height);
+        closeMappedFile(file);
         return NULL;
     }
-    *size = width;
 
     if (*maxval <= 0 || *maxval > 255) {
         fprintf(stderr, "Erreur : Niveau maximal invalide (%d)\n", *maxval);
-        fclose(file);
+        closeMappedFile(file);
         return NULL;
     }
 
-    // Lire les données brutes
-    *dataSizePGM = width * height;
-    uint8_t* data = (uint8_t*)malloc(*dataSizePGM);
-    if (!data) {
-        perror("Erreur lors de l'allocation mémoire");
-        fclose(file);
+    // Les données brutes suivent l'en-tête
+    *dataSizePGM = (size_t)*width * *height;
+    if ((size_t)(end - p) < *dataSizePGM) {
+        fprintf(stderr, "Erreur lors de la lecture des données brutes\n");
+        closeMappedFile(file);
         return NULL;
     }
 
-    if (fread(data, sizeof(uint8_t), *dataSizePGM, file) != *dataSizePGM) {
-        fprintf(stderr, "Erreur lors de la lecture des données brutes\n");
-        free(data);
-        fclose(file);
+    return (uint8_t*)p;
+}
+
+
+/**
+ * Crée un fichier PGM projeté, en-tête écrit, dont les pixels sont à remplir en place.
+ * 
+ * @param filename Nom du fichier PGM à écrire.
+ * @param file Pointeur vers le fichier projeté (à fermer par closeMappedFile).
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param maxval Valeur maximale des pixels.
+ * @return Les pixels de l'image dans la projection, ou NULL en cas d'erreur.
+ */
+uint8_t* createPGMFile(const char* filename, MappedFile* file, int width, int height, int maxval) {
+    char header[64];
+    int headerSize = snprintf(header, sizeof(header), "P5\n%d %d\n%d\n", width, height, maxval);
+
+    if (createMappedFile(filename, headerSize + (size_t)width * height, file) != 0) {
         return NULL;
     }
+    memcpy(file->data, header, headerSize);
+    return file->data + headerSize;
+}
 
-    fclose(file);
+
+/**
+ * Lit un fichier image au format PGM.
+ * 
+ * @param filename Nom du fichier PGM à lire.
+ * @param width Pointeur pour stocker la largeur de l'image.
+ * @param height Pointeur pour stocker la hauteur de l'image.
+ * @param maxval Pointeur pour stocker le niveau de gris de la PGM
+ * @param dataSizePGM Pointeur pour stocker la taille des données en octets.
+ * @return Un tableau d'octets contenant les données de l'image.
+ */
+uint8_t* readPGMFile(const char* filename, int* width, int* height, int* maxval, size_t* dataSizePGM) {
+    MappedFile file;
+    uint8_t* pixels = mapPGMFile(filename, &file, width, height, maxval, dataSizePGM);
+    if (!pixels) return NULL;
+
+    uint8_t* data = (uint8_t*)malloc(*dataSizePGM);
+    if (!data) {
+        perror("Erreur lors de l'allocation mémoire");
+    } else {
+        memcpy(data, pixels, *dataSizePGM);
+    }
+    closeMappedFile(&file);
     return data;
 }
 
@@ -105,25 +146,14 @@ int writePGMFile(const char* filename, const uint8_t* data, int width, int heigh
         return -1;
     }
 
-    FILE* file = fopen(filename, "wb");
-    if (!file) {
-        perror("Erreur lors de l'ouverture du fichier de sortie");
-        return -1;
-    }
+    MappedFile file;
+    uint8_t* pixels = createPGMFile(filename, &file, width, height, maxval);
+    if (!pixels) return -1;
 
-    // Écrire l'en-tête PGM
-    fprintf(file, "P5\n");
-    fprintf(file, "%d %d\n", width, height); // Largeur et hauteur
-    fprintf(file, "%d\n", maxval);           // Niveau de gris maximal
-
-    // Écrire les données d'image
-    size_t dataSize = width * height;
-    if (fwrite(data, sizeof(uint8_t), dataSize, file) != dataSize) {
+    memcpy(pixels, data, (size_t)width * height);
+    if (closeMappedFile(&file) != 0) {
         fprintf(stderr, "Erreur lors de l'écriture des données d'image dans %s\n", filename);
-        fclose(file);
         return -1;
     }
-
-    fclose(file);
     return 0;
 }
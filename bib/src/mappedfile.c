@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mappedfile.h"
+
+
+/**
+ * Taille initiale du tampon de lecture d'un flux.
+ */
+#define STREAM_CHUNK (1 << 16)
+
+
+/**
+ * Ouvre un fichier en lecture.
+ *
+ * Un fichier régulier non vide est projeté en lecture seule ; sinon (tube, fichier
+ * spécial) il est lu en entier par stdio.
+ *
+ * @param filename Nom du fichier.
+ * @param file Pointeur vers le fichier projeté à initialiser.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int openMappedFile(const char* filename, MappedFile* file) {
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Erreur lors de l'ouverture du fichier");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+            file->data = (uint8_t*)data;
+            file->size = (size_t)st.st_size;
+            file->mapped = 1;
+            return 0;
+        }
+    }
+
+    // Repli : lecture par stdio
+    FILE* stream = fdopen(fd, "rb");
+    if (!stream) {
+        perror("Erreur lors de l'ouverture du fichier");
+        close(fd);
+        return -1;
+    }
+    file->data = readStream(stream, &file->size);
+    fclose(stream);
+    return file->data ? 0 : -1;
+}
+
+
+/**
+ * Crée (ou tronque) un fichier de taille donnée, à remplir en écrivant dans `data`.
+ *
+ * L'espace disque est réservé avant la projection, pour qu'un disque plein soit
+ * signalé ici plutôt qu'à l'écriture des pages. Si le fichier ne peut pas être
+ * projeté, `data` est un tampon écrit par stdio à la fermeture.
+ *
+ * @param filename Nom du fichier.
+ * @param size Taille du fichier en octets.
+ * @param file Pointeur vers le fichier projeté à initialiser.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int createMappedFile(const char* filename, size_t size, MappedFile* file) {
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        perror("Erreur lors de l'ouverture du fichier de sortie");
+        return -1;
+    }
+
+    struct stat st;
+    if (size > 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && posix_fallocate(fd, 0, (off_t)size) == 0) {
+        void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            file->data = (uint8_t*)data;
+            file->size = size;
+            file->mapped = 1;
+            return 0;
+        }
+    }
+
+    // Repli : tampon écrit par stdio à la fermeture
+    file->output = fdopen(fd, "wb");
+    file->data = (uint8_t*)malloc(size ? size : 1);
+    if (!file->output || !file->data) {
+        perror("Erreur lors de la préparation du fichier de sortie");
+        if (file->output) fclose(file->output);
+        else close(fd);
+        free(file->data);
+        memset(file, 0, sizeof(*file));
+        return -1;
+    }
+    file->size = size;
+    return 0;
+}
+
+
+/**
+ * Ferme un fichier projeté (écrit le tampon s'il a été créé par stdio).
+ *
+ * @param file Pointeur vers le fichier projeté.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int closeMappedFile(MappedFile* file) {
+    int status = 0;
+
+    if (file->mapped) {
+        if (munmap(file->data, file->size) != 0) {
+            perror("Erreur lors de la fermeture du fichier projeté");
+            status = -1;
+        }
+    } else {
+        if (file->output) {
+            if (fwrite(file->data, 1, file->size, file->output) != file->size) {
+                fprintf(stderr, "Erreur lors de l'écriture du fichier de sortie\n");
+                status = -1;
+            }
+            if (fclose(file->output) != 0) status = -1;
+        }
+        free(file->data);
+    }
+
+    memset(file, 0, sizeof(*file));
+    return status;
+}
+
+
+/**
+ * Annonce la lecture prochaine d'une plage d'un fichier projeté (lecture anticipée).
+ * 
+ * @param file Pointeur vers le fichier projeté.
+ * @param offset Début de la plage (en octets depuis le début du fichier).
+ * @param length Longueur de la plage en octets.
+ */
+void prefetchMappedRange(const MappedFile* file, size_t offset, size_t length) {
+    if (!file->mapped || offset >= file->size) return;
+    if (length > file->size - offset) length = file->size - offset;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset / page * page;
+    madvise(file->data + start, offset + length - start, MADV_WILLNEED);
+}
+
+
+/**
+ * Annonce la lecture prochaine d'un fichier entier (lecture anticipée par le noyau).
+ * 
+ * Les pages lues restent dans le cache du système : la projection faite ensuite par
+ * openMappedFile les trouve sans attendre le disque.
+ * 
+ * @param filename Nom du fichier.
+ */
+void prefetchFile(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return; // l'erreur sera signalée à l'ouverture du fichier
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+
+/**
+ * Libère les pages d'une plage d'un fichier projeté en lecture qui ne sert plus.
+ * 
+ * Seules les pages entièrement comprises dans la plage sont libérées : elles seraient
+ * relues depuis le fichier en cas de nouvel accès.
+ * 
+ * @param file Pointeur vers le fichier projeté.
+ * @param offset Début de la plage (en octets depuis le début du fichier).
+ * @param length Longueur de la plage en octets.
+ */
+void releaseMappedRange(const MappedFile* file, size_t offset, size_t length) {
+    if (!file->mapped || offset >= file->size) return;
+    if (length > file->size - offset) length = file->size - offset;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = (offset + page - 1) / page * page;
+    size_t end = (offset + length) / page * page;
+    if (end > start) madvise(file->data + start, end - start, MADV_DONTNEED);
+}
+
+
+/**
+ * Lit un flux en entier dans un tampon alloué (sans connaître sa taille à l'avance).
+ *
+ * @param stream Flux ouvert en lecture.
+ * @param size Pointeur où stocker la taille lue.
+ * @return Le tampon (à libérer par free), ou NULL en cas d'erreur.
+ */
+uint8_t* readStream(FILE* stream, size_t* size) {
+    size_t capacity = STREAM_CHUNK;
+    size_t length = 0;
+    uint8_t* data = (uint8_t*)malloc(capacity);
+
+    while (data) {
+        length += fread(data + length, 1, capacity - length, stream);
+        if (length < capacity) break; // fin du flux ou erreur
+
+        uint8_t* bigger = (uint8_t*)realloc(data, 2 * capacity);
+        if (!bigger) {
+            free(data);
+            data = NULL;
+            break;
+        }
+        data = bigger;
+        capacity *= 2;
+    }
+
+    if (!data) {
+        perror("Erreur : Allocation mémoire échouée");
+        return NULL;
+    }
+    if (ferror(stream)) {
+        fprintf(stderr, "Erreur lors de la lecture du flux\n");
+        free(data);
+        return NULL;
+    }
+
+    *size = length;
+    return data;
+}
+
+
+/**
+ * Copie une ligne de texte d'un tampon, comme fgets.
+ *
+ * @param p Position courante dans le tampon.
+ * @param end Fin du tampon.
+ * @param line Tableau recevant la ligne (terminée par '\0').
+ * @param capacity Taille de `line`.
+ * @return La position qui suit la ligne, ou NULL si le tampon est épuisé.
+ */
+const uint8_t* readLine(const uint8_t* p, const uint8_t* end, char* line, size_t capacity) {
+    if (p >= end) return NULL;
+
+    size_t n = 0;
+    while (p < end && n + 1 < capacity) {
+        char c = (char)*p++;
+        line[n++] = c;
+        if (c == '\n') break;
+    }
+    line[n] = '\0';
+    return p;
+}
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "metrics.h"
+
+
+/**
+ * Noms des étapes dans les lignes JSON (dans l'ordre de MetricsStage).
+ */
+static const char* const stageNames[STAGE_COUNT] = {
+    "read", "fill", "filter", "encode", "write", "decode", "reconstruct"
+};
+
+
+/**
+ * Renvoie le temps écoulé sur l'horloge monotone, en secondes.
+ *
+ * @return Le temps en secondes (origine arbitraire).
+ */
+double metricsClock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ * @brief Ajoute du texte formaté à un tampon, comme snprintf, sans jamais le dépasser.
+ *
+ * @return La nouvelle longueur du texte (tronqué si le tampon est plein).
+ */
+static size_t appendText(char* buffer, size_t capacity, size_t length, const char* format, ...) {
+    if (length + 1 >= capacity) return length;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + length, capacity - length, format, args);
+    va_end(args);
+    if (n < 0) return length;
+    return length + n < capacity ? length + n : capacity - 1;
+}
+
+
+/**
+ * @brief Ajoute une chaîne JSON (entre guillemets, caractères spéciaux échappés) à un tampon.
+ *
+ * @return La nouvelle longueur du texte (tronqué si le tampon est plein).
+ */
+static size_t appendString(char* buffer, size_t capacity, size_t length, const char* text) {
+    length = appendText(buffer, capacity, length, "\"");
+    for (const unsigned char* p = (const unsigned char*)text; *p && length + 8 < capacity; p++) {
+        if (*p == '"' || *p == '\\') length = appendText(buffer, capacity, length, "\\%c", *p);
+        else if (*p < 0x20) length = appendText(buffer, capacity, length, "\\u%04x", *p);
+        else buffer[length++] = (char)*p;
+    }
+    return appendText(buffer, capacity, length, "\"");
+}
+
+
+/**
+ * Écrit les mesures d'un fichier sur une ligne JSON, en une seule écriture.
+ *
+ * @param output Flux de sortie.
+ * @param metrics Mesures du fichier.
+ * @param operation "encode" ou "decode".
+ * @param inputFile Nom du fichier d'entrée.
+ * @param outputFile Nom du fichier de sortie.
+ * @param status 0 si le traitement a réussi, -1 sinon.
+ */
+void writeMetrics(FILE* output, const Metrics* metrics, const char* operation, const char* inputFile,
+                  const char* outputFile, int status) {
+    char line[4096];
+    size_t capacity = sizeof(line) - 2; // place pour "}\n"
+    size_t length = appendText(line, capacity, 0, "{\"op\":\"%s\",\"status\":\"%s\",\"input\":", operation,
+                               status == 0 ? "ok" : "error");
+    length = appendString(line, capacity, length, inputFile);
+    length = appendText(line, capacity, length, ",\"output\":");
+    length = appendString(line, capacity, length, outputFile);
+
+    length = appendText(line, capacity, length, ",\"format\":%d,\"width\":%d,\"height\":%d,\"bytes_in\":%llu,\"bytes_out\":%llu",
+                        metrics->format, metrics->width, metrics->height,
+                        (unsigned long long)metrics->inputBytes, (unsigned long long)metrics->outputBytes);
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        length = appendText(line, capacity, length, ",\"%s_ms\":%.3f", stageNames[s], metrics->seconds[s] * 1e3);
+    }
+    length = appendText(line, capacity, length,
+                        ",\"nodes_visited\":%llu,\"nodes_coded\":%llu,\"bits_m\":%llu,\"bits_epsilon\":%llu,"
+                        "\"bits_uniform\":%llu,\"bytes_allocated\":%llu",
+                        (unsigned long long)metrics->nodesVisited, (unsigned long long)metrics->nodesCoded,
+                        (unsigned long long)metrics->mBits, (unsigned long long)metrics->epsilonBits,
+                        (unsigned long long)metrics->uniformBits, (unsigned long long)metrics->bytesAllocated);
+    memcpy(line + length, "}\n", 2);
+    fwrite(line, 1, length + 2, output);
+    fflush(output);
+}
@@ -10,6 +10,48 @@
 #include "filtrage.h"
 #include "image.h"
 #include "Quadtree.h"
+#include "threadpool.h"
+#include "tiled.h"
+#include "metrics.h"
+#include "region.h"
+#include "qtc.h"
+
+
+/**
+ * Initialise les options avec les valeurs par défaut (sans perte, séquentiel, format Q1).
+ * 
+ * @param options Pointeur vers les options à initialiser.
+ */
+void initQTCOptions(QTCOptions* options) {
+    options->alpha = -1; // Alpha par défaut désactivé
+    options->generateGrid = 0;
+    options->generateSegments = 0;
+    options->bavard = 0;
+    options->nbThreads = 1;
+    options->splitLevel = -1;
+    options->tileSize = 0;
+    options->entropy = 0;
+    options->level = -1;
+    options->metrics = NULL;
+    options->targetSize = 0;
+    options->targetBpp = 0;
+}
+
+
+/**
+ * @brief Crée le pool de threads demandé par les options.
+ * 
+ * @param options Options (nombre de threads, mode bavard).
+ * @return Le pool, ou NULL pour un traitement séquentiel.
+ */
+static ThreadPool* createOptionsPool(const QTCOptions* options) {
+    if (options->nbThreads <= 1) return NULL;
+
+    ThreadPool* pool = createThreadPool(options->nbThreads);
+    if (!pool) fprintf(stderr, "Attention : Pool de threads indisponible, traitement séquentiel\n");
+    else if (options->bavard) printf("Traitement parallèle sur %d threads\n", options->nbThreads);
+    return pool;
+}
 
 
 /**
@@ -18,19 +60,76 @@
  * @param executable Nom du programme (argv[0]) (codec)
  */
 void printUsage(const char* executable) {
-    printf("Usage: %s [-c|-u] -i <input_file> [-o <output_file>] [-a <alpha>] [-g] [-h] [-v]\n", executable);
+    printf("Usage: %s [-c|-u] (-i <input_file> | -B <source>) [-o <output_file>] [-a <alpha> | -s <octets> | -b <bpp>] [-j <threads>] [-p <niveau>] [-t <taille>] [-e] [-l <niveau>] [-m <file>] [-g] [-G] [-h] [-v]\n", executable);
     printf("Options:\n");
     printf("  -c            Encodeur\n");
     printf("  -u            Decodeur\n");
     printf("  -i <file>     Fichier d'entrée (PGM ou QTC)\n");
-    printf("  -o <file>     Fichier de sortie (QTC ou PGM)\n");
-    printf("  -a <alpha>    Valeur alpha pour l'encodage avec perte (par defaut: 1.5)\n");
+    printf("  -o <file>     Fichier de sortie (QTC ou PGM), ou repertoire des sorties avec -B\n");
+    printf("  -B <source>   Traitement par lot : repertoire, ou liste de fichiers (un par ligne)\n");
+    printf("  -a <alpha>    Valeur alpha pour l'encodage avec perte (1.5 a 3 en general, plus grand : plus compact) ;\n");
+    printf("                un bloc est fusionne si l'ecart type de ses pixels reste sous sigma*alpha^niveau\n");
+    printf("  -s <octets>   Encodage avec perte a taille visee : alpha choisi pour que le fichier tienne en <octets>\n");
+    printf("  -b <bpp>      Encodage avec perte a debit vise, en bits par pixel (comme -s)\n");
+    printf("  -j <threads>  Nombre de threads pour l'encodage et le decodage (par defaut: 1) ;\n");
+    printf("                avec -B, nombre de fichiers traites en meme temps\n");
+    printf("  -p <niveau>   Encodage au format Q2, index des sous-arbres du niveau donne (2 ou plus)\n");
+    printf("  -t <taille>   Encodage tuile au format Q3, par tuiles de la taille donnee (puissance de 2)\n");
+    printf("  -e            Encodage au format Q4, flux unique a codage entropique (plus compact)\n");
+    printf("  -l <niveau>   Decodage en apercu : image des moyennes des blocs du niveau donne (2^niveau de cote au plus)\n");
+    printf("  -m <file>     Mesures (temps par etape, compteurs) en une ligne JSON par fichier, '-' : sortie standard\n");
     printf("  -g            Editer la grille de segmentation\n");
+    printf("  -G            Editer la liste des blocs de la segmentation (texte : x y largeur hauteur moyenne)\n");
     printf("  -h            Affiche cette aide\n");
     printf("  -v            Mode bavard\n");
 }
 
 
+/**
+ * @brief Crée le fichier PGM de la grille de segmentation, initialisée en blanc.
+ * 
+ * @param outputFile Nom de base pour le fichier de sortie. Le fichier de grille aura "_g.pgm" ajouté à ce nom.
+ * @param gridFile Pointeur vers le fichier projeté de la grille (à fermer par closeGridFile).
+ * @param width Largeur de la grille.
+ * @param height Hauteur de la grille.
+ * @param gridOutput Tableau recevant le nom du fichier de la grille.
+ * @param capacity Taille de `gridOutput`.
+ * @return Les pixels de la grille dans la projection, ou NULL en cas d'erreur.
+ */
+static uint8_t* createGridFile(const char* outputFile, MappedFile* gridFile, int width, int height, char* gridOutput, size_t capacity) {
+    printf("\n\nGénération de la grille de segmentation pour %s\n", outputFile);
+
+    snprintf(gridOutput, capacity, "%s_g.pgm", outputFile);
+
+    // La grille est tracée directement dans le fichier de sortie projeté
+    uint8_t* grid = createPGMFile(gridOutput, gridFile, width, height, 255);
+    if (!grid) {
+        fprintf(stderr, "Erreur : Impossible de créer le fichier de la grille\n");
+        return NULL;
+    }
+
+    memset(grid, 255, (size_t)width * height); // Initialiser la grille en blanc
+    return grid;
+}
+
+
+/**
+ * @brief Ferme le fichier de la grille de segmentation une fois tracée.
+ * 
+ * @param gridFile Pointeur vers le fichier projeté de la grille.
+ * @param gridOutput Nom du fichier de la grille.
+ * @param bavard Mode bavard (si différent de 0, affiche des messages détaillés).
+ */
+static void closeGridFile(MappedFile* gridFile, const char* gridOutput, int bavard) {
+    if (closeMappedFile(gridFile) != 0) {
+        fprintf(stderr, "Erreur : Écriture de la grille échouée\n");
+        return;
+    }
+    if (bavard) printf("Grille de segmentation écrite dans %s\n", gridOutput);
+     printf("Grille de segmentation générée avec succès\n");
+}
+
+
 /**
  * @brief Génère une grille de segmentation à partir d'un QuadTree et l'écrit dans un fichier PGM.
  * 
@@ -40,199 +139,856 @@ void printUsage(const char* executable) {
  * 
  * @param tree Pointeur vers le QuadTree utilisé pour générer la grille.
  * @param outputFile Nom de base pour le fichier de sortie. Le fichier de grille aura "_g.pgm" ajouté à ce nom.
- * @param width Largeur de la grille (et hauteur, car la grille est carrée).
+ * @param width Largeur de la grille.
+ * @param height Hauteur de la grille.
  * @param bavard Mode bavard (si différent de 0, affiche des messages détaillés).
  */
-static void handleGrid(QuadTree* tree, const char* outputFile, int width, int bavard) {
-    printf("\n\nGénération de la grille de segmentation pour %s\n", outputFile);
+static void handleGrid(QuadTree* tree, const char* outputFile, int width, int height, int bavard) {
+    char gridOutput[256];
+    MappedFile gridFile;
+    uint8_t* grid = createGridFile(outputFile, &gridFile, width, height, gridOutput, sizeof(gridOutput));
+    if (!grid) return;
+
+    generateSegmentationGrid(tree, grid, width, height, 0, 0, 0, 1 << tree->depth);
+    closeGridFile(&gridFile, gridOutput, bavard);
+}
+
+
+/**
+ * @brief Écrit la liste des blocs de la segmentation d'un fichier QTC (voir writeQTCSegments).
+ * 
+ * @param qtcFile Fichier QTC (la sortie de l'encodage, ou l'entrée du décodage).
+ * @param outputFile Nom de base pour le fichier de sortie. Le fichier de la liste aura "_g.txt" ajouté à ce nom.
+ * @param bavard Mode bavard (si différent de 0, affiche des messages détaillés).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int handleSegments(const char* qtcFile, const char* outputFile, int bavard) {
+    char segmentsOutput[256];
+    snprintf(segmentsOutput, sizeof(segmentsOutput), "%s_g.txt", outputFile);
+
+    QTCImage* image = openQTCImage(qtcFile);
+    if (!image) return -1;
+    FILE* output = fopen(segmentsOutput, "w");
+    if (!output) {
+        perror("Erreur : Impossible de créer la liste des blocs");
+        closeQTCImage(image);
+        return -1;
+    }
+    int status = writeQTCSegments(image, output);
+    if (fclose(output) != 0 && status == 0) {
+        perror("Erreur : Écriture de la liste des blocs échouée");
+        status = -1;
+    }
+    closeQTCImage(image);
+    if (status == 0 && bavard) printf("Liste des blocs de la segmentation écrite dans %s\n", segmentsOutput);
+    return status;
+}
+
+
+/**
+ * @brief Prépare l'en-tête texte d'un fichier QTC (voir writeQTCHeader).
+ * 
+ * Sa longueur ne dépend que du format et des dimensions de l'image.
+ * 
+ * @param header Tampon recevant l'en-tête (256 octets).
+ * @param format Version du format (1 à 4).
+ * @param t Date de l'encodage.
+ * @param rate Taux de compression en pourcents.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur de l'image.
+ * @return La longueur de l'en-tête en octets.
+ */
+static size_t formatQTCHeader(char header[256], int format, time_t t, double rate, int width, int height, int depth) {
+    char date[32];
+    int length = snprintf(header, 256, "Q%d", format);
+    if (width != 1 << depth || height != 1 << depth) {
+        length += snprintf(header + length, 256 - length, " %d %d", width, height);
+    }
+    if (rate > 999.99) rate = 999.99;
+    snprintf(header + length, 256 - length, "\n# %s# compression rate %6.2f%%\n", ctime_r(&t, date), rate);
+    return strlen(header);
+}
+
+
+/**
+ * @brief Écrit l'en-tête texte d'un fichier QTC.
+ * 
+ * Le taux de compression n'est connu qu'après l'encodage : l'en-tête est écrit une
+ * première fois avec un taux nul, puis réécrit à la même place (même longueur) : le
+ * taux est donc borné à 999.99% (atteint par les très petites images, où l'index
+ * pèse plus que les pixels). Les dimensions de l'image suivent le format quand elle
+ * ne remplit pas le carré de côté 2^depth.
+ * 
+ * @param output Fichier de sortie.
+ * @param format Version du format (1 à 4).
+ * @param t Date de l'encodage.
+ * @param rate Taux de compression en pourcents.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur de l'image.
+ */
+static void writeQTCHeader(FILE* output, int format, time_t t, double rate, int width, int height, int depth) {
+    char header[256];
+    size_t length = formatQTCHeader(header, format, t, rate, width, height, depth);
+    fwrite(header, sizeof(char), length, output);
+}
+
+
+/**
+ * @brief Encode une image au format Q3, tuile par tuile (voir encoderQuadTreeTiled).
+ * 
+ * @param input Fichier projeté contenant l'image (fermé par cette fonction).
+ * @param pixels Pixels de l'image dans la projection.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param dataSizePGM Taille des pixels en octets.
+ * @param outputFile Nom du fichier de sortie.
+ * @param options Options d'encodage.
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ * @param metrics Mesures à remplir (NULL : désactivées).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int encodeTiledFile(MappedFile* input, const uint8_t* pixels, int width, int height, size_t dataSizePGM,
+                           const char* outputFile, const QTCOptions* options, ThreadPool* pool, Metrics* metrics) {
+    int bavard = options->bavard;
+    int depth = calculateDepth(width > height ? width : height);
+    int tileDepth = calculateDepth(options->tileSize);
+    if (options->tileSize < 2 || (1 << tileDepth) != options->tileSize) {
+        closeMappedFile(input);
+        fprintf(stderr, "Erreur : La taille des tuiles doit être une puissance de 2 (au moins 2)\n");
+        return -1;
+    }
+    // Une seule tuile au plus grand ; une image de moins de 2x2 pixels tient dans une tuile de 2
+    if (depth < 1) depth = 1;
+    if (tileDepth > depth) tileDepth = depth;
+
+    FILE* output = fopen(outputFile, "wb+");
+    if (!output) {
+        perror("Erreur : Impossible de créer le fichier de sortie");
+        closeMappedFile(input);
+        return -1;
+    }
+    time_t t = time(NULL);
+    writeQTCHeader(output, 3, t, 0.0, width, height, depth);
+    uint8_t taille = (uint8_t)depth;
+    fwrite(&taille, sizeof(uint8_t), 1, output);
 
     char gridOutput[256];
-    snprintf(gridOutput, sizeof(gridOutput), "%s_g.pgm", outputFile);
+    MappedFile gridFile;
+    uint8_t* grid = options->generateGrid ? createGridFile(outputFile, &gridFile, width, height, gridOutput, sizeof(gridOutput)) : NULL;
+
+    if (bavard) printf("Encodage tuilé : tuiles de %dx%d, profondeur %d\n", 1 << tileDepth, 1 << tileDepth, depth);
+
+    // Construction, filtrage et codage sont entrelacés, tuile par tuile : une seule étape
+    double start = startStage(metrics);
+    TiledStats stats;
+    int status = encoderQuadTreeTiled(output, input, pixels, width, height, depth, tileDepth, options->alpha, grid, pool, &stats);
+    closeMappedFile(input);
+    endStage(metrics, STAGE_ENCODE, start);
+    if (metrics) {
+        metrics->format = 3;
+        metrics->nodesCoded = stats.codedNodes;
+        metrics->outputBytes = ftell(output);
+    }
+    if (status != 0) {
+        fclose(output);
+        if (grid) closeMappedFile(&gridFile);
+        return -1;
+    }
 
-    uint8_t* grid = calloc(width * width, sizeof(uint8_t));
-    if (!grid) {
-        perror("Erreur : Allocation mémoire pour la grille");
-        return;
+    double TO = (double)stats.bytes * 8 * 100 / (dataSizePGM * 8);
+
+    // Réécrire le taux de compression dans l'en-tête
+    start = startStage(metrics);
+    fseek(output, 0, SEEK_SET);
+    writeQTCHeader(output, 3, t, TO, width, height, depth);
+    status = fclose(output);
+    endStage(metrics, STAGE_WRITE, start);
+    if (status != 0) {
+        perror("Erreur : Écriture du fichier de sortie échouée");
+        if (grid) closeMappedFile(&gridFile);
+        return -1;
     }
 
-    memset(grid, 255, width * width); // Initialiser la grille en blanc
-    generateSegmentationGrid(tree, grid, width, width, 0, 0, 0, width);
+    if (bavard) {
+        printf("Tuiles codées : %llu sur %llu, %llu nœuds codés\n", (unsigned long long)stats.codedTiles,
+               (unsigned long long)stats.tiles, (unsigned long long)stats.codedNodes);
+        printf("Index Q3 : %llu octets (%.2f%% du flux)\n", (unsigned long long)stats.indexBytes,
+               stats.indexBytes * 100.0 / stats.bytes);
+        printf("Image encodée avec un taux de compression de %.2f%%\n", TO);
+    }
 
-    FILE* gridFile = fopen(gridOutput, "wb");
-    if (gridFile) {
-        fprintf(gridFile, "P5\n%d %d\n255\n", width, width);
-        fwrite(grid, sizeof(uint8_t), width * width, gridFile);
-        fclose(gridFile);
-        if (bavard) printf("Grille de segmentation écrite dans %s\n", gridOutput);
-    } else {
-        perror("Erreur : Impossible de créer le fichier de la grille");
+    if (grid) closeGridFile(&gridFile, gridOutput, bavard);
+    return 0;
+}
+
+
+/**
+ * @brief Nombre maximal d'essais de chaque phase de la recherche d'alpha (encadrement, dichotomie).
+ */
+#define ALPHA_SEARCH_STEPS 40
+
+/**
+ * @brief Précision de la recherche d'alpha : elle s'arrête dès que le flux dépasse
+ * (1 - 1/ALPHA_SEARCH_TOLERANCE) fois la taille visée.
+ */
+#define ALPHA_SEARCH_TOLERANCE 200
+
+
+/**
+ * @brief Filtre un QuadTree rempli avec une valeur d'alpha et compte les bits du flux obtenu.
+ * 
+ * L'arbre repart des epsilons et de l'uniformité sauvegardés avant tout filtrage (le
+ * filtrage ne modifie que ces champs, et seulement aux nœuds internes).
+ * 
+ * @param tree QuadTree complet rempli (variances allouées).
+ * @param saved Epsilons des nœuds internes, suivis de leurs octets d'uniformité.
+ * @param sigma Seuil de variance à la racine.
+ * @param alpha Facteur de filtrage.
+ * @param pool Pool de threads (NULL pour un filtrage séquentiel).
+ * @return Le nombre de bits du flux Q1.
+ */
+static uint64_t filteredBits(QuadTree* tree, const uint8_t* saved, double sigma, double alpha, ThreadPool* pool) {
+    int internal = levelStart(tree->depth);
+    memcpy(tree->epsilon, saved, internal);
+    memcpy(tree->uniform, saved + internal, (size_t)(internal + UNIFORM_BIT_OFFSET) / 8 + 1);
+    filtrageParallel(tree, sigma, alpha, pool);
+    return countQuadTreeBits(tree);
+}
+
+
+/**
+ * @brief Filtre un QuadTree rempli avec le plus petit alpha dont le flux tient dans un budget.
+ * 
+ * Le flux diminue quand alpha augmente (les seuils sigma * alpha^niveau augmentent) :
+ * alpha est encadré en doublant, puis l'intervalle est coupé en deux jusqu'à ce que le
+ * flux approche le budget. L'arbre est rempli une seule fois ; chaque essai le filtre de
+ * nouveau et compte ses bits sans rien écrire (voir countQuadTreeBits).
+ * 
+ * Au-delà de 2 * maxvar / sigma, tous les nœuds sous la racine passent le filtrage : si
+ * le flux obtenu avec cet alpha dépasse encore le budget, la recherche s'arrête là.
+ * 
+ * @param tree QuadTree complet rempli (variances allouées).
+ * @param sigma Seuil de variance à la racine.
+ * @param maxvar Variance maximale des nœuds internes.
+ * @param budget Nombre maximal de bits du flux.
+ * @param pool Pool de threads (NULL pour un filtrage séquentiel).
+ * @param bits Pointeur où stocker le nombre de bits du flux obtenu (au-delà du budget s'il est inatteignable).
+ * @return L'alpha appliqué (0 si le flux sans perte tient dans le budget), ou -1 en cas d'erreur.
+ */
+static double filtrageToBudget(QuadTree* tree, double sigma, double maxvar, uint64_t budget, ThreadPool* pool, uint64_t* bits) {
+    *bits = countQuadTreeBits(tree);
+    if (*bits <= budget) return 0;
+
+    int internal = levelStart(tree->depth);
+    size_t uniformSize = (size_t)(internal + UNIFORM_BIT_OFFSET) / 8 + 1;
+    uint8_t* saved = (uint8_t*)malloc(internal + uniformSize);
+    if (!saved) {
+        perror("Erreur lors de l'allocation de la copie de l'arbre");
+        return -1;
+    }
+    memcpy(saved, tree->epsilon, internal);
+    memcpy(saved + internal, tree->uniform, uniformSize);
+
+    // Filtrage le plus fort : si le flux dépasse encore le budget, il est gardé tel quel
+    double strongest = 2 * maxvar / sigma;
+    if (!(strongest > 1)) strongest = 1; // image sans variance : sigma n'est pas défini
+    *bits = filteredBits(tree, saved, sigma, strongest, pool);
+    if (*bits > budget) {
+        free(saved);
+        return strongest;
     }
 
-    free(grid);
-     printf("Grille de segmentation générée avec succès\n");
+    // Encadrement : le flux dépasse le budget avec low, tient avec high
+    double low = 0, high = 1;
+    uint64_t highBits = filteredBits(tree, saved, sigma, high, pool);
+    for (int step = 0; step < ALPHA_SEARCH_STEPS && highBits > budget; step++) {
+        low = high;
+        high *= 2;
+        highBits = filteredBits(tree, saved, sigma, high, pool);
+    }
+
+    // Dichotomie, jusqu'à approcher le budget par en dessous
+    double applied = high;
+    uint64_t close = budget - budget / ALPHA_SEARCH_TOLERANCE;
+    for (int step = 0; step < ALPHA_SEARCH_STEPS && highBits <= budget && highBits < close; step++) {
+        double mid = (low + high) / 2;
+        if (mid <= low || mid >= high) break;
+        uint64_t midBits = filteredBits(tree, saved, sigma, mid, pool);
+        applied = mid;
+        if (midBits <= budget) {
+            high = mid;
+            highBits = midBits;
+        } else {
+            low = mid;
+        }
+    }
+    if (applied != high) filteredBits(tree, saved, sigma, high, pool);
+
+    free(saved);
+    *bits = highBits;
+    return high;
 }
 
 
 /**
- * Gère le processus d'encodage d'un fichier QTC
+ * @brief Encode un fichier PGM au format QTC (voir encodeQTCFile), en remplissant les mesures.
  * 
- * @param inputFile Nom du fichier à encoder.
- * @param outputFile Nom du fichier de sortie où écrire les données encodées.
- * @param alpha facteur utilisé dans le cas d'un codage avec avec perte 
- * @param generateGrid utilisé pour savoir si l'option -g de génération de la grille de segemntation est activée.s
- * @param bavard Si différent de 0, affiche des informations détaillées pendant l'exécution.
+ * @param inputFile Nom du fichier PGM à encoder.
+ * @param outputFile Nom du fichier QTC à écrire.
+ * @param options Options d'encodage.
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ * @param metrics Mesures à remplir (NULL : désactivées).
+ * @return 0 en cas de succès, -1 en cas d'erreur (message déjà affiché).
  */
-void handleEncoding(const char* inputFile, const char* outputFile, double alpha, int generateGrid, int bavard) {
-    printf("\n\nEncodage en cours : fichier %s\n\n", inputFile);
-    int size, maxval;
+static int encodeFile(const char* inputFile, const char* outputFile, const QTCOptions* options, ThreadPool* pool,
+                      Metrics* metrics) {
+    double alpha = options->alpha;
+    int bavard = options->bavard;
+    int width, height, maxval;
     size_t dataSizePGM;
-    uint8_t* data = readPGMFile(inputFile, &size, &maxval, &dataSizePGM);
+    MappedFile input;
+    double start = startStage(metrics);
+    uint8_t* data = mapPGMFile(inputFile, &input, &width, &height, &maxval, &dataSizePGM);
     if (!data) {
-        fprintf(stderr, "Erreur : Impossible de lire le fichier PGM\n");
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Erreur : Impossible de lire le fichier PGM %s\n", inputFile);
+        return -1;
+    }
+    endStage(metrics, STAGE_READ, start);
+    if (metrics) {
+        metrics->width = width;
+        metrics->height = height;
+        metrics->inputBytes = input.size;
+    }
+    if (bavard) printf("Lecture réussie du fichier PGM : taille %dx%d, maxval %d\n", width, height, maxval);
+    if (options->tileSize > 0) { // image traitée par bandes de tuiles, sans arbre complet
+        return encodeTiledFile(&input, data, width, height, dataSizePGM, outputFile, options, pool, metrics);
+    }
+    double target = options->targetSize > 0 ? (double)options->targetSize : options->targetBpp * width * height / 8;
+    start = startStage(metrics);
+    int depth = calculateDepth(width > height ? width : height);
+
+    // Niveau de découpage Q2 vérifié avant la construction de l'arbre et l'ouverture de la sortie
+    if (options->splitLevel >= 0 && depth < 2) {
+        closeMappedFile(&input);
+        fprintf(stderr, "Erreur : Image trop petite pour le format Q2 (profondeur %d, niveau de découpage 2 au moins)\n", depth);
+        return -1;
+    }
+    if (options->splitLevel >= 0 && (options->splitLevel < 2 || options->splitLevel > depth)) {
+        closeMappedFile(&input);
+        fprintf(stderr, "Erreur : Niveau de découpage %d invalide (entre 2 et %d)\n", options->splitLevel, depth);
+        return -1;
+    }
+
+    QuadTree* tree = createQuadTreeOverImage(depth, data, width); // feuilles lues dans l'image
+    if (tree && setImageSize(tree, width, height) != 0) {
+        freeQuadTree(tree);
+        tree = NULL;
     }
-    if (bavard) printf("Lecture réussie du fichier PGM : taille %dx%d, maxval %d\n", size, size, maxval);
-    int depth = calculateDepth(size);
-    QuadTree* tree = createQuadTree(depth);
     if (!tree) {
-        free(data);
+        closeMappedFile(&input);
         fprintf(stderr, "Erreur : Impossible de créer le QuadTree\n");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     if (bavard) printf("QuadTree initialisé avec profondeur %d\n", depth);
 
-    fillQuadTree(tree, data, size, size, depth, 0, 0, 0, size);
+    // Les variances ne servent qu'au filtrage (codage avec perte)
+    if ((alpha > 0 || target > 0) && allocVariance(tree, 0) != 0) {
+        freeQuadTree(tree);
+        closeMappedFile(&input);
+        fprintf(stderr, "Erreur : Impossible d'allouer les variances du QuadTree\n");
+        return -1;
+    }
+
+    fillQuadTreeParallel(tree, data, width, height, pool);
+    endStage(metrics, STAGE_FILL, start);
     if (bavard) printf("QuadTree rempli avec les données de l'image\n");
+    if (metrics) {
+        metrics->nodesVisited = filledNodes(tree);
+        metrics->bytesAllocated = quadTreeBytes(tree);
+    }
+
+    int format = (options->splitLevel >= 0) ? 2 : options->entropy ? 4 : 1;
+    if (target > 0) {
+        // Taille visée : en-tête, octet de profondeur et index Q2 sont fixes, le reste va au flux
+        start = startStage(metrics);
+        char header[256];
+        double fixed = formatQTCHeader(header, format, 0, 0.0, width, height, depth) + 1;
+        if (format == 2) fixed += 1 + 8.0 * ((size_t)1 << (2 * options->splitLevel));
+        uint64_t budget = target > fixed ? (uint64_t)(target - fixed) * 8 : 0;
 
-    if (alpha > 0) {
+        double medvar, maxvar;
+        avgAndMaxVars(tree, &medvar, &maxvar);
+        uint64_t bits;
+        alpha = filtrageToBudget(tree, medvar / maxvar, maxvar, budget, pool, &bits);
+        endStage(metrics, STAGE_FILTER, start);
+        if (alpha < 0) {
+            freeQuadTree(tree);
+            closeMappedFile(&input);
+            return -1;
+        }
+        if (bits > budget) {
+            fprintf(stderr, "Attention : Taille visée de %.0f octets inatteignable, fichier de %.0f octets au filtrage le plus fort\n",
+                    target, fixed + (double)((bits + 7) / 8));
+        }
+        if (bavard) printf("Taille visée de %.0f octets : alpha = %.4f, fichier de %.0f octets\n",
+                           target, alpha, fixed + (double)((bits + 7) / 8));
+    } else if (alpha > 0) {
+        start = startStage(metrics);
         double medvar, maxvar;
         avgAndMaxVars(tree, &medvar, &maxvar);
         if (bavard) printf("Filtrage appliqué avec alpha = %.2f\n", alpha);
-        filtrage(tree, 0, medvar / maxvar, alpha);
+        filtrageParallel(tree, medvar / maxvar, alpha, pool);
+        endStage(metrics, STAGE_FILTER, start);
+    }
+
+    start = startStage(metrics);
+
+    // Seuls les nœuds codés sont gardés pour l'encodage et la grille
+    int fullNodes = tree->totalNodes;
+    int implicitLeaves = tree->pixels != NULL;
+    int pruned = pruneQuadTree(tree);
+    closeMappedFile(&input); // les pixels ne servent plus
+    if (pruned != 0) {
+        freeQuadTree(tree);
+        fprintf(stderr, "Erreur : Impossible d'élaguer le QuadTree\n");
+        return -1;
     }
+    if (bavard) printf("QuadTree élagué : %d nœuds sur %d (%.2f%%)\n", tree->totalNodes, fullNodes, tree->totalNodes * 100.0 / fullNodes);
+    // Les feuilles gardées sont lues dans les pixels par l'élagage
+    if (metrics && implicitLeaves) metrics->nodesVisited += tree->totalNodes - tree->levelFirst[depth];
 
     FILE* output = fopen(outputFile, "wb+");
     if (!output) {
         perror("Erreur : Impossible de créer le fichier de sortie");
         freeQuadTree(tree);
-        free(data);
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     // Écrire un en-tête temporaire avec une longueur fixe pour le taux de compression
+    if (metrics) {
+        EncodedFields fields;
+        countEncodedFields(tree, &fields);
+        metrics->format = format;
+        metrics->nodesCoded = fields.nodes;
+        if (format != 4) { // les champs de Q4 n'ont pas de taille fixe
+            metrics->mBits = fields.mBits;
+            metrics->epsilonBits = fields.epsilonBits;
+            metrics->uniformBits = fields.uniformBits;
+        }
+    }
     time_t t = time(NULL);
-    char placeholderHeader[256];
-    snprintf(placeholderHeader, sizeof(placeholderHeader), 
-             "Q1\n# %s# compression rate %6s%%\n", ctime(&t), "00.00");
-    fwrite(placeholderHeader, sizeof(char), strlen(placeholderHeader), output);
+    writeQTCHeader(output, format, t, 0.0, width, height, depth);
 
     uint8_t taille = (uint8_t)depth;
     fwrite(&taille, sizeof(uint8_t), 1, output);
 
     // Encodage et calcul de la taille en bits
     size_t dataSizeQTC = 0;
-    encoderQuadTree(output, tree, &dataSizeQTC);
+    if (format == 2) {
+        size_t indexBytes = 0;
+        if (encoderQuadTreeIndexed(output, tree, options->splitLevel, &dataSizeQTC, &indexBytes, pool) != 0) {
+            fclose(output);
+            freeQuadTree(tree);
+            return -1;
+        }
+        if (bavard) printf("Index Q2 : niveau %d, %zu octets (%.2f%% du flux)\n",
+                           options->splitLevel, indexBytes, indexBytes * 800.0 / dataSizeQTC);
+    } else if (format == 4) {
+        if (encoderQuadTreeEntropy(output, tree, &dataSizeQTC) != 0) {
+            fclose(output);
+            freeQuadTree(tree);
+            return -1;
+        }
+    } else {
+        encoderQuadTreeParallel(output, tree, &dataSizeQTC, pool);
+    }
+
+    endStage(metrics, STAGE_ENCODE, start);
 
     double TO = (double)dataSizeQTC * 100 / (dataSizePGM * 8);
+    if (metrics) metrics->outputBytes = ftell(output);
 
     // Réécrire le taux de compression dans l'en-tête
+    start = startStage(metrics);
     fseek(output, 0, SEEK_SET); // Retour au début
-    char updatedHeader[256];
-    snprintf(updatedHeader, sizeof(updatedHeader), 
-             "Q1\n# %s# compression rate %6.2f%%\n", ctime(&t), TO);
-    fwrite(updatedHeader, sizeof(char), strlen(updatedHeader), output);
+    writeQTCHeader(output, format, t, TO, width, height, depth);
+    int status = fclose(output);
+    endStage(metrics, STAGE_WRITE, start);
 
-    fclose(output);
+    if (status != 0) {
+        perror("Erreur : Écriture du fichier de sortie échouée");
+        freeQuadTree(tree);
+        return -1;
+    }
 
     if (bavard) printf("QuadTree encodé avec un taux de compression de %.2f%%\n", TO);
 
-    if (generateGrid) {
-        handleGrid(tree, outputFile, size, bavard);
+    if (options->generateGrid) {
+        handleGrid(tree, outputFile, width, height, bavard);
     }
 
     freeQuadTree(tree);
-    free(data);
+    return 0;
+}
+
+
+/**
+ * Encode un fichier PGM au format QTC, sans quitter le programme en cas d'erreur.
+ * 
+ * Avec l'option -m, une ligne JSON de mesures est écrite pour le fichier, même en cas
+ * d'erreur. Avec l'option -G, la liste des blocs est relue dans le fichier QTC écrit.
+ * 
+ * @param inputFile Nom du fichier PGM à encoder.
+ * @param outputFile Nom du fichier QTC à écrire.
+ * @param options Options d'encodage (alpha, grille, mode bavard, format, tuiles, mesures).
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ * @return 0 en cas de succès, -1 en cas d'erreur (message déjà affiché).
+ */
+int encodeQTCFile(const char* inputFile, const char* outputFile, const QTCOptions* options, ThreadPool* pool) {
+    int status;
+    if (!options->metrics) {
+        status = encodeFile(inputFile, outputFile, options, pool, NULL);
+    } else {
+        Metrics metrics;
+        memset(&metrics, 0, sizeof(metrics));
+        status = encodeFile(inputFile, outputFile, options, pool, &metrics);
+        writeMetrics(options->metrics, &metrics, "encode", inputFile, outputFile, status);
+    }
+    if (status == 0 && options->generateSegments) status = handleSegments(outputFile, outputFile, options->bavard);
+    return status;
+}
+
+
+/**
+ * Gère le processus d'encodage d'un fichier QTC
+ * 
+ * @param inputFile Nom du fichier à encoder.
+ * @param outputFile Nom du fichier de sortie où écrire les données encodées.
+ * @param options Options d'encodage (alpha, grille, mode bavard, threads, format).
+ */
+void handleEncoding(const char* inputFile, const char* outputFile, const QTCOptions* options) {
+    printf("\n\nEncodage en cours : fichier %s\n\n", inputFile);
+    ThreadPool* pool = createOptionsPool(options);
+    int status = encodeQTCFile(inputFile, outputFile, options, pool);
+    freeThreadPool(pool);
+    if (status != 0) exit(EXIT_FAILURE);
 
     printf("\nEncodage terminé\n");
 }
 
 
 /**
- * Gère le processus de décodage d'un fichier QTC en PGM.
+ * @brief Décode un fichier au format Q3, tuile par tuile (voir decoderQuadTreeTiled).
  * 
- * @param inputFile Nom du fichier.pgm à décoder.
- * @param outputFile Nom du fichier de sortie où écrire les données décodées.
- * @param generateGrid utilisé pour savoir si l'option -g de génération de la grille de segemntation est activée.
- * @param bavard Si différent de 0, affiche des informations détaillées pendant l'exécution.
+ * @param input Fichier projeté contenant le flux (fermé par cette fonction).
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param taille Profondeur de l'image.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param outputFile Nom du fichier de sortie.
+ * @param options Options de décodage.
+ * @param pool Pool de threads (NULL pour un décodage séquentiel).
+ * @param metrics Mesures à remplir (NULL : désactivées).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
  */
-void handleDecoding(const char* inputFile, const char* outputFile, int generateGrid, int bavard) {
-    printf("\n\nDécodage en cours : fichier %s\n\n", inputFile);
-    FILE* input = fopen(inputFile, "rb");
-    if (!input) {
-        perror("Erreur : Impossible d'ouvrir le fichier d'entrée");
-        exit(EXIT_FAILURE);
+static int decodeTiledFile(MappedFile* input, const uint8_t* data, size_t dataSize, int taille, int width,
+                           int height, const char* outputFile, const QTCOptions* options, ThreadPool* pool,
+                           Metrics* metrics) {
+    int bavard = options->bavard;
+    if (taille > MAX_TREE_DEPTH + MAX_TILE_DEPTH) {
+        closeMappedFile(input);
+        fprintf(stderr, "Erreur : Profondeur %d invalide\n", taille);
+        return -1;
     }
-    int taille;
-    uint8_t* data = readQTCFile(input, &taille);
+
+    // L'image est reconstruite directement dans le fichier de sortie projeté
+    MappedFile output;
+    uint8_t* image = createPGMFile(outputFile, &output, width, height, 255);
+    if (!image) {
+        closeMappedFile(input);
+        fprintf(stderr, "Erreur : Échec de l'écriture du fichier PGM\n");
+        return -1;
+    }
+    if (metrics) metrics->outputBytes = output.size;
+
+    char gridOutput[256];
+    MappedFile gridFile;
+    uint8_t* grid = options->generateGrid ? createGridFile(outputFile, &gridFile, width, height, gridOutput, sizeof(gridOutput)) : NULL;
+
+    // Décodage et peinture sont entrelacés, tuile par tuile : une seule étape
+    double start = startStage(metrics);
+    TiledStats stats;
+    int status = decoderQuadTreeTiled(data, dataSize, width, height, taille, image, grid, pool, &stats);
+    closeMappedFile(input); // le flux ne sert plus
+    endStage(metrics, STAGE_DECODE, start);
+    if (metrics) metrics->nodesCoded = stats.codedNodes;
+    if (grid) closeGridFile(&gridFile, gridOutput, bavard);
+    start = startStage(metrics);
+    if (status != 0 || closeMappedFile(&output) != 0) {
+        if (status == 0) fprintf(stderr, "Erreur : Échec de l'écriture du fichier PGM\n");
+        else closeMappedFile(&output);
+        return -1;
+    }
+    endStage(metrics, STAGE_WRITE, start);
+
+    if (bavard) {
+        printf("Tuiles décodées : %llu sur %llu, %llu nœuds codés\n", (unsigned long long)stats.codedTiles,
+               (unsigned long long)stats.tiles, (unsigned long long)stats.codedNodes);
+        printf("Index Q3 : %llu octets (%.2f%% des données)\n", (unsigned long long)stats.indexBytes,
+               stats.indexBytes * 100.0 / dataSize);
+        printf("Image décodée avec succès dans %s\n", outputFile);
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Décode un flux unique (formats Q1 et Q4) directement dans l'image de sortie.
+ * 
+ * L'arbre n'est pas construit : voir decodeQTCImage. Avec level < taille, l'image écrite
+ * est l'aperçu réduit des blocs du niveau level.
+ * 
+ * @param input Fichier QTC projeté (fermé par la fonction).
+ * @param data Flux à décoder.
+ * @param dataSize Taille du flux en octets.
+ * @param format Codage du flux (1 ou 4).
+ * @param taille Profondeur de l'image.
+ * @param level Dernier niveau à décoder (au plus taille).
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param outputFile Nom du fichier de sortie.
+ * @param options Options de décodage.
+ * @param metrics Mesures à remplir (NULL : désactivées).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int decodeStreamFile(MappedFile* input, const uint8_t* data, size_t dataSize, int format, int taille, int level,
+                            int width, int height, const char* outputFile, const QTCOptions* options, Metrics* metrics) {
+    int bavard = options->bavard;
+    int outWidth = coveringBlocks(width, taille - level);
+    int outHeight = coveringBlocks(height, taille - level);
+
+    // L'image est reconstruite directement dans le fichier de sortie projeté
+    MappedFile output;
+    uint8_t* image = createPGMFile(outputFile, &output, outWidth, outHeight, 255);
+    if (!image) {
+        closeMappedFile(input);
+        fprintf(stderr, "Erreur : Échec de l'écriture du fichier PGM\n");
+        return -1;
+    }
+    if (metrics) metrics->outputBytes = output.size;
+
+    char gridOutput[256];
+    MappedFile gridFile;
+    uint8_t* grid = options->generateGrid ? createGridFile(outputFile, &gridFile, outWidth, outHeight, gridOutput, sizeof(gridOutput)) : NULL;
+
+    // Décodage et peinture sont entrelacés, niveau par niveau : une seule étape
+    double start = startStage(metrics);
+    DecodeStats stats;
+    int status = decodeQTCImage(data, dataSize, format, width, height, taille, level, image, grid, &stats);
+    closeMappedFile(input); // le flux ne sert plus
+    endStage(metrics, STAGE_DECODE, start);
+    if (metrics) {
+        metrics->nodesVisited = stats.nodes;
+        metrics->nodesCoded = stats.fields.nodes;
+        if (format == 1) {
+            metrics->mBits = stats.fields.mBits;
+            metrics->epsilonBits = stats.fields.epsilonBits;
+            metrics->uniformBits = stats.fields.uniformBits;
+        }
+        metrics->bytesAllocated = stats.bytes;
+    }
+    if (grid) closeGridFile(&gridFile, gridOutput, bavard);
+    start = startStage(metrics);
+    if (status != 0 || closeMappedFile(&output) != 0) {
+        if (status == 0) fprintf(stderr, "Erreur : Échec de l'écriture du fichier PGM\n");
+        else closeMappedFile(&output);
+        return -1;
+    }
+    endStage(metrics, STAGE_WRITE, start);
+
+    if (bavard) {
+        printf("Décodage direct : %llu nœuds décodés, %llu octets de niveaux conservés\n",
+               (unsigned long long)stats.nodes, (unsigned long long)stats.bytes);
+        if (level < taille) printf("Aperçu du niveau %d : %dx%d pixels\n", level, outWidth, outHeight);
+        printf("Image décodée avec succès dans %s\n", outputFile);
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Décode un fichier QTC en PGM (voir decodeQTCFile), en remplissant les mesures.
+ * 
+ * @param inputFile Nom du fichier QTC à décoder.
+ * @param outputFile Nom du fichier PGM à écrire.
+ * @param options Options de décodage.
+ * @param pool Pool de threads (NULL pour un décodage séquentiel).
+ * @param metrics Mesures à remplir (NULL : désactivées).
+ * @return 0 en cas de succès, -1 en cas d'erreur (message déjà affiché).
+ */
+static int decodeFile(const char* inputFile, const char* outputFile, const QTCOptions* options, ThreadPool* pool,
+                      Metrics* metrics) {
+    int bavard = options->bavard;
+    int taille, width, height, format;
+    size_t dataSize;
+    MappedFile input;
+    double start = startStage(metrics);
+    const uint8_t* data = mapQTCFile(inputFile, &input, &taille, &width, &height, &dataSize, &format);
     if (!data) {
-        fclose(input);
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Erreur : Impossible de lire le fichier QTC %s\n", inputFile);
+        return -1;
+    }
+    endStage(metrics, STAGE_READ, start);
+    if (metrics) {
+        metrics->format = format;
+        metrics->width = width;
+        metrics->height = height;
+        metrics->inputBytes = input.size;
+    }
+    if(bavard) printf("lecture du fichier réussie du fichier .qtc donné... \n") ;
+    int level = (options->level >= 0 && options->level < taille) ? options->level : taille;
+    if (level < taille && (format == 2 || format == 3)) {
+        // Aperçu : seul le flux des niveaux supérieurs (codé comme en Q1) est lu
+        size_t topSize;
+        int topDepth;
+        const uint8_t* top = format == 2 ? indexedTopStream(data, dataSize, taille, &topSize, &topDepth)
+                                         : tiledTopStream(data, dataSize, width, height, taille, &topSize, &topDepth);
+        if (top && level > topDepth) {
+            fprintf(stderr, "Erreur : Aperçu limité au niveau %d pour ce fichier Q%d\n", topDepth, format);
+            top = NULL;
+        }
+        if (!top) {
+            closeMappedFile(&input);
+            return -1;
+        }
+        return decodeStreamFile(&input, top, topSize, 1, taille, level, width, height, outputFile, options, metrics);
     }
-    if(bavard) printf("lecture du fichier réussie du fichier .qtc donné... \n") ; 
+    if (format == 3) { // tuiles décodées une à une, sans arbre complet
+        return decodeTiledFile(&input, data, dataSize, taille, width, height, outputFile, options, pool, metrics);
+    }
+    if (format != 2) { // flux unique décodé directement dans l'image, sans arbre
+        return decodeStreamFile(&input, data, dataSize, format, taille, level, width, height, outputFile, options, metrics);
+    }
+
+    start = startStage(metrics);
 
     // Créer et remplir le QuadTree à partir des données QTC
-    QuadTree* tree = createQuadTree(taille);
+    QuadTree* tree = createSparseQuadTree(taille);
+    if (tree && setImageSize(tree, width, height) != 0) {
+        freeQuadTree(tree);
+        tree = NULL;
+    }
     if (!tree) {
-        free(data);
-        fclose(input);
+        closeMappedFile(&input);
         fprintf(stderr, "Erreur : Impossible de créer le QuadTree.\n");
-        exit(EXIT_FAILURE);
+        return -1;
+    }
+    if(bavard) printf("création d'un abre quadtree vide de taille %d\n" , taille) ;
+
+    // Flux indexé : sous-arbres décodés en parallèle
+    size_t indexBytes = 0;
+    int status = fillQuadTreeFromQTCIndexed(data, dataSize, tree, pool, &indexBytes);
+    if (status == 0 && bavard) printf("Index Q2 : %zu octets (%.2f%% des données)\n", indexBytes, indexBytes * 100.0 / dataSize);
+    closeMappedFile(&input); // le flux ne sert plus
+    if (status != 0) {
+        freeQuadTree(tree);
+        return -1;
+    }
+    endStage(metrics, STAGE_DECODE, start);
+    if (metrics) {
+        EncodedFields fields;
+        countEncodedFields(tree, &fields);
+        metrics->nodesVisited = tree->totalNodes;
+        metrics->nodesCoded = fields.nodes;
+        metrics->mBits = fields.mBits;
+        metrics->epsilonBits = fields.epsilonBits;
+        metrics->uniformBits = fields.uniformBits;
+        metrics->bytesAllocated = quadTreeBytes(tree);
     }
-    if(bavard) printf("création d'un abre quadtree vide de taille %d\n" , taille) ; 
-    fillQuadTreeFromQTC(data, tree);
-
-    if(bavard) printf("remplissage de l'arbre quatree \n") ; 
 
+    if(bavard) printf("remplissage de l'arbre quatree : %d nœuds codés\n", tree->totalNodes) ;
 
-    // Calculer la largeur de l'image (2^taille)
-    int width = 1 << taille;
 
-    // Allouer la mémoire pour l'image
-    uint8_t* image = malloc(width * width);
+    // L'image est reconstruite directement dans le fichier de sortie projeté
+    start = startStage(metrics);
+    MappedFile output;
+    uint8_t* image = createPGMFile(outputFile, &output, width, height, 255);
     if (!image) {
-        free(data);
         freeQuadTree(tree);
-        fclose(input);
-        fprintf(stderr, "Erreur : Allocation mémoire pour l'image échouée.\n");
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Erreur : Échec de l'écriture du fichier PGM\n");
+        return -1;
     }
+    if (metrics) metrics->outputBytes = output.size;
 
-    // Reconstruire les données de l'image à partir du QuadTree
-    createDataFromTree(tree, image, width, width, 0, 0, 0, width);
+    char gridOutput[256];
+    MappedFile gridFile;
+    uint8_t* grid = options->generateGrid ? createGridFile(outputFile, &gridFile, width, height, gridOutput, sizeof(gridOutput)) : NULL;
+
+    // Reconstruire les données de l'image (et la grille) à partir du QuadTree
+    createDataFromTreeParallel(tree, image, grid, width, height, pool);
+    endStage(metrics, STAGE_RECONSTRUCT, start);
+    if (grid) closeGridFile(&gridFile, gridOutput, bavard);
 
-    // Écrire les données de l'image dans le fichier de sortie
-    if (writePGMFile(outputFile, image, width, width, 255) != 0) {
+    start = startStage(metrics);
+    if (closeMappedFile(&output) != 0) {
         fprintf(stderr, "Erreur : Échec de l'écriture du fichier PGM\n");
-        free(image);
-        free(data);
         freeQuadTree(tree);
-        fclose(input);
-        exit(EXIT_FAILURE);
+        return -1;
     }
+    endStage(metrics, STAGE_WRITE, start);
 
     if (bavard) printf("Image décodée avec succès dans %s\n", outputFile);
 
-    // Générer la grille de segmentation si demandé
-    if (generateGrid) {
-        handleGrid(tree, outputFile, width, bavard);
+    // Libérer la mémoire
+    freeQuadTree(tree);
+    return 0;
+}
+
+
+/**
+ * Décode un fichier QTC en PGM, sans quitter le programme en cas d'erreur.
+ * 
+ * Avec l'option -m, une ligne JSON de mesures est écrite pour le fichier, même en cas
+ * d'erreur. Avec l'option -G, la liste des blocs est lue dans le fichier QTC décodé.
+ * 
+ * @param inputFile Nom du fichier QTC à décoder.
+ * @param outputFile Nom du fichier PGM à écrire.
+ * @param options Options de décodage (grille, mode bavard, mesures).
+ * @param pool Pool de threads (NULL pour un décodage séquentiel).
+ * @return 0 en cas de succès, -1 en cas d'erreur (message déjà affiché).
+ */
+int decodeQTCFile(const char* inputFile, const char* outputFile, const QTCOptions* options, ThreadPool* pool) {
+    int status;
+    if (!options->metrics) {
+        status = decodeFile(inputFile, outputFile, options, pool, NULL);
+    } else {
+        Metrics metrics;
+        memset(&metrics, 0, sizeof(metrics));
+        status = decodeFile(inputFile, outputFile, options, pool, &metrics);
+        writeMetrics(options->metrics, &metrics, "decode", inputFile, outputFile, status);
     }
+    if (status == 0 && options->generateSegments) status = handleSegments(inputFile, outputFile, options->bavard);
+    return status;
+}
 
-    // Libérer la mémoire et fermer les fichiers
-    free(image);
-    free(data);
-    freeQuadTree(tree);
-    fclose(input);
+
+/**
+ * Gère le processus de décodage d'un fichier QTC en PGM.
+ * 
+ * @param inputFile Nom du fichier.pgm à décoder.
+ * @param outputFile Nom du fichier de sortie où écrire les données décodées.
+ * @param options Options de décodage (grille, mode bavard, threads).
+ */
+void handleDecoding(const char* inputFile, const char* outputFile, const QTCOptions* options) {
+    printf("\n\nDécodage en cours : fichier %s\n\n", inputFile);
+    ThreadPool* pool = createOptionsPool(options);
+    int status = decodeQTCFile(inputFile, outputFile, options, pool);
+    freeThreadPool(pool);
+    if (status != 0) exit(EXIT_FAILURE);
 
     printf("\nDécodage terminé.\n");
 }
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "region.h"
+#include "decodage.h"
+#include "tiled.h"
+
+
+/**
+ * @brief Rectangle à décoder et tableau qui le reçoit.
+ */
+typedef struct {
+    const QTCImage* image;
+    int x;              // coin haut-gauche du rectangle dans l'image
+    int y;
+    int w;
+    int h;
+    uint8_t* region;    // w * h pixels, ligne par ligne (NULL avec `segments`)
+    FILE* segments;     // liste des blocs à écrire au lieu de peindre les pixels, ou NULL
+    int status;
+} RegionPainter;
+
+
+/**
+ * @brief Remplit l'intersection d'un bloc et du rectangle avec une valeur (ou l'écrit
+ * dans la liste des blocs).
+ *
+ * @param painter Rectangle à décoder.
+ * @param x Colonne du bloc dans l'image.
+ * @param y Ligne du bloc dans l'image.
+ * @param size Côté du bloc.
+ * @param m Valeur des pixels du bloc.
+ */
+static void fillRegion(RegionPainter* painter, int64_t x, int64_t y, int64_t size, uint8_t m) {
+    int x0 = x > painter->x ? (int)x : painter->x;
+    int y0 = y > painter->y ? (int)y : painter->y;
+    int x1 = x + size < painter->x + painter->w ? (int)(x + size) : painter->x + painter->w;
+    int y1 = y + size < painter->y + painter->h ? (int)(y + size) : painter->y + painter->h;
+    if (painter->segments) {
+        if (fprintf(painter->segments, "%d %d %d %d %d\n", x0, y0, x1 - x0, y1 - y0, m) < 0) painter->status = -1;
+        return;
+    }
+    for (int row = y0; row < y1; row++) {
+        memset(painter->region + (size_t)(row - painter->y) * painter->w + (x0 - painter->x), m, x1 - x0);
+    }
+}
+
+
+/**
+ * @brief Vérifie si un bloc coupe le rectangle.
+ */
+static inline int intersectsRegion(const RegionPainter* painter, int64_t x, int64_t y, int64_t size) {
+    return x < painter->x + painter->w && x + size > painter->x && y < painter->y + painter->h && y + size > painter->y;
+}
+
+
+/**
+ * @brief Peint dans le rectangle la partie d'un arbre creux qui le coupe.
+ *
+ * Seuls les nœuds dont le bloc coupe le rectangle sont visités : les autres branches
+ * ne sont pas descendues.
+ *
+ * @param painter Rectangle à décoder.
+ * @param tree Arbre creux (index des rangs à jour).
+ * @param node Index du nœud.
+ * @param level Niveau du nœud.
+ * @param lastLevel Dernier niveau stocké dans l'arbre.
+ * @param x Colonne du bloc du nœud dans l'image.
+ * @param y Ligne du bloc du nœud dans l'image.
+ * @param shift Le bloc du nœud a un côté de 2^shift pixels.
+ * @param bx Colonne du bloc parmi ceux de son niveau (racines des sous-flux au niveau lastLevel).
+ * @param by Ligne du bloc parmi ceux de son niveau.
+ */
+static void paintRegion(RegionPainter* painter, const QuadTree* tree, int node, int level, int lastLevel,
+                        int64_t x, int64_t y, int shift, int bx, int by);
+
+
+/**
+ * @brief Décode le sous-flux d'une racine non uniforme (sous-arbre Q2 ou tuile Q3) et le
+ * peint dans le rectangle, puis le libère.
+ *
+ * @param painter Rectangle à décoder.
+ * @param root Index de la racine dans l'arbre des niveaux supérieurs.
+ * @param x Colonne du bloc de la racine dans l'image.
+ * @param y Ligne du bloc de la racine dans l'image.
+ * @param bx Colonne du bloc parmi les racines.
+ * @param by Ligne du bloc parmi les racines.
+ */
+static void paintSubstream(RegionPainter* painter, int root, int64_t x, int64_t y, int bx, int by) {
+    const QTCImage* image = painter->image;
+    int subDepth = image->depth - image->topDepth;
+    int64_t side = (int64_t)1 << subDepth;
+
+    QuadTree* sub = createSparseQuadTree(subDepth);
+    if (sub && setImageSize(sub, image->width - x < side ? (int)(image->width - x) : (int)side,
+                            image->height - y < side ? (int)(image->height - y) : (int)side) != 0) {
+        freeQuadTree(sub);
+        sub = NULL;
+    }
+    if (!sub) {
+        painter->status = -1;
+        return;
+    }
+    setNodeM(sub, 0, getNodeM(image->top, root));
+    setNodeEpsilon(sub, 0, getNodeEpsilon(image->top, root));
+
+    BitReader reader;
+    int status;
+    if (image->format == 2) {
+        int r = blockOffset(bx, by);
+        initBitReader(&reader, image->stream, image->streamSize);
+        seekBitReader(&reader, image->offsets[r]);
+        status = fillSubtreeFromQTC(&reader, sub);
+        if (status == 0 && bitReaderPosition(&reader) > image->offsets[r + 1]) status = -1;
+    } else {
+        uint64_t index = (uint64_t)by * image->cols + bx;
+        initBitReader(&reader, image->stream + image->offsets[index], image->offsets[index + 1] - image->offsets[index]);
+        status = fillSubtreeFromQTC(&reader, sub);
+        if (status == 0 && bitReaderOverrun(&reader)) status = -1;
+    }
+
+    if (status == 0) paintRegion(painter, sub, 0, 0, subDepth, x, y, subDepth, 0, 0);
+    else painter->status = -1;
+    freeQuadTree(sub);
+}
+
+
+static void paintRegion(RegionPainter* painter, const QuadTree* tree, int node, int level, int lastLevel,
+                        int64_t x, int64_t y, int shift, int bx, int by) {
+    if (!intersectsRegion(painter, x, y, (int64_t)1 << shift)) return; // hors du rectangle (ou de l'image)
+
+    if (level == lastLevel && !isUniform(tree, node) && shift > 0) {
+        // Racine non uniforme d'un sous-flux : seul l'arbre des niveaux supérieurs s'arrête avant les pixels
+        paintSubstream(painter, node, x, y, bx, by);
+        return;
+    }
+    if (level == lastLevel || isUniform(tree, node)) {
+        fillRegion(painter, x, y, (int64_t)1 << shift, getNodeM(tree, node));
+        return;
+    }
+
+    // Enfants : haut-gauche, haut-droit, bas-droit, bas-gauche
+    static const int dx[4] = { 0, 1, 1, 0 }, dy[4] = { 0, 0, 1, 1 };
+    int child = getChildIndex(tree, node);
+    int64_t half = (int64_t)1 << (shift - 1);
+    for (int k = 0; k < 4 && painter->status == 0; k++) {
+        paintRegion(painter, tree, child + k, level + 1, lastLevel, x + dx[k] * half, y + dy[k] * half, shift - 1,
+                    2 * bx + dx[k], 2 * by + dy[k]);
+    }
+}
+
+
+/**
+ * @brief Décode les niveaux supérieurs d'un fichier Q2 et lit les positions de ses sous-flux.
+ *
+ * @param image Fichier en cours d'ouverture (arbre créé, dimensions fixées).
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @return 0 en cas de succès, -1 si les données sont invalides.
+ */
+static int openIndexedImage(QTCImage* image, const uint8_t* data, size_t dataSize) {
+    int split;
+    image->stream = indexedTopStream(data, dataSize, image->depth, &image->streamSize, &split);
+    if (!image->stream) return -1;
+    image->topDepth = split;
+
+    // Les positions doivent être croissantes et rester dans le flux
+    int nbRoots = 1 << (2 * split);
+    image->offsets = (uint64_t*)malloc((nbRoots + 1) * sizeof(uint64_t));
+    if (!image->offsets) {
+        perror("Erreur lors de l'allocation de l'index");
+        return -1;
+    }
+    for (int r = 0; r < nbRoots; r++) {
+        image->offsets[r] = getUint64(data + 1 + 8 * (size_t)r);
+        if (image->offsets[r] > image->streamSize * 8 || (r > 0 && image->offsets[r] < image->offsets[r - 1])) {
+            fprintf(stderr, "Erreur : Index QTC invalide\n");
+            return -1;
+        }
+    }
+    image->offsets[nbRoots] = image->streamSize * 8;
+
+    BitReader reader;
+    initBitReader(&reader, image->stream, image->streamSize);
+    if (fillQuadTreeLevelsFromQTC(&reader, image->top, split) != 0) return -1;
+    if (bitReaderPosition(&reader) > image->offsets[0]) {
+        fprintf(stderr, "Erreur : Données QTC tronquées\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Décode les niveaux supérieurs d'un fichier Q3 et lit les positions de ses tuiles.
+ *
+ * L'arbre des niveaux supérieurs est ramené à topDepth niveaux, comme au décodage
+ * complet (voir decoderQuadTreeTiled) : ses dimensions sont comptées en tuiles.
+ *
+ * @param image Fichier en cours d'ouverture (arbre créé, dimensions fixées).
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @return 0 en cas de succès, -1 si les données sont invalides.
+ */
+static int openTiledImage(QTCImage* image, const uint8_t* data, size_t dataSize) {
+    int tileDepth = dataSize > 0 ? data[0] : 0;
+    image->topDepth = image->depth - tileDepth;
+    if (tileDepth < 1 || tileDepth > MAX_TILE_DEPTH || image->topDepth < 0 || image->topDepth > MAX_TREE_DEPTH) {
+        fprintf(stderr, "Erreur : Profondeur de tuile %d invalide\n", tileDepth);
+        return -1;
+    }
+    image->cols = coveringBlocks(image->width, tileDepth);
+    int rows = coveringBlocks(image->height, tileDepth);
+    uint64_t nbTiles = (uint64_t)image->cols * rows;
+
+    size_t topSize;
+    image->stream = data + 1;
+    image->offsets = readTileIndex(image->stream, dataSize - 1, nbTiles, &topSize);
+    if (!image->offsets) return -1;
+
+    BitReader reader;
+    initBitReader(&reader, image->stream + image->offsets[nbTiles], topSize);
+    if (fillQuadTreeLevelsFromQTC(&reader, image->top, image->topDepth) != 0) return -1;
+    if (bitReaderOverrun(&reader)) {
+        fprintf(stderr, "Erreur : Données QTC tronquées\n");
+        return -1;
+    }
+    image->top->depth = image->topDepth;
+    image->top->width = image->cols;
+    image->top->height = rows;
+    return 0;
+}
+
+
+/**
+ * Ouvre un fichier QTC pour des accès à des régions.
+ *
+ * Le fichier reste projeté jusqu'à closeQTCImage : les sous-flux y sont lus à la demande.
+ *
+ * @param filename Nom du fichier QTC.
+ * @return Le fichier ouvert (à fermer par closeQTCImage), ou NULL en cas d'erreur.
+ */
+QTCImage* openQTCImage(const char* filename) {
+    QTCImage* image = (QTCImage*)calloc(1, sizeof(QTCImage));
+    if (!image) {
+        perror("Erreur lors de l'allocation du fichier QTC");
+        return NULL;
+    }
+
+    size_t dataSize;
+    const uint8_t* data = mapQTCFile(filename, &image->file, &image->depth, &image->width, &image->height,
+                                     &dataSize, &image->format);
+    if (!data) {
+        fprintf(stderr, "Erreur : Impossible de lire le fichier QTC %s\n", filename);
+        free(image);
+        return NULL;
+    }
+
+    int maxDepth = image->format == 3 ? MAX_TREE_DEPTH + MAX_TILE_DEPTH : MAX_TREE_DEPTH;
+    if (image->depth > maxDepth) {
+        fprintf(stderr, "Erreur : Profondeur %d invalide\n", image->depth);
+        closeMappedFile(&image->file);
+        free(image);
+        return NULL;
+    }
+
+    image->top = createSparseQuadTree(image->depth);
+    int status = (image->top && setImageSize(image->top, image->width, image->height) == 0) ? 0 : -1;
+    if (status == 0) {
+        image->topDepth = image->depth;
+        switch (image->format) {
+        case 1: status = fillQuadTreeFromQTC(data, dataSize, image->top); break;
+        case 2: status = openIndexedImage(image, data, dataSize); break;
+        case 3: status = openTiledImage(image, data, dataSize); break;
+        default: status = fillQuadTreeFromQTCEntropy(data, dataSize, image->top); break;
+        }
+    }
+    if (status != 0) {
+        closeQTCImage(image);
+        return NULL;
+    }
+    return image;
+}
+
+
+/**
+ * Décode un rectangle de l'image.
+ *
+ * Les blocs qui ne coupent pas le rectangle ne sont pas descendus ; en Q2 et Q3, chaque
+ * sous-flux qui le coupe est décodé puis libéré (rien n'est gardé d'un appel à l'autre).
+ *
+ * @param image Fichier ouvert par openQTCImage.
+ * @param x Colonne du coin haut-gauche du rectangle.
+ * @param y Ligne du coin haut-gauche du rectangle.
+ * @param w Largeur du rectangle.
+ * @param h Hauteur du rectangle.
+ * @param region Tableau de w * h pixels, ligne par ligne, à remplir.
+ * @return 0 en cas de succès, -1 si le rectangle sort de l'image ou si les données sont invalides.
+ */
+int decodeQTCRegion(const QTCImage* image, int x, int y, int w, int h, uint8_t* region) {
+    if (!image || !region || x < 0 || y < 0 || w < 1 || h < 1 || x > image->width - w || y > image->height - h) {
+        fprintf(stderr, "Erreur : Région invalide\n");
+        return -1;
+    }
+
+    RegionPainter painter = { image, x, y, w, h, region, NULL, 0 };
+    paintRegion(&painter, image->top, 0, 0, image->topDepth, 0, 0, image->depth, 0, 0);
+    if (painter.status != 0) fprintf(stderr, "Erreur : Données QTC tronquées\n");
+    return painter.status;
+}
+
+
+/**
+ * Écrit la liste des blocs de la segmentation de l'image, à la place d'une grille.
+ *
+ * Format texte : une ligne `QTCSEG largeur hauteur`, puis une ligne `x y largeur hauteur
+ * moyenne` par feuille de l'arbre (bloc uniforme ou pixel), rognée aux dimensions de
+ * l'image, dans l'ordre du parcours en profondeur (haut-gauche, haut-droit, bas-droit,
+ * bas-gauche). Les sous-flux Q2 et Q3 sont décodés un à un, comme pour une région.
+ *
+ * @param image Fichier ouvert par openQTCImage.
+ * @param output Flux de sortie.
+ * @return 0 en cas de succès, -1 si les données sont invalides ou en cas d'erreur d'écriture.
+ */
+int writeQTCSegments(const QTCImage* image, FILE* output) {
+    if (fprintf(output, "QTCSEG %d %d\n", image->width, image->height) < 0) return -1;
+
+    RegionPainter painter = { image, 0, 0, image->width, image->height, NULL, output, 0 };
+    paintRegion(&painter, image->top, 0, 0, image->topDepth, 0, 0, image->depth, 0, 0);
+    if (painter.status != 0) fprintf(stderr, "Erreur : Écriture de la liste des blocs échouée\n");
+    return painter.status;
+}
+
+
+/**
+ * Renvoie la valeur d'un pixel de l'image.
+ *
+ * @param image Fichier ouvert par openQTCImage.
+ * @param x Colonne du pixel.
+ * @param y Ligne du pixel.
+ * @return La valeur du pixel (0 à 255), ou -1 s'il est hors de l'image ou si les données sont invalides.
+ */
+int getQTCPixel(const QTCImage* image, int x, int y) {
+    uint8_t value;
+    return decodeQTCRegion(image, x, y, 1, 1, &value) == 0 ? value : -1;
+}
+
+
+/**
+ * Ferme un fichier ouvert par openQTCImage.
+ *
+ * @param image Fichier à fermer (peut être NULL).
+ */
+void closeQTCImage(QTCImage* image) {
+    if (!image) return;
+    freeQuadTree(image->top);
+    free(image->offsets);
+    closeMappedFile(&image->file);
+    free(image);
+}
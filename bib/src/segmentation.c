@@ -1,11 +1,97 @@
 #include "segmentation.h"
 
 
+/**
+ * Intensité des contours dans la grille de segmentation (fond blanc).
+ */
+#define SEGMENT_INTENSITY 120
+
+
+/**
+ * @brief Trace des côtés d'un bloc dans une grille de segmentation.
+ * 
+ * Les côtés horizontaux sont tracés d'un coup (memset), les côtés verticaux pixel par
+ * pixel. Les parties qui sortent de la grille ne sont pas tracées.
+ * 
+ * @param grid Tableau représentant la grille de segmentation.
+ * @param width Largeur de la grille.
+ * @param height Hauteur de la grille.
+ * @param x Coordonnée X du bloc.
+ * @param y Coordonnée Y du bloc.
+ * @param size Côté du bloc.
+ * @param sides Côtés à tracer (masque de SEGMENT_TOP, SEGMENT_RIGHT, SEGMENT_BOTTOM, SEGMENT_LEFT).
+ */
+void drawSegmentSides(uint8_t* grid, int width, int height, int x, int y, int size, int sides) {
+    if (x >= width || y >= height) return;
+    int w = (size < width - x) ? size : width - x;
+    int h = (size < height - y) ? size : height - y;
+    uint8_t* corner = grid + (size_t)y * width + x;
+
+    if (sides & SEGMENT_TOP) memset(corner, SEGMENT_INTENSITY, w);
+    if ((sides & SEGMENT_BOTTOM) && h == size) memset(corner + (size_t)(size - 1) * width, SEGMENT_INTENSITY, w);
+    if (sides & SEGMENT_LEFT) {
+        for (int row = 0; row < h; row++) corner[(size_t)row * width] = SEGMENT_INTENSITY;
+    }
+    if ((sides & SEGMENT_RIGHT) && w == size) {
+        for (int row = 0; row < h; row++) corner[(size_t)row * width + size - 1] = SEGMENT_INTENSITY;
+    }
+}
+
+
+/**
+ * @brief Trace le contour d'un bloc dans une grille de segmentation.
+ * 
+ * Les parties du contour qui sortent de la grille ne sont pas tracées.
+ * 
+ * @param grid Tableau représentant la grille de segmentation.
+ * @param width Largeur de la grille.
+ * @param height Hauteur de la grille.
+ * @param x Coordonnée X du bloc.
+ * @param y Coordonnée Y du bloc.
+ * @param size Côté du bloc.
+ */
+void drawSegmentOutline(uint8_t* grid, int width, int height, int x, int y, int size) {
+    drawSegmentSides(grid, width, height, x, y, size, SEGMENT_OUTLINE);
+}
+
+
+/**
+ * @brief Trace les contours des descendants non uniformes d'un nœud dont le contour est déjà tracé.
+ * 
+ * Chaque enfant non uniforme ne trace que ses deux côtés intérieurs (voir
+ * childSegmentSides) : aucun pixel n'est tracé deux fois par un parent et son enfant.
+ * Les feuilles ne sont pas visitées (leur pixel est sur le contour de leur parent).
+ * 
+ * @param tree Pointeur vers le QuadTree contenant les données de segmentation.
+ * @param grid Tableau représentant la grille de segmentation.
+ * @param width Largeur de la grille.
+ * @param height Hauteur de la grille.
+ * @param nodeIndex Index du nœud (non uniforme).
+ * @param x Coordonnée X du bloc du nœud.
+ * @param y Coordonnée Y du bloc du nœud.
+ * @param size Côté du bloc du nœud.
+ */
+static void drawInnerSegments(QuadTree* tree, uint8_t* grid, int width, int height, int nodeIndex, int x, int y, int size) {
+    int childIndex = getChildIndex(tree, nodeIndex);
+    if (isLeaf(tree, childIndex)) return;
+
+    // Enfants : haut-gauche, haut-droit, bas-droit, bas-gauche
+    static const int dx[4] = { 0, 1, 1, 0 }, dy[4] = { 0, 0, 1, 1 };
+    int halfSize = size / 2;
+    for (int k = 0; k < 4; k++) {
+        int cx = x + dx[k] * halfSize, cy = y + dy[k] * halfSize;
+        if (isUniform(tree, childIndex + k) || cx >= width || cy >= height) continue;
+        drawSegmentSides(grid, width, height, cx, cy, halfSize, childSegmentSides(k));
+        drawInnerSegments(tree, grid, width, height, childIndex + k, cx, cy, halfSize);
+    }
+}
+
+
 /**
  * @brief Génère une grille de segmentation à partir d'un QuadTree.
  * 
- * Cette fonction remplit une grille en associant les segments définis par le QuadTree 
- * aux pixels correspondants dans l'image.
+ * Cette fonction trace dans la grille le contour de chaque bloc non uniforme du
+ * QuadTree, à partir du nœud donné (dont le contour est tracé en entier).
  * 
  * @param tree Pointeur vers le QuadTree contenant les données de segmentation.
  * @param grid Tableau représentant la grille de segmentation
@@ -19,29 +105,9 @@
 void generateSegmentationGrid(QuadTree* tree, uint8_t* grid, int width, int height, int nodeIndex, int x, int y, int size) {
     if (!tree || !grid || nodeIndex < 0 || size <= 0) return;
 
-    QuadTreeNode* node = &tree->nodes[nodeIndex];
-
-    if (node->uniform == 0) {
-        for (int i = 0; i < size; i++) {
-            if (x + i < width && y < height) grid[y * width + (x + i)] = 120;            
-            if (x + i < width && y + size - 1 < height) grid[(y + size - 1) * width + (x + i)] = 120;
-
-            // Bordures verticales
-            if (x < width && y + i < height) grid[(y + i) * width + x] = 120;            
-            if (x + size - 1 < width && y + i < height) grid[(y + i) * width + (x + size - 1)] = 120;
-        }
-    }
-
-    if (isLeaf(tree, nodeIndex)) {
-        return;
-    }
-
-    // Descendre dans les enfants
-    int halfSize = size / 2;
-    int childIndex = 4 * nodeIndex + 1;
+    // Les descendants d'un bloc uniforme sont uniformes : aucune bordure à tracer
+    if (isUniform(tree, nodeIndex)) return;
 
-    generateSegmentationGrid(tree, grid, width, height, childIndex, x, y, halfSize);                
-    generateSegmentationGrid(tree, grid, width, height, childIndex + 1, x + halfSize, y, halfSize);
-    generateSegmentationGrid(tree, grid, width, height, childIndex + 2, x + halfSize, y + halfSize, halfSize);
-    generateSegmentationGrid(tree, grid, width, height, childIndex + 3, x, y + halfSize, halfSize);
+    drawSegmentOutline(grid, width, height, x, y, size);
+    if (!isLeaf(tree, nodeIndex)) drawInnerSegments(tree, grid, width, height, nodeIndex, x, y, size);
 }
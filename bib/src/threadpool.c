@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "threadpool.h"
+
+
+/**
+ * @brief Tâche en attente d'exécution.
+ */
+typedef struct {
+    TaskFunc func;
+    void* arg;
+} Task;
+
+
+/**
+ * @brief File de tâches d'un thread (double entrée, tableau circulaire extensible).
+ * 
+ * Le propriétaire empile et dépile par la fin, les voleurs prennent par le début.
+ */
+typedef struct {
+    Task* tasks;
+    int capacity;
+    int head;       // index de la tâche la plus ancienne
+    int count;      // nombre de tâches dans la file
+    pthread_mutex_t lock;
+} WorkQueue;
+
+
+struct ThreadPool {
+    int nbThreads;
+    pthread_t* threads;
+    WorkQueue* queues;
+    int nextQueue;          // file suivante pour les soumissions externes
+
+    pthread_mutex_t lock;   // protège les compteurs ci-dessous
+    pthread_cond_t workAvailable;
+    pthread_cond_t allDone;
+    int queued;             // tâches présentes dans les files
+    int pending;            // tâches soumises et non terminées
+    int stop;
+};
+
+
+/**
+ * @brief Contexte d'un thread de travail.
+ */
+typedef struct {
+    ThreadPool* pool;
+    int id;
+} WorkerContext;
+
+// Pool et index du thread courant (-1 hors du pool)
+static __thread ThreadPool* currentPool = NULL;
+static __thread int currentWorker = -1;
+
+
+/**
+ * @brief Ajoute une tâche à la fin d'une file.
+ * 
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+static int pushTask(WorkQueue* queue, Task task) {
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count == queue->capacity) {
+        int newCapacity = queue->capacity ? 2 * queue->capacity : 64;
+        Task* tasks = (Task*)malloc(newCapacity * sizeof(Task));
+        if (!tasks) {
+            pthread_mutex_unlock(&queue->lock);
+            perror("Erreur lors de l'allocation de la file de tâches");
+            return -1;
+        }
+        for (int i = 0; i < queue->count; i++) {
+            tasks[i] = queue->tasks[(queue->head + i) % queue->capacity];
+        }
+        free(queue->tasks);
+        queue->tasks = tasks;
+        queue->capacity = newCapacity;
+        queue->head = 0;
+    }
+    queue->tasks[(queue->head + queue->count) % queue->capacity] = task;
+    queue->count++;
+    pthread_mutex_unlock(&queue->lock);
+    return 0;
+}
+
+
+/**
+ * @brief Retire une tâche d'une file : par la fin (propriétaire) ou par le début (vol).
+ * 
+ * @return 1 si une tâche a été retirée, 0 si la file est vide.
+ */
+static int takeTask(WorkQueue* queue, Task* task, int steal) {
+    int found = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count > 0) {
+        if (steal) {
+            *task = queue->tasks[queue->head];
+            queue->head = (queue->head + 1) % queue->capacity;
+        } else {
+            *task = queue->tasks[(queue->head + queue->count - 1) % queue->capacity];
+        }
+        queue->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+
+/**
+ * @brief Cherche une tâche : d'abord dans la file du thread, puis chez les autres.
+ * 
+ * @return 1 si une tâche a été trouvée, 0 sinon.
+ */
+static int findTask(ThreadPool* pool, int id, Task* task) {
+    if (takeTask(&pool->queues[id], task, 0)) return 1;
+
+    for (int i = 1; i < pool->nbThreads; i++) {
+        if (takeTask(&pool->queues[(id + i) % pool->nbThreads], task, 1)) return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Boucle d'un thread de travail.
+ */
+static void* workerLoop(void* arg) {
+    WorkerContext* ctx = (WorkerContext*)arg;
+    ThreadPool* pool = ctx->pool;
+    int id = ctx->id;
+    free(ctx);
+
+    currentPool = pool;
+    currentWorker = id;
+
+    for (;;) {
+        Task task;
+        if (findTask(pool, id, &task)) {
+            pthread_mutex_lock(&pool->lock);
+            pool->queued--;
+            pthread_mutex_unlock(&pool->lock);
+
+            task.func(task.arg);
+
+            pthread_mutex_lock(&pool->lock);
+            if (--pool->pending == 0) pthread_cond_broadcast(&pool->allDone);
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+
+        // Rien à faire : dormir jusqu'à la prochaine soumission
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stop && pool->queued == 0) {
+            pthread_cond_wait(&pool->workAvailable, &pool->lock);
+        }
+        int stop = pool->stop && pool->queued == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (stop) break;
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Arrête les threads démarrés et libère le pool.
+ * 
+ * @param pool Pointeur vers le pool.
+ * @param started Nombre de threads effectivement démarrés.
+ */
+static void destroyThreadPool(ThreadPool* pool, int started) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pool->nbThreads; i++) {
+        free(pool->queues[i].tasks);
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    }
+    pthread_cond_destroy(&pool->allDone);
+    pthread_cond_destroy(&pool->workAvailable);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool->queues);
+    free(pool);
+}
+
+
+/**
+ * Crée un pool de threads.
+ * 
+ * @param nbThreads Nombre de threads de travail (au moins 1).
+ * @return Pointeur vers le pool, ou NULL en cas d'erreur.
+ */
+ThreadPool* createThreadPool(int nbThreads) {
+    if (nbThreads < 1) nbThreads = 1;
+
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        perror("Erreur lors de l'allocation du pool de threads");
+        return NULL;
+    }
+    pool->threads = (pthread_t*)calloc(nbThreads, sizeof(pthread_t));
+    pool->queues = (WorkQueue*)calloc(nbThreads, sizeof(WorkQueue));
+    if (!pool->threads || !pool->queues) {
+        perror("Erreur lors de l'allocation du pool de threads");
+        free(pool->threads);
+        free(pool->queues);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workAvailable, NULL);
+    pthread_cond_init(&pool->allDone, NULL);
+    for (int i = 0; i < nbThreads; i++) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+
+    pool->nbThreads = nbThreads;
+    for (int i = 0; i < nbThreads; i++) {
+        WorkerContext* ctx = (WorkerContext*)malloc(sizeof(WorkerContext));
+        if (ctx) {
+            ctx->pool = pool;
+            ctx->id = i;
+        }
+        if (!ctx || pthread_create(&pool->threads[i], NULL, workerLoop, ctx) != 0) {
+            fprintf(stderr, "Erreur : Impossible de créer le thread %d\n", i);
+            free(ctx);
+            destroyThreadPool(pool, i);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+
+/**
+ * Renvoie le nombre de threads de travail d'un pool.
+ * 
+ * @param pool Pointeur vers le pool.
+ * @return Le nombre de threads.
+ */
+int threadPoolSize(const ThreadPool* pool) {
+    return pool ? pool->nbThreads : 1;
+}
+
+
+/**
+ * Soumet une tâche au pool.
+ * 
+ * @param pool Pointeur vers le pool.
+ * @param func Fonction à exécuter.
+ * @param arg Argument passé à la fonction.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation.
+ */
+int submitTask(ThreadPool* pool, TaskFunc func, void* arg) {
+    Task task = { func, arg };
+    int target;
+
+    if (currentPool == pool && currentWorker >= 0) {
+        target = currentWorker;
+    } else {
+        pthread_mutex_lock(&pool->lock);
+        target = pool->nextQueue;
+        pool->nextQueue = (pool->nextQueue + 1) % pool->nbThreads;
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    // Compter la tâche avant de la rendre visible aux autres threads
+    pthread_mutex_lock(&pool->lock);
+    pool->pending++;
+    pool->queued++;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (pushTask(&pool->queues[target], task) != 0) {
+        pthread_mutex_lock(&pool->lock);
+        pool->queued--;
+        if (--pool->pending == 0) pthread_cond_broadcast(&pool->allDone);
+        pthread_mutex_unlock(&pool->lock);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+
+/**
+ * Attend la fin de toutes les tâches soumises au pool.
+ * 
+ * @param pool Pointeur vers le pool.
+ */
+void waitThreadPool(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->allDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+/**
+ * Arrête les threads et libère le pool (les tâches en attente sont d'abord exécutées).
+ * 
+ * @param pool Pointeur vers le pool à libérer.
+ */
+void freeThreadPool(ThreadPool* pool) {
+    if (!pool) return;
+    destroyThreadPool(pool, pool->nbThreads);
+}
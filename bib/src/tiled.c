@@ -0,0 +1,616 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "tiled.h"
+#include "codage.h"
+#include "decodage.h"
+#include "filtrage.h"
+#include "segmentation.h"
+#include "bitstream.h"
+
+
+/**
+ * @brief Passes du codage tuilé sur l'image.
+ */
+enum {
+    PASS_STATS,     // variances (codage avec perte)
+    PASS_FILTER,    // filtrage des tuiles (codage avec perte)
+    PASS_ENCODE     // codage et écriture des tuiles
+};
+
+
+struct TileTask;
+
+
+/**
+ * @brief État d'un codage tuilé.
+ */
+typedef struct {
+    const MappedFile* input;
+    const uint8_t* pixels;
+    int width;              // dimensions de l'image (largeur des lignes de pixels)
+    int height;
+    int cols;               // tuiles qui touchent l'image, par ligne et par colonne
+    int rows;
+    int tileDepth;
+    int topDepth;           // profondeur des niveaux supérieurs (racines des tuiles)
+    double alpha;           // <= 0 : sans perte
+    double tileSigma;       // seuil de filtrage au niveau des tuiles
+    QuadTree* top;          // niveaux supérieurs (arbre complet)
+    uint8_t* results;       // résultats du filtrage des tuiles (par position dans le niveau)
+    uint8_t* grid;
+    struct TileTask* tasks; // une tâche par tuile d'une bande
+    int pass;
+
+    FILE* file;
+    uint64_t* offsets;      // positions des sous-flux des tuiles
+    uint64_t position;      // octets de sous-flux écrits
+    double sumVar;
+    double maxVar;
+    TiledStats* stats;
+} TiledEncoder;
+
+
+/**
+ * @brief Traitement d'une tuile lors d'une passe.
+ */
+typedef struct TileTask {
+    const TiledEncoder* encoder;
+    int tx;
+    int ty;
+    uint8_t m;              // racine de la tuile, après filtrage
+    uint8_t epsilon;
+    uint8_t uniform;
+    uint8_t filtered;       // résultat du filtrage de la racine
+    BlockMoments moments;   // sommes des pixels de la tuile
+    double sumVar;          // somme et maximum des variances de la tuile
+    double maxVar;
+    int codedNodes;
+    BitWriter bits;         // sous-flux de la tuile
+    int status;
+} TileTask;
+
+
+/**
+ * @brief Vérifie si une tuile est couverte par un bloc uniforme des niveaux supérieurs.
+ *
+ * @param encoder État du codage (niveaux supérieurs filtrés).
+ * @param leaf Index de la racine de la tuile dans les niveaux supérieurs.
+ * @return 1 si un ancêtre de la tuile est uniforme, 0 sinon.
+ */
+static int coveredTile(const TiledEncoder* encoder, int leaf) {
+    for (int parent = getParentIndex(leaf); parent >= 0; parent = getParentIndex(parent)) {
+        if (isUniform(encoder->top, parent)) return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Construit l'arbre d'une tuile et le traite selon la passe en cours.
+ *
+ * Le résultat est rangé dans la tâche : les niveaux supérieurs ne sont modifiés
+ * que par le thread appelant (voir collectTile). Une tuile qui déborde de l'image
+ * est un arbre restreint à sa partie dans l'image (voir setImageSize).
+ *
+ * @param arg Pointeur vers une TileTask.
+ */
+static void tileTask(void* arg) {
+    TileTask* task = (TileTask*)arg;
+    const TiledEncoder* encoder = task->encoder;
+    int size = 1 << encoder->tileDepth;
+    int lossy = encoder->alpha > 0;
+
+    int x = task->tx * size, y = task->ty * size;
+    int width = encoder->width - x < size ? encoder->width - x : size;
+    int height = encoder->height - y < size ? encoder->height - y : size;
+
+    // Le sous-arbre est construit en place, à partir du coin haut-gauche de la tuile
+    size_t origin = (size_t)y * encoder->width + x;
+    QuadTree* tree = createQuadTreeOverImage(encoder->tileDepth, encoder->pixels + origin, encoder->width);
+    if (!tree || setImageSize(tree, width, height) != 0 || (lossy && allocVariance(tree, 0) != 0)) {
+        freeQuadTree(tree);
+        task->status = -1;
+        return;
+    }
+
+    fillQuadTree(tree, (uint8_t*)encoder->pixels + origin, encoder->width, size, encoder->tileDepth, 0, 0, 0, size);
+
+    if (encoder->pass == PASS_STATS) {
+        sumAndMaxVars(tree, &task->sumVar, &task->maxVar);
+        task->moments = getNodeMoments(tree, 0);
+    } else if (lossy) {
+        task->filtered = (uint8_t)filtrage(tree, 0, encoder->tileSigma, encoder->alpha);
+    }
+
+    task->m = getNodeM(tree, 0);
+    task->epsilon = getNodeEpsilon(tree, 0);
+    task->uniform = isUniform(tree, 0);
+
+    // Sous-flux vide pour une tuile uniforme ou couverte par un bloc uniforme
+    int leaf = levelStart(encoder->topDepth) + blockOffset(task->tx, task->ty);
+    if (encoder->pass == PASS_ENCODE && !task->uniform && !(lossy && coveredTile(encoder, leaf))) {
+        if (pruneQuadTree(tree) != 0) {
+            task->status = -1;
+        } else {
+            encoderQuadTreeNodes(tree, 1, tree->totalNodes, tree->levelFirst[tree->depth], &task->bits);
+            flushBitWriter(&task->bits);
+            if (task->bits.error) task->status = -1;
+            task->codedNodes = tree->totalNodes - 1;
+
+            if (encoder->grid) {
+                generateSegmentationGrid(tree, encoder->grid, encoder->width, encoder->height, 0, x, y, size);
+            }
+        }
+    }
+    freeQuadTree(tree);
+}
+
+
+/**
+ * @brief Récupère le résultat d'une tuile, dans l'ordre des tuiles de la bande.
+ *
+ * @param encoder État du codage.
+ * @param task Tâche terminée.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int collectTile(TiledEncoder* encoder, TileTask* task) {
+    int status = task->status;
+    int offset = blockOffset(task->tx, task->ty);
+    int leaf = levelStart(encoder->topDepth) + offset;
+    QuadTree* top = encoder->top;
+
+    setNodeM(top, leaf, task->m);
+    setNodeEpsilon(top, leaf, task->epsilon);
+    setUniform(top, leaf, task->uniform);
+
+    if (encoder->pass == PASS_STATS) {
+        setNodeMoments(top, leaf, task->moments);
+        encoder->sumVar += task->sumVar;
+        if (task->maxVar > encoder->maxVar) encoder->maxVar = task->maxVar;
+    } else if (encoder->pass == PASS_FILTER) {
+        encoder->results[offset] = task->filtered;
+    } else if (status == 0) {
+        uint64_t index = (uint64_t)task->ty * encoder->cols + task->tx;
+        size_t bytes = task->bits.size;
+        encoder->offsets[index] = encoder->position;
+        if (bytes > 0 && fwrite(task->bits.data, 1, bytes, encoder->file) != bytes) status = -1;
+        encoder->position += bytes;
+        encoder->stats->codedTiles += bytes > 0;
+        encoder->stats->codedNodes += task->codedNodes;
+    }
+
+    freeBitWriter(&task->bits);
+    return status;
+}
+
+
+/**
+ * @brief Parcourt l'image par bandes d'une tuile de haut pour une passe.
+ *
+ * Les tuiles d'une bande sont traitées en parallèle ; la bande suivante est lue
+ * en avance et les pages de la bande traitée sont libérées. Les tuiles hors de
+ * l'image ne sont pas visitées.
+ *
+ * @param encoder État du codage.
+ * @param pass Passe à effectuer.
+ * @param pool Pool de threads (NULL pour un traitement séquentiel).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int runPass(TiledEncoder* encoder, int pass, ThreadPool* pool) {
+    size_t bandBytes = ((size_t)encoder->width) << encoder->tileDepth;
+    size_t base = encoder->pixels - encoder->input->data;
+    int status = 0;
+
+    encoder->pass = pass;
+    for (int ty = 0; ty < encoder->rows && status == 0; ty++) {
+        if (ty + 1 < encoder->rows) prefetchMappedRange(encoder->input, base + (ty + 1) * bandBytes, bandBytes);
+
+        for (int tx = 0; tx < encoder->cols; tx++) {
+            TileTask* task = &encoder->tasks[tx];
+            memset(task, 0, sizeof(*task));
+            task->encoder = encoder;
+            task->tx = tx;
+            task->ty = ty;
+            initBitWriter(&task->bits);
+            if (!pool || submitTask(pool, tileTask, task) != 0) tileTask(task);
+        }
+        if (pool) waitThreadPool(pool);
+
+        for (int tx = 0; tx < encoder->cols; tx++) {
+            if (collectTile(encoder, &encoder->tasks[tx]) != 0) status = -1;
+        }
+        releaseMappedRange(encoder->input, base + ty * bandBytes, bandBytes);
+    }
+    return status;
+}
+
+
+/**
+ * @brief Calcule le seuil de filtrage des niveaux supérieurs et des tuiles (codage avec perte).
+ *
+ * Les variances des tuiles ont été cumulées par la passe PASS_STATS ; celles des
+ * niveaux supérieurs (hors racines des tuiles, déjà comptées) leur sont ajoutées.
+ * La moyenne porte sur les nœuds internes de l'image, comme dans avgAndMaxVars.
+ *
+ * @param encoder État du codage (niveaux supérieurs remplis).
+ * @param depth Profondeur de l'image.
+ * @return Le seuil de filtrage à la racine.
+ */
+static double tiledSigma(TiledEncoder* encoder, int depth) {
+    double sumVar, maxVar;
+    sumAndMaxVars(encoder->top, &sumVar, &maxVar);
+    encoder->sumVar += sumVar;
+    if (maxVar > encoder->maxVar) encoder->maxVar = maxVar;
+
+    // Nœuds internes qui touchent l'image, niveau par niveau
+    double internalNodes = 0;
+    for (int level = 0; level < depth; level++) {
+        internalNodes += (double)coveringBlocks(encoder->width, depth - level) * coveringBlocks(encoder->height, depth - level);
+    }
+    double medvar = encoder->sumVar / internalNodes;
+    return medvar / encoder->maxVar;
+}
+
+
+/**
+ * @brief Écrit le flux des niveaux supérieurs, l'index des tuiles et la position du flux.
+ *
+ * @param encoder État du codage (niveaux supérieurs élagués).
+ * @param nbTiles Nombre de tuiles.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int writeTrailer(TiledEncoder* encoder, uint64_t nbTiles) {
+    BitWriter stream;
+    initBitWriter(&stream);
+    encoderQuadTreeNodes(encoder->top, 0, encoder->top->totalNodes, INT_MAX, &stream);
+    size_t bytes = flushBitWriter(&stream);
+    int status = stream.error ? -1 : 0;
+
+    uint64_t topOffset = encoder->position;
+    if (status == 0 && bytes > 0 && fwrite(stream.data, 1, bytes, encoder->file) != bytes) status = -1;
+    freeBitWriter(&stream);
+
+    uint8_t entry[8];
+    for (uint64_t t = 0; t < nbTiles && status == 0; t++) {
+        putUint64(entry, encoder->offsets[t]);
+        if (fwrite(entry, 1, sizeof(entry), encoder->file) != sizeof(entry)) status = -1;
+    }
+    putUint64(entry, topOffset);
+    if (status == 0 && fwrite(entry, 1, sizeof(entry), encoder->file) != sizeof(entry)) status = -1;
+
+    encoder->stats->codedNodes += encoder->top->totalNodes;
+    encoder->stats->indexBytes = 1 + 8 * (nbTiles + 1);
+    encoder->stats->bytes = 1 + topOffset + bytes + 8 * (nbTiles + 1);
+    return status;
+}
+
+
+/**
+ * @brief Encode une image par tuiles au format Q3, sans construire l'arbre de toute l'image.
+ *
+ * @param file Fichier de sortie, positionné après l'octet de profondeur.
+ * @param input Fichier projeté contenant l'image.
+ * @param pixels Pixels de l'image dans la projection.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur de l'image (plus petit carré qui la contient).
+ * @param tileDepth Profondeur des tuiles (entre 1 et MAX_TILE_DEPTH, au plus depth).
+ * @param alpha Facteur de filtrage pour le codage avec perte (<= 0 : sans perte).
+ * @param grid Grille de segmentation à tracer (même taille que l'image), ou NULL.
+ * @param pool Pool de threads (NULL pour un codage séquentiel).
+ * @param stats Pointeur où stocker le bilan du codage.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int encoderQuadTreeTiled(FILE* file, const MappedFile* input, const uint8_t* pixels, int width, int height, int depth,
+                         int tileDepth, double alpha, uint8_t* grid, ThreadPool* pool, TiledStats* stats) {
+    if (tileDepth < 1 || tileDepth > depth || tileDepth > MAX_TILE_DEPTH) {
+        fprintf(stderr, "Erreur : Profondeur de tuile %d invalide (entre 1 et %d)\n", tileDepth,
+                depth < MAX_TILE_DEPTH ? depth : MAX_TILE_DEPTH);
+        return -1;
+    }
+
+    int topDepth = depth - tileDepth;
+    int cols = coveringBlocks(width, tileDepth);
+    int rows = coveringBlocks(height, tileDepth);
+    uint64_t nbTiles = (uint64_t)cols * rows;
+    int lossy = alpha > 0;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->tiles = nbTiles;
+
+    // Les niveaux supérieurs couvrent une image d'une tuile par pixel
+    TiledEncoder encoder = { input, pixels, width, height, cols, rows, tileDepth, topDepth, alpha, 0.0, NULL, NULL,
+                             grid, NULL, PASS_STATS, file, NULL, 0, 0.0, 0.0, stats };
+    encoder.top = createQuadTree(topDepth);
+    if (!encoder.top || setImageSize(encoder.top, cols, rows) != 0) {
+        freeQuadTree(encoder.top);
+        return -1;
+    }
+
+    encoder.tasks = (TileTask*)calloc(cols, sizeof(TileTask));
+    encoder.offsets = (uint64_t*)malloc(nbTiles * sizeof(uint64_t));
+    if (lossy) {
+        // Les positions hors de l'image restent filtrées (uniformes)
+        encoder.results = (uint8_t*)malloc((size_t)1 << (2 * topDepth));
+        if (encoder.results) memset(encoder.results, 1, (size_t)1 << (2 * topDepth));
+    }
+    if (!encoder.tasks || !encoder.offsets || (lossy && (!encoder.results || allocVariance(encoder.top, 1) != 0))) {
+        perror("Erreur lors de l'allocation du codage tuilé");
+        free(encoder.tasks);
+        free(encoder.offsets);
+        free(encoder.results);
+        freeQuadTree(encoder.top);
+        return -1;
+    }
+
+    uint8_t tileDepthByte = (uint8_t)tileDepth;
+    int status = (fwrite(&tileDepthByte, 1, 1, file) == 1) ? 0 : -1;
+
+    if (lossy && status == 0) {
+        // Variances de toute l'image, puis filtrage des tuiles et des niveaux supérieurs
+        status = runPass(&encoder, PASS_STATS, pool);
+        fillUpperLevels(encoder.top, topDepth);
+
+        double sigma = tiledSigma(&encoder, depth);
+        encoder.tileSigma = sigma;
+        for (int level = 0; level < topDepth; level++) encoder.tileSigma = encoder.tileSigma * alpha;
+
+        if (status == 0) status = runPass(&encoder, PASS_FILTER, pool);
+        filtrageTop(encoder.top, 0, 0, topDepth, sigma, alpha, encoder.results);
+    }
+
+    if (status == 0) status = runPass(&encoder, PASS_ENCODE, pool);
+    if (!lossy) fillUpperLevels(encoder.top, topDepth);
+
+    if (status == 0) status = pruneQuadTree(encoder.top);
+    if (status == 0) status = writeTrailer(&encoder, nbTiles);
+    if (status == 0 && grid) generateSegmentationGrid(encoder.top, grid, width, height, 0, 0, 0, 1 << depth);
+
+    if (status != 0) fprintf(stderr, "Erreur : Codage tuilé échoué\n");
+
+    free(encoder.tasks);
+    free(encoder.offsets);
+    free(encoder.results);
+    freeQuadTree(encoder.top);
+    return status;
+}
+
+
+/**
+ * @brief État d'un décodage tuilé.
+ */
+typedef struct {
+    const uint8_t* area;        // sous-flux des tuiles (début des positions)
+    const uint64_t* offsets;    // positions des sous-flux (nbTiles + 1 entrées)
+    const QuadTree* top;        // niveaux supérieurs
+    uint8_t* image;
+    uint8_t* grid;
+    int width;
+    int height;
+    int cols;                   // tuiles qui touchent l'image, par ligne
+    int tileDepth;
+    int topDepth;
+} TiledDecoder;
+
+
+/**
+ * @brief Décodage d'une tuile.
+ */
+typedef struct {
+    const TiledDecoder* decoder;
+    int tx;
+    int ty;
+    int codedNodes;
+    int status;
+} TileDecodeTask;
+
+
+/**
+ * @brief Décode une tuile dans son propre arbre creux et la peint dans l'image.
+ *
+ * Une tuile couverte par un bloc uniforme est remplie avec la moyenne de ce bloc.
+ * Une tuile qui déborde est rognée aux dimensions de l'image.
+ *
+ * @param arg Pointeur vers une TileDecodeTask.
+ */
+static void decodeTileTask(void* arg) {
+    TileDecodeTask* task = (TileDecodeTask*)arg;
+    const TiledDecoder* decoder = task->decoder;
+    const QuadTree* top = decoder->top;
+    int size = 1 << decoder->tileDepth;
+    int x = task->tx * size, y = task->ty * size;
+    int width = decoder->width - x < size ? decoder->width - x : size;
+    int height = decoder->height - y < size ? decoder->height - y : size;
+    uint8_t* image = decoder->image + (size_t)y * decoder->width + x;
+
+    int level;
+    int node = findNode(top, decoder->topDepth, blockOffset(task->tx, task->ty), &level);
+    if (level < decoder->topDepth || isUniform(top, node)) {
+        for (int row = 0; row < height; row++) memset(image + (size_t)row * decoder->width, getNodeM(top, node), width);
+        return;
+    }
+
+    QuadTree* tree = createSparseQuadTree(decoder->tileDepth);
+    if (tree && setImageSize(tree, width, height) != 0) {
+        freeQuadTree(tree);
+        tree = NULL;
+    }
+    if (!tree) {
+        task->status = -1;
+        return;
+    }
+    setNodeM(tree, 0, getNodeM(top, node));
+    setNodeEpsilon(tree, 0, getNodeEpsilon(top, node));
+
+    uint64_t index = (uint64_t)task->ty * decoder->cols + task->tx;
+    BitReader reader;
+    initBitReader(&reader, decoder->area + decoder->offsets[index], decoder->offsets[index + 1] - decoder->offsets[index]);
+    if (fillSubtreeFromQTC(&reader, tree) != 0 || bitReaderOverrun(&reader)) {
+        task->status = -1;
+    } else {
+        createDataFromTree(tree, decoder->image, decoder->grid, decoder->width, decoder->height, 0, x, y, size);
+        task->codedNodes = tree->totalNodes - 1;
+    }
+    freeQuadTree(tree);
+}
+
+
+/**
+ * @brief Lit l'index d'un flux Q3 et vérifie les positions des sous-flux.
+ *
+ * @param area Données qui suivent l'octet de profondeur des tuiles.
+ * @param areaSize Taille de ces données en octets.
+ * @param nbTiles Nombre de tuiles.
+ * @param topSize Pointeur où stocker la taille du flux des niveaux supérieurs.
+ * @return Les nbTiles + 1 positions (la dernière est celle du flux des niveaux
+ * supérieurs), à libérer par free, ou NULL si l'index est invalide.
+ */
+uint64_t* readTileIndex(const uint8_t* area, size_t areaSize, uint64_t nbTiles, size_t* topSize) {
+    if (areaSize < 8 || (areaSize - 8) / 8 < nbTiles) {
+        fprintf(stderr, "Erreur : Index QTC tronqué\n");
+        return NULL;
+    }
+    size_t indexPos = areaSize - 8 * (nbTiles + 1);
+    uint64_t topOffset = getUint64(area + areaSize - 8);
+    if (topOffset > indexPos) {
+        fprintf(stderr, "Erreur : Index QTC invalide\n");
+        return NULL;
+    }
+
+    uint64_t* offsets = (uint64_t*)malloc((nbTiles + 1) * sizeof(uint64_t));
+    if (!offsets) {
+        perror("Erreur lors de l'allocation de l'index");
+        return NULL;
+    }
+
+    // Les positions doivent être croissantes et précéder le flux des niveaux supérieurs
+    offsets[nbTiles] = topOffset;
+    for (uint64_t t = 0; t < nbTiles; t++) {
+        offsets[t] = getUint64(area + indexPos + 8 * t);
+        if (offsets[t] > topOffset || (t > 0 && offsets[t] < offsets[t - 1])) {
+            fprintf(stderr, "Erreur : Index QTC invalide\n");
+            free(offsets);
+            return NULL;
+        }
+    }
+
+    *topSize = indexPos - topOffset;
+    return offsets;
+}
+
+
+/**
+ * @brief Repère le flux des niveaux supérieurs d'un fichier Q3 (codé comme en Q1).
+ *
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur de l'image.
+ * @param topSize Pointeur où stocker la taille du flux en octets.
+ * @param topDepth Pointeur où stocker le niveau des racines des tuiles (dernier niveau du flux).
+ * @return Le début du flux, ou NULL si l'index est invalide.
+ */
+const uint8_t* tiledTopStream(const uint8_t* data, size_t dataSize, int width, int height, int depth,
+                              size_t* topSize, int* topDepth) {
+    if (!data || dataSize < 1) {
+        fprintf(stderr, "Erreur : Données binaires nulles\n");
+        return NULL;
+    }
+    int tileDepth = data[0];
+    if (tileDepth < 1 || tileDepth > MAX_TILE_DEPTH || depth - tileDepth < 0 || depth - tileDepth > MAX_TREE_DEPTH) {
+        fprintf(stderr, "Erreur : Profondeur de tuile %d invalide\n", tileDepth);
+        return NULL;
+    }
+    uint64_t nbTiles = (uint64_t)coveringBlocks(width, tileDepth) * coveringBlocks(height, tileDepth);
+    uint64_t* offsets = readTileIndex(data + 1, dataSize - 1, nbTiles, topSize);
+    if (!offsets) return NULL;
+
+    const uint8_t* top = data + 1 + offsets[nbTiles];
+    free(offsets);
+    *topDepth = depth - tileDepth;
+    return top;
+}
+
+
+/**
+ * @brief Décode une image au format Q3, tuile par tuile (voir encoderQuadTreeTiled).
+ *
+ * @param data Données qui suivent l'octet de profondeur.
+ * @param dataSize Taille des données en octets.
+ * @param width Largeur de l'image.
+ * @param height Hauteur de l'image.
+ * @param depth Profondeur de l'image.
+ * @param image Image à remplir.
+ * @param grid Grille de segmentation à tracer (même taille que l'image), ou NULL.
+ * @param pool Pool de threads (NULL pour un décodage séquentiel).
+ * @param stats Pointeur où stocker le bilan du décodage.
+ * @return 0 en cas de succès, -1 si les données sont invalides ou tronquées.
+ */
+int decoderQuadTreeTiled(const uint8_t* data, size_t dataSize, int width, int height, int depth, uint8_t* image,
+                         uint8_t* grid, ThreadPool* pool, TiledStats* stats) {
+    if (!data || dataSize < 1 || !image) {
+        fprintf(stderr, "Erreur : Données binaires nulles\n");
+        return -1;
+    }
+
+    int tileDepth = data[0];
+    int topDepth = depth - tileDepth;
+    if (tileDepth < 1 || tileDepth > MAX_TILE_DEPTH || topDepth < 0 || topDepth > MAX_TREE_DEPTH) {
+        fprintf(stderr, "Erreur : Profondeur de tuile %d invalide\n", tileDepth);
+        return -1;
+    }
+    int cols = coveringBlocks(width, tileDepth);
+    int rows = coveringBlocks(height, tileDepth);
+    uint64_t nbTiles = (uint64_t)cols * rows;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->tiles = nbTiles;
+    stats->bytes = dataSize;
+    stats->indexBytes = 1 + 8 * (nbTiles + 1);
+
+    const uint8_t* area = data + 1;
+    size_t topSize;
+    uint64_t* offsets = readTileIndex(area, dataSize - 1, nbTiles, &topSize);
+    if (!offsets) return -1;
+
+    // Niveaux supérieurs, ramenés ensuite à topDepth niveaux (les racines des tuiles)
+    QuadTree* top = createSparseQuadTree(depth);
+    TileDecodeTask* tasks = (TileDecodeTask*)calloc(cols, sizeof(TileDecodeTask));
+    int status = (top && tasks && setImageSize(top, width, height) == 0) ? 0 : -1;
+    if (status == 0) {
+        BitReader reader;
+        initBitReader(&reader, area + offsets[nbTiles], topSize);
+        if (fillQuadTreeLevelsFromQTC(&reader, top, topDepth) != 0 || bitReaderOverrun(&reader)) status = -1;
+        top->depth = topDepth;
+        top->width = cols;
+        top->height = rows;
+        stats->codedNodes = top->totalNodes;
+    }
+
+    TiledDecoder decoder = { area, offsets, top, image, grid, width, height, cols, tileDepth, topDepth };
+    for (int ty = 0; ty < rows && status == 0; ty++) {
+        for (int tx = 0; tx < cols; tx++) {
+            TileDecodeTask task = { &decoder, tx, ty, 0, 0 };
+            tasks[tx] = task;
+            if (!pool || submitTask(pool, decodeTileTask, &tasks[tx]) != 0) decodeTileTask(&tasks[tx]);
+        }
+        if (pool) waitThreadPool(pool);
+
+        for (int tx = 0; tx < cols; tx++) {
+            if (tasks[tx].status != 0) status = -1;
+            stats->codedTiles += tasks[tx].codedNodes > 0;
+            stats->codedNodes += tasks[tx].codedNodes;
+        }
+    }
+    if (status == 0 && grid) generateSegmentationGrid(top, grid, width, height, 0, 0, 0, 1 << depth);
+
+    if (status != 0) fprintf(stderr, "Erreur : Données QTC tronquées\n");
+
+    free(tasks);
+    free(offsets);
+    freeQuadTree(top);
+    return status;
+}